@@ -31,6 +31,8 @@ void RemoteDebugServer::at_breakpoint(__uint128_t,
 
     while (breakpoint_triggered)
     {
+        // registers can be modified by the debugger while paused
+        CPUInstance.publish_register_snapshot();
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 
@@ -0,0 +1,80 @@
+/* Heatmap.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <SysdarftMain.h>
+#include <nlohmann/json.hpp>
+
+using namespace std::literals;
+using json = nlohmann::json;
+
+void RemoteDebugServer::crow_setup_heatmap()
+{
+    CROW_ROUTE(JSONBackend, "/Heatmap").methods(crow::HTTPMethod::GET)([this](const crow::request& req)
+    {
+        json response;
+        response["Version"] = SYSDARFT_VERSION;
+        const auto timeNow = std::chrono::system_clock::now();
+        response["UNIXTimestamp"] = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+            timeNow.time_since_epoch()).count());
+
+        if (!CPUInstance.heatmap_enabled()) {
+            response["Result"] = "Heatmap is not enabled, boot with --heatmap"s;
+            return crow::response(400, response.dump());
+        }
+
+        // the hottest buckets first, /Heatmap?Top=n for more or less than 64 of them
+        uint64_t top = 64;
+        if (const char * top_param = req.url_params.get("Top"); top_param != nullptr) {
+            top = std::strtoull(top_param, nullptr, 10);
+        }
+
+        auto records = CPUInstance.heatmap_snapshot();
+        const auto accesses = [](const SysdarftHeatmapRecord & record) {
+            return record.Reads + record.Writes + record.Fetches;
+        };
+
+        top = std::min<uint64_t>(top, records.size());
+        std::partial_sort(records.begin(), records.begin() + static_cast<std::ptrdiff_t>(top), records.end(),
+            [&](const SysdarftHeatmapRecord & a, const SysdarftHeatmapRecord & b) {
+                return accesses(a) > accesses(b);
+            });
+
+        const auto granularity = CPUInstance.heatmap_granularity();
+        json buckets = json::array();
+        for (uint64_t i = 0; i < top; i++)
+        {
+            std::stringstream address;
+            address << "0x" << std::hex << std::uppercase << records[i].Bucket * granularity;
+            buckets.push_back({
+                { "Address", address.str() },
+                { "Reads", records[i].Reads },
+                { "Writes", records[i].Writes },
+                { "Fetches", records[i].Fetches },
+            });
+        }
+
+        response["Granularity"] = granularity;
+        response["AccessedBuckets"] = records.size();
+        response["Buckets"] = buckets;
+        response["Result"] = "Success"s;
+        return crow::response{response.dump()};
+    });
+}
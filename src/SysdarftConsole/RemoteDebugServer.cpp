@@ -67,6 +67,8 @@ RemoteDebugServer::RemoteDebugServer(
     crow_setup_watcher();
     crow_setup_disassemble_an_area();
     crow_setup_pull_data();
+    crow_setup_shared_memory();
+    crow_setup_heatmap();
 
     server_thread = std::thread ([this](
         // DO NOT capture the current context, since it will cause `stack-use-after-return`
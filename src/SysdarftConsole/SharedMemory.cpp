@@ -0,0 +1,44 @@
+/* SharedMemory.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <SysdarftMain.h>
+#include <nlohmann/json.hpp>
+
+using namespace std::literals;
+using json = nlohmann::json;
+
+void RemoteDebugServer::crow_setup_shared_memory()
+{
+    CROW_ROUTE(JSONBackend, "/SharedMemory").methods(crow::HTTPMethod::GET)([this]()
+    {
+        json response;
+        response["Version"] = SYSDARFT_VERSION;
+        const auto timeNow = std::chrono::system_clock::now();
+        response["UNIXTimestamp"] = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+            timeNow.time_since_epoch()).count());
+
+        // map it read only, byte n is guest physical address n
+        const auto path = CPUInstance.shared_memory_path();
+        response["Path"] = path;
+        response["Size"] = path.empty() ? 0 : CPUInstance.SystemTotalMemory();
+        response["Result"] = path.empty() ? "Guest memory is not shared, boot with --share-memory"s : path;
+        return crow::response{response.dump()};
+    });
+}
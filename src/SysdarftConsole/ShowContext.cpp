@@ -134,24 +134,7 @@ std::string current_instruction(const uint8_t opcode, const SysdarftCPU::WidthAn
     // SHOW CURRENT INSTRUCTION PENDING TO BE EXECUTED
     ////////////////////////////////////////////////////////////////////////////////
 
-    for (auto [fst, snd] : instruction_map) {
-        if (snd.at(ENTRY_OPCODE) == opcode) {
-            ss << fst << " ";
-        }
-    }
-
-    switch (Arg.first) {
-    case _8bit_prefix:  ss << ".8bit "; break;
-    case _16bit_prefix: ss << ".16bit"; break;
-    case _32bit_prefix: ss << ".32bit"; break;
-    case _64bit_prefix: ss << ".64bit"; break;
-    default: ; // fall through
-    }
-
-    int first = 0;
-    for (const auto& op : Arg.second) {
-        ss << " " << op.get_literal() << (first++ == 0 && Arg.second.size() > 1 ? "," : "");
-    }
+    ss << SysdarftCPU::get_instruction_literal(opcode, Arg.first, Arg.second);
 
     return ss.str();
 }
@@ -162,6 +145,7 @@ std::string show_context(SysdarftCPU &CPUInstance,
     const SysdarftCPU::WidthAndOperandsType &)
 {
     std::stringstream ss;
+    const auto Registers = CPUInstance.register_snapshot();
 
     ////////////////////////////////////////////////////////////////////////////////
     // SHOW ALL REGISTERS
@@ -171,14 +155,14 @@ std::string show_context(SysdarftCPU &CPUInstance,
     ss << "Registers:\n";
     // --- 8x 8-bit "RegisterType" registers (R0..R7) ---
     {
-        auto R0 = CPUInstance.load<RegisterType, 0>();
-        auto R1 = CPUInstance.load<RegisterType, 1>();
-        auto R2 = CPUInstance.load<RegisterType, 2>();
-        auto R3 = CPUInstance.load<RegisterType, 3>();
-        auto R4 = CPUInstance.load<RegisterType, 4>();
-        auto R5 = CPUInstance.load<RegisterType, 5>();
-        auto R6 = CPUInstance.load<RegisterType, 6>();
-        auto R7 = CPUInstance.load<RegisterType, 7>();
+        auto R0 = Registers.load<RegisterType, 0>();
+        auto R1 = Registers.load<RegisterType, 1>();
+        auto R2 = Registers.load<RegisterType, 2>();
+        auto R3 = Registers.load<RegisterType, 3>();
+        auto R4 = Registers.load<RegisterType, 4>();
+        auto R5 = Registers.load<RegisterType, 5>();
+        auto R6 = Registers.load<RegisterType, 6>();
+        auto R7 = Registers.load<RegisterType, 7>();
 
         ss << "R0 = 0x" + to_hex_string(R0) + " ";
         ss << "R1 = 0x" + to_hex_string(R1) + " ";
@@ -192,14 +176,14 @@ std::string show_context(SysdarftCPU &CPUInstance,
 
     // --- 8x 16-bit "ExtendedRegisterType" registers (EXR0..EXR7) ---
     {
-        auto EXR0 = CPUInstance.load<ExtendedRegisterType, 0>();
-        auto EXR1 = CPUInstance.load<ExtendedRegisterType, 1>();
-        auto EXR2 = CPUInstance.load<ExtendedRegisterType, 2>();
-        auto EXR3 = CPUInstance.load<ExtendedRegisterType, 3>();
-        auto EXR4 = CPUInstance.load<ExtendedRegisterType, 4>();
-        auto EXR5 = CPUInstance.load<ExtendedRegisterType, 5>();
-        auto EXR6 = CPUInstance.load<ExtendedRegisterType, 6>();
-        auto EXR7 = CPUInstance.load<ExtendedRegisterType, 7>();
+        auto EXR0 = Registers.load<ExtendedRegisterType, 0>();
+        auto EXR1 = Registers.load<ExtendedRegisterType, 1>();
+        auto EXR2 = Registers.load<ExtendedRegisterType, 2>();
+        auto EXR3 = Registers.load<ExtendedRegisterType, 3>();
+        auto EXR4 = Registers.load<ExtendedRegisterType, 4>();
+        auto EXR5 = Registers.load<ExtendedRegisterType, 5>();
+        auto EXR6 = Registers.load<ExtendedRegisterType, 6>();
+        auto EXR7 = Registers.load<ExtendedRegisterType, 7>();
 
         ss << "EXR0 = 0x" + to_hex_string(EXR0) + " ";
         ss << "EXR1 = 0x" + to_hex_string(EXR1) + " ";
@@ -213,14 +197,14 @@ std::string show_context(SysdarftCPU &CPUInstance,
 
     // --- 8x 32-bit "HalfExtendedRegisterType" registers (HER0..HER7) ---
     {
-        auto HER0 = CPUInstance.load<HalfExtendedRegisterType, 0>();
-        auto HER1 = CPUInstance.load<HalfExtendedRegisterType, 1>();
-        auto HER2 = CPUInstance.load<HalfExtendedRegisterType, 2>();
-        auto HER3 = CPUInstance.load<HalfExtendedRegisterType, 3>();
-        auto HER4 = CPUInstance.load<HalfExtendedRegisterType, 4>();
-        auto HER5 = CPUInstance.load<HalfExtendedRegisterType, 5>();
-        auto HER6 = CPUInstance.load<HalfExtendedRegisterType, 6>();
-        auto HER7 = CPUInstance.load<HalfExtendedRegisterType, 7>();
+        auto HER0 = Registers.load<HalfExtendedRegisterType, 0>();
+        auto HER1 = Registers.load<HalfExtendedRegisterType, 1>();
+        auto HER2 = Registers.load<HalfExtendedRegisterType, 2>();
+        auto HER3 = Registers.load<HalfExtendedRegisterType, 3>();
+        auto HER4 = Registers.load<HalfExtendedRegisterType, 4>();
+        auto HER5 = Registers.load<HalfExtendedRegisterType, 5>();
+        auto HER6 = Registers.load<HalfExtendedRegisterType, 6>();
+        auto HER7 = Registers.load<HalfExtendedRegisterType, 7>();
 
         ss << "HER0 = 0x" + to_hex_string(HER0) + " ";
         ss << "HER1 = 0x" + to_hex_string(HER1) + " ";
@@ -234,22 +218,22 @@ std::string show_context(SysdarftCPU &CPUInstance,
 
     // --- 16x 64-bit "FullyExtendedRegisterType" registers (FER0..FER15) ---
     {
-        auto FER0  = CPUInstance.load<FullyExtendedRegisterType, 0>();
-        auto FER1  = CPUInstance.load<FullyExtendedRegisterType, 1>();
-        auto FER2  = CPUInstance.load<FullyExtendedRegisterType, 2>();
-        auto FER3  = CPUInstance.load<FullyExtendedRegisterType, 3>();
-        auto FER4  = CPUInstance.load<FullyExtendedRegisterType, 4>();
-        auto FER5  = CPUInstance.load<FullyExtendedRegisterType, 5>();
-        auto FER6  = CPUInstance.load<FullyExtendedRegisterType, 6>();
-        auto FER7  = CPUInstance.load<FullyExtendedRegisterType, 7>();
-        auto FER8  = CPUInstance.load<FullyExtendedRegisterType, 8>();
-        auto FER9  = CPUInstance.load<FullyExtendedRegisterType, 9>();
-        auto FER10 = CPUInstance.load<FullyExtendedRegisterType, 10>();
-        auto FER11 = CPUInstance.load<FullyExtendedRegisterType, 11>();
-        auto FER12 = CPUInstance.load<FullyExtendedRegisterType, 12>();
-        auto FER13 = CPUInstance.load<FullyExtendedRegisterType, 13>();
-        auto FER14 = CPUInstance.load<FullyExtendedRegisterType, 14>();
-        auto FER15 = CPUInstance.load<FullyExtendedRegisterType, 15>();
+        auto FER0  = Registers.load<FullyExtendedRegisterType, 0>();
+        auto FER1  = Registers.load<FullyExtendedRegisterType, 1>();
+        auto FER2  = Registers.load<FullyExtendedRegisterType, 2>();
+        auto FER3  = Registers.load<FullyExtendedRegisterType, 3>();
+        auto FER4  = Registers.load<FullyExtendedRegisterType, 4>();
+        auto FER5  = Registers.load<FullyExtendedRegisterType, 5>();
+        auto FER6  = Registers.load<FullyExtendedRegisterType, 6>();
+        auto FER7  = Registers.load<FullyExtendedRegisterType, 7>();
+        auto FER8  = Registers.load<FullyExtendedRegisterType, 8>();
+        auto FER9  = Registers.load<FullyExtendedRegisterType, 9>();
+        auto FER10 = Registers.load<FullyExtendedRegisterType, 10>();
+        auto FER11 = Registers.load<FullyExtendedRegisterType, 11>();
+        auto FER12 = Registers.load<FullyExtendedRegisterType, 12>();
+        auto FER13 = Registers.load<FullyExtendedRegisterType, 13>();
+        auto FER14 = Registers.load<FullyExtendedRegisterType, 14>();
+        auto FER15 = Registers.load<FullyExtendedRegisterType, 15>();
 
         ss << "FER0  = 0x" + to_hex_string(FER0)  + "\n";
         ss << "FER1  = 0x" + to_hex_string(FER1)  + "\n";
@@ -271,7 +255,7 @@ std::string show_context(SysdarftCPU &CPUInstance,
 
     // --- Flag Register (bitfield) ---
     {
-        auto flags = CPUInstance.load<FlagRegisterType>();
+        auto flags = Registers.load<FlagRegisterType>();
         ss << "Flags:\n";
         ss << "  Carry            = " + std::to_string((int)flags.Carry) + "\n";
         ss << "  Overflow         = " + std::to_string((int)flags.Overflow) + "\n";
@@ -279,21 +263,24 @@ std::string show_context(SysdarftCPU &CPUInstance,
         ss << "  LessThan         = " + std::to_string((int)flags.LessThan) + "\n";
         ss << "  Equal            = " + std::to_string((int)flags.Equal) + "\n";
         ss << "  InterruptionMask = " + std::to_string((int)flags.InterruptionMask) + "\n";
+        ss << "  PrivilegeLevel   = " + std::to_string((int)flags.CurrentPrivilegeLevel) + "\n";
+        ss << "  ProtectedMode    = " + std::to_string((int)flags.ProtectedModeEnabled) + "\n";
+        ss << "  Paging           = " + std::to_string((int)flags.PagingEnabled) + "\n";
     }
 
     // --- 64-bit registers: StackBase, StackPointer, CodeBase, InstructionPointer,
     //     DataBase, DataPointer, ExtendedBase, ExtendedPointer,
     //     CurrentProcedureStackPreservationSpace ---
     {
-        auto sb  = CPUInstance.load<StackBaseType>();
-        auto sp  = CPUInstance.load<StackPointerType>();
-        auto cb  = CPUInstance.load<CodeBaseType>();
+        auto sb  = Registers.load<StackBaseType>();
+        auto sp  = Registers.load<StackPointerType>();
+        auto cb  = Registers.load<CodeBaseType>();
         auto rip = actual_ip;
-        auto db  = CPUInstance.load<DataBaseType>();
-        auto dp  = CPUInstance.load<DataPointerType>();
-        auto eb  = CPUInstance.load<ExtendedBaseType>();
-        auto ep  = CPUInstance.load<ExtendedPointerType>();
-        auto cps = CPUInstance.load<CurrentProcedureStackPreservationSpaceType>();
+        auto db  = Registers.load<DataBaseType>();
+        auto dp  = Registers.load<DataPointerType>();
+        auto eb  = Registers.load<ExtendedBaseType>();
+        auto ep  = Registers.load<ExtendedPointerType>();
+        auto cps = Registers.load<CurrentProcedureStackPreservationSpaceType>();
 
         ss << "SB  = 0x" + to_hex_string(sb)  + "\n";
         ss << "SP  = 0x" + to_hex_string(sp)  + "\n";
@@ -306,6 +293,32 @@ std::string show_context(SysdarftCPU &CPUInstance,
         ss << "CPS = 0x" + to_hex_string(cps) + "\n";
     }
 
+    // --- Guest memory ---
+    ss << "Memory: " << std::dec << CPUInstance.SystemTotalMemory() / 1024 / 1024 << " MB configured, "
+       << CPUInstance.resident_memory() / 1024 / 1024 << " MB resident, "
+       << SysdarftCPUMemoryAccess::page_backing_name(CPUInstance.page_backing()) << " pages\n";
+
+    // --- Paging ---
+    ss << "Page table: 0x" + to_hex_string(Registers.load<BaseSelector>()) + ", "
+       << std::dec << Registers.load<BaseSelectorSize>() << " entries\n";
+    ss << "TLB: " << std::dec << CPUInstance.TLBHits << " hits, "
+       << CPUInstance.TLBMisses << " misses, "
+       << CPUInstance.TLBFlushes << " flushes\n";
+
+    // --- Decoded instruction cache ---
+    ss << "Decoded instruction cache: "
+       << (CPUInstance.DecodedInstructionCacheEnabled ? "enabled, " : "disabled, ")
+       << std::dec << CPUInstance.DecodedInstructionCacheHits << " hits, "
+       << CPUInstance.DecodedInstructionCacheMisses << " misses, "
+       << CPUInstance.FusedInstructions << " fused instruction pairs\n";
+
+    // --- Basic block translator ---
+    if (CPUInstance.ExecutionEngine == SysdarftCPU::ExecutionEngineType::JIT) {
+        ss << "JIT: " << CPUInstance.JITBlocksTranslated << " blocks translated, "
+           << CPUInstance.JITBlocksInvalidated << " invalidated, "
+           << CPUInstance.JITInterpretedInstructions << " instructions interpreted\n";
+    }
+
     ////////////////////////////////////////////////////////////////////////////////
     // SHOW DB:DP (128 bytes)
     ////////////////////////////////////////////////////////////////////////////////
@@ -313,7 +326,7 @@ std::string show_context(SysdarftCPU &CPUInstance,
     {
         ss << "==============================================================================\n";
         ss << "[DB:DP]:\n";
-        auto data_off = CPUInstance.load<DataBaseType>() + CPUInstance.load<DataPointerType>();
+        auto data_off = Registers.load<DataBaseType>() + Registers.load<DataPointerType>();
         auto data_len = std::min(CPUInstance.SystemTotalMemory() - data_off, 128ul);
         std::vector<uint8_t> data_buffer;
         for (uint64_t i = 0; i < data_len; i++) {
@@ -333,7 +346,7 @@ std::string show_context(SysdarftCPU &CPUInstance,
     {
         ss << "==============================================================================\n";
         ss << "[EB:EP]:\n";
-        auto ext_off = CPUInstance.load<ExtendedBaseType>() + CPUInstance.load<ExtendedPointerType>();
+        auto ext_off = Registers.load<ExtendedBaseType>() + Registers.load<ExtendedPointerType>();
         auto ext_len = std::min(CPUInstance.SystemTotalMemory() - ext_off, 128ul);
         std::vector<uint8_t> ext_buffer;
         for (uint64_t i = 0; i < ext_len; i++) {
@@ -353,7 +366,7 @@ std::string show_context(SysdarftCPU &CPUInstance,
     {
         ss << "==============================================================================\n";
         ss << "[SB:SP]:\n";
-        auto stack_off = CPUInstance.load<StackBaseType>() + CPUInstance.load<StackPointerType>();
+        auto stack_off = Registers.load<StackBaseType>() + Registers.load<StackPointerType>();
         auto stack_len = std::min(CPUInstance.SystemTotalMemory() - stack_off, 128ul);
         std::vector<uint8_t> stack_buffer;
         for (uint64_t i = 0; i < stack_len; i++) {
@@ -374,7 +387,7 @@ std::string show_context(SysdarftCPU &CPUInstance,
     auto show_next_8_instructions = [&]()
     {
         std::vector<std::string> next_8_instructions;
-        const uint64_t offset = CPUInstance.load<CodeBaseType>() + actual_ip;
+        const uint64_t offset = Registers.load<CodeBaseType>() + actual_ip;
         const uint64_t length = std::min<uint64_t>(256, CPUInstance.SystemTotalMemory() - offset);
         std::vector<uint8_t> buffer_max256;
         buffer_max256.reserve(length);
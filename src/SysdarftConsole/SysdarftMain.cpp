@@ -130,19 +130,24 @@ void complicated_to_gnu(option * dest, const option_complicated * src)
 }
 
 uint64_t boot_sysdarft(
-    const uint64_t memory_size,
+    const SysdarftMemoryOptions & memory,
     const std::string & font_name,
     const std::string & bios,
     const std::string & hdd,
     const std::string & fda,
     const std::string & fdb,
+    const SysdarftDiskCachePolicy disk_cache,
     const bool debug,
     const std::string & ip,
     const uint16_t port,
     const std::string & log_path,
     const bool headless,
     const bool gui,
-    const bool cr_to_lf)
+    const bool cr_to_lf,
+    const bool decode_cache,
+    const bool fusion,
+    const SysdarftCPU::ExecutionEngineType engine,
+    const std::string & heatmap_file)
 {
     std::ifstream file(bios, std::ios::in | std::ios::binary);
     std::vector<uint8_t> bios_code;
@@ -162,7 +167,7 @@ uint64_t boot_sysdarft(
 
     file.close();
 
-    SysdarftCPU CPUInstance(memory_size, font_name, bios_code, hdd, fda, fdb);
+    SysdarftCPU CPUInstance(memory, font_name, bios_code, hdd, fda, fdb, disk_cache);
 
     std::unique_ptr < RemoteDebugServer > debug_server;
 
@@ -172,12 +177,19 @@ uint64_t boot_sysdarft(
         }
 
         CPUInstance.translate_cr_to_lf = cr_to_lf;
+        CPUInstance.DecodedInstructionCacheEnabled = decode_cache;
+        CPUInstance.MacroOpFusionEnabled = fusion;
+        CPUInstance.ExecutionEngine = engine;
 
         ret = CPUInstance.Boot(headless, gui);
     } catch (...) {
         throw;
     }
 
+    if (!heatmap_file.empty()) {
+        CPUInstance.write_heatmap(heatmap_file);
+    }
+
     return ret;
 }
 
@@ -351,10 +363,39 @@ int main(int argc, char** argv)
 
             const std::string bios_path = parsed_options["bios"][0];
 
-            uint64_t memory_size = 32 * 1024 * 1024;
+            SysdarftMemoryOptions memory;
             if (parsed_options.contains("memory")) {
-                memory_size = std::strtoll(parsed_options["memory"].at(0).c_str(), nullptr, 10);
-                memory_size *= 1024 * 1024; // 1MB
+                memory.Size = std::strtoll(parsed_options["memory"].at(0).c_str(), nullptr, 10);
+                memory.Size *= 1024 * 1024; // 1MB
+            }
+
+            memory.HugePages = parsed_options.contains("hugepages");
+            memory.Shared = parsed_options.contains("share-memory");
+            if (parsed_options.contains("memory-file")) {
+                memory.File = parsed_options["memory-file"].at(0);
+            }
+
+            if (parsed_options.contains("heatmap"))
+            {
+                if (const auto granularity = parsed_options["heatmap"].at(0); granularity == "page") {
+                    memory.HeatmapGranularity = HEATMAP_PAGE_GRANULARITY;
+                } else if (granularity == "line") {
+                    memory.HeatmapGranularity = HEATMAP_CACHE_LINE_GRANULARITY;
+                } else {
+                    std::cerr << "ERROR: Unknown heatmap granularity " << granularity << "!" << std::endl;
+                    exit_failure_on_error();
+                }
+            }
+
+            std::string heatmap_file;
+            if (parsed_options.contains("heatmap-file"))
+            {
+                if (!parsed_options.contains("heatmap")) {
+                    std::cerr << "ERROR: --heatmap-file requires --heatmap!" << std::endl;
+                    exit_failure_on_error();
+                }
+
+                heatmap_file = parsed_options["heatmap-file"].at(0);
             }
 
             std::string hdd;
@@ -372,6 +413,19 @@ int main(int argc, char** argv)
                 fdb = parsed_options["fdb"].at(0);
             }
 
+            auto disk_cache = SysdarftDiskCachePolicy::WriteThrough;
+            if (parsed_options.contains("disk-cache"))
+            {
+                if (const auto policy = parsed_options["disk-cache"].at(0); policy == "writeback") {
+                    disk_cache = SysdarftDiskCachePolicy::WriteBack;
+                } else if (policy == "unsafe") {
+                    disk_cache = SysdarftDiskCachePolicy::Unsafe;
+                } else if (policy != "writethrough") {
+                    std::cerr << "ERROR: Unknown disk cache policy " << policy << "!" << std::endl;
+                    exit_failure_on_error();
+                }
+            }
+
             const bool headless = parsed_options.contains("no-curses");
             const bool gui = parsed_options.contains("with-gui");
 
@@ -419,22 +473,42 @@ int main(int argc, char** argv)
             }
 
             const bool cr_to_lf = parsed_options.contains("cr-to-lf");
+            const bool decode_cache = !parsed_options.contains("no-decode-cache");
+            const bool fusion = !parsed_options.contains("no-fusion");
+
+            auto engine = SysdarftCPU::ExecutionEngineType::Interpreter;
+            if (parsed_options.contains("engine"))
+            {
+                if (const auto engine_name = parsed_options["engine"].at(0); engine_name == "threaded") {
+                    engine = SysdarftCPU::ExecutionEngineType::Threaded;
+                } else if (engine_name == "jit") {
+                    engine = SysdarftCPU::ExecutionEngineType::JIT;
+                } else if (engine_name != "interpreter") {
+                    std::cerr << "ERROR: Unknown execution engine " << engine_name << "!" << std::endl;
+                    exit_failure_on_error();
+                }
+            }
 
             // boot system
             return static_cast<int>(boot_sysdarft(
-                memory_size,
+                memory,
                 font,
                 bios_path,
                 hdd,
                 fda,
                 fdb,
+                disk_cache,
                 debug,
                 ip,
                 port,
                 log_file,
                 headless,
                 gui,
-                cr_to_lf));
+                cr_to_lf,
+                decode_cache,
+                fusion,
+                engine,
+                heatmap_file));
         }
 
         std::cout   << "If you see this message, that means you have provided one or more arguments,\n"
@@ -38,14 +38,14 @@ void resize_handler(int)
     }
 }
 
-SysdarftCursesUI::SysdarftCursesUI(const uint64_t memory, const std::string & font_name)
+SysdarftCursesUI::SysdarftCursesUI(const SysdarftMemoryOptions & memory, const std::string & font_name)
     :   SysdarftCPUMemoryAccess(memory),
         cursor_x(0), cursor_y(0),
         GUIDisplay(font_name), offset_x(0),
         offset_y(0), vsb(1),
         ConsoleInputThread(this, &SysdarftCursesUI::monitor_console_input)
 {
-    video_memory = (char*)SysdarftCPUMemoryAccess::Memory[184].data();
+    video_memory = (char*)SysdarftCPUMemoryAccess::Memory + VIDEO_MEMORY_START;
     // Initialize video memory with spaces
     for (int i = 0; i < V_HEIGHT * V_WIDTH; i++) {
         video_memory[i] = ' ';
@@ -18,46 +18,77 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
-#include <mutex>
+#include <ranges>
+#include <sstream>
 #include <SysdarftIOHub.h>
 #include <SysdarftDebug.h>
 
-SysdarftExternalDeviceBaseClass & SysdarftIOHub::query_device_based_on_port(const uint64_t port)
+void SysdarftIOHub::register_device(std::unique_ptr < SysdarftExternalDeviceBaseClass > device)
 {
-    std::lock_guard list_lock(list_mutex_);
-    for (const auto & deviceMap : device_list)
+    for (const auto & port : device->device_buffer | std::views::keys)
     {
-        std::lock_guard buffer_lock(deviceMap->buffer_mutex_);
-        for (auto it = deviceMap->device_buffer.begin();
-            it != deviceMap->device_buffer.end(); ++it)
-        {
-            if (port == it->first) {
-                return *deviceMap;
-            }
+        if (route(port) != nullptr) {
+            std::stringstream ss;
+            ss << "Port 0x" << std::hex << std::uppercase << port << " is already used by another device";
+            throw SysdarftPortConflict(ss.str());
         }
     }
 
-    throw SysdarftNoSuchDevice("Device providing IO port " + std::to_string(port) + " not found!");
+    for (const auto & [port, stream] : device->device_buffer)
+    {
+        const PortRouteType entry { .device = device.get(), .stream = stream.get() };
+        if (port < DIRECT_PORT_COUNT) {
+            DirectPorts[port] = entry;
+        } else {
+            SparsePorts.emplace(port, entry);
+        }
+    }
+
+    device_list.emplace_back(std::move(device));
+}
+
+SysdarftIOHub::~SysdarftIOHub()
+{
+    while (!device_list.empty()) {
+        device_list.pop_back();
+    }
 }
 
-ControllerDataStream & SysdarftIOHub::ins(const uint64_t port)
+SysdarftFaultType SysdarftIOHub::ins(const uint64_t port, ControllerDataStream *& buffer)
 {
-    auto & device = query_device_based_on_port(port);
-    if (!device.request_read(port)) {
-        throw SysdarftDeviceIOError("Input error on port " + std::to_string(port));
+    const auto entry = route(port);
+    if (entry == nullptr) {
+        return SysdarftFaultType::NoSuchDevice;
+    }
+
+    try {
+        if (!entry->device->request_read(port)) {
+            return SysdarftFaultType::DeviceIOError;
+        }
+    } catch (SysdarftDeviceIOError &) {
+        // devices still report malformed requests by throwing, don't let it leave the hub
+        return SysdarftFaultType::DeviceIOError;
     }
 
-    std::lock_guard lock(device.buffer_mutex_);
-    return *device.device_buffer.at(port);
+    buffer = entry->stream;
+    return SysdarftFaultType::None;
 }
 
-void SysdarftIOHub::outs(const uint64_t port, ControllerDataStream & buffer)
+SysdarftFaultType SysdarftIOHub::outs(const uint64_t port, ControllerDataStream & buffer)
 {
-    auto && device = query_device_based_on_port(port);
-    std::lock_guard lock(device.buffer_mutex_);
-    device.device_buffer.at(port)->insert(buffer);
+    const auto entry = route(port);
+    if (entry == nullptr) {
+        return SysdarftFaultType::NoSuchDevice;
+    }
 
-    if (!device.request_write(port)) {
-        throw SysdarftDeviceIOError("Output error on port " + std::to_string(port));
+    try {
+        entry->stream->insert(buffer);
+        if (!entry->device->request_write(port)) {
+            return SysdarftFaultType::DeviceIOError;
+        }
+    } catch (SysdarftDeviceIOError &) {
+        return SysdarftFaultType::DeviceIOError;
     }
+
+    return SysdarftFaultType::None;
 }
@@ -29,59 +29,56 @@ void decode_instruction(std::vector < std::string > & output, std::vector<uint8_
         std::stringstream buffer;
         const auto instruction = code_buffer_pop8(input);
 
-        for (const auto &[fst, snd] : instruction_map)
+        const auto & descriptor = instruction_table[instruction];
+        if (descriptor.mnemonic == nullptr) {
+            output.emplace_back(bad_nbit(instruction));
+            return;
+        }
+
+        buffer << descriptor.mnemonic;
+
+        uint8_t op_width = 0;
+        if (descriptor.require_operation_width_specification)
         {
-            if (snd.at(ENTRY_OPCODE) == instruction)
+            switch (op_width = code_buffer_pop8(input))
             {
-                buffer << fst;
+            case _8bit_prefix:  buffer << " .8bit "; break;
+            case _16bit_prefix: buffer << " .16bit";  break;
+            case _32bit_prefix: buffer << " .32bit";  break;
+            case _64bit_prefix: buffer << " .64bit";  break;
+            default:
+                output.emplace_back(bad_nbit(instruction));
+                output.emplace_back(bad_nbit(op_width));
+                return;
+            }
+        }
 
-                uint8_t op_width = 0;
-                if (snd.at(ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION) != 0)
-                {
-                    switch (op_width = code_buffer_pop8(input))
-                    {
-                    case _8bit_prefix:  buffer << " .8bit "; break;
-                    case _16bit_prefix: buffer << " .16bit";  break;
-                    case _32bit_prefix: buffer << " .32bit";  break;
-                    case _64bit_prefix: buffer << " .64bit";  break;
-                    default:
-                        output.emplace_back(bad_nbit(instruction));
-                        output.emplace_back(bad_nbit(op_width));
-                        return;
-                    }
+        for (uint64_t i = 0 ; i < descriptor.argument_count; i++)
+        {
+            std::vector < std::string > operands;
+            try {
+                decode_target(operands, input);
+            } catch (SysdarftBaseError &) {
+                output.emplace_back(bad_nbit(instruction));
+                if (op_width) {
+                    output.emplace_back(bad_nbit(op_width));
                 }
+                output.insert(output.end(), operands.begin(), operands.end());
+                return;
+            }
 
-                for (uint64_t i = 0 ; i < snd.at(ENTRY_ARGUMENT_COUNT); i++)
-                {
-                    std::vector < std::string > operands;
-                    try {
-                        decode_target(operands, input);
-                    } catch (SysdarftBaseError &) {
-                        output.emplace_back(bad_nbit(instruction));
-                        if (op_width) {
-                            output.emplace_back(bad_nbit(op_width));
-                        }
-                        output.insert(output.end(), operands.begin(), operands.end());
-                        return;
-                    }
-
-                    buffer << " <";
-                    for (const auto & code : operands) {
-                        buffer << code;
-                    }
-                    buffer << ">";
-
-                    if (i == 0 && snd.at(ENTRY_ARGUMENT_COUNT) > 1) {
-                        buffer << ",";
-                    }
-                }
+            buffer << " <";
+            for (const auto & code : operands) {
+                buffer << code;
+            }
+            buffer << ">";
 
-                output.emplace_back(buffer.str());
-                return;
+            if (i == 0 && descriptor.argument_count > 1) {
+                buffer << ",";
             }
         }
 
-        output.emplace_back(bad_nbit(instruction));
+        output.emplace_back(buffer.str());
     } catch (...) {
         // output.emplace_back("(bad)");
         return;
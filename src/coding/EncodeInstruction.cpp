@@ -75,20 +75,20 @@ uint8_t encode_width_specifier(std::vector<uint8_t> &buffer, const std::string &
 void SYSDARFT_EXPORT_SYMBOL encode_instruction(std::vector<uint8_t> & buffer, const std::string & instruction)
 {
     const auto cleaned_line = clean_line(instruction);
-    if (!instruction_map.contains(cleaned_line[0])) {
+    const auto opcode_it = instruction_map.find(cleaned_line[0]);
+    if (opcode_it == instruction_map.end()) {
         throw InstructionExpressionError("Unknown instruction " + instruction);
     }
 
-    const auto & instruction_name = cleaned_line[0];
-    const auto & argument_count = instruction_map.at(cleaned_line[0]).at(ENTRY_ARGUMENT_COUNT);
-    const auto & requires_width_specification =
-        instruction_map.at(cleaned_line[0]).at(ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION);
+    const auto opcode = opcode_it->second;
+    const auto & descriptor = instruction_table[opcode];
+    const uint64_t argument_count = descriptor.argument_count;
 
     int operand_index_begin = 1;
     uint8_t current_ops_width = 0;
 
-    code_buffer_push8(buffer, instruction_map.at(instruction_name).at(ENTRY_OPCODE));
-    if (requires_width_specification != 0)
+    code_buffer_push8(buffer, opcode);
+    if (descriptor.require_operation_width_specification)
     {
         if (cleaned_line.size() < 2) {
             throw InstructionExpressionError("Width specification required but not found for " + instruction);
@@ -204,7 +204,7 @@ void SYSDARFT_EXPORT_SYMBOL encode_instruction(std::vector<uint8_t> & buffer, co
     }
 
     try {
-        OperandSanityCheck(instruction_map.at(instruction_name).at(ENTRY_OPCODE), SanityCheckOperandVector);
+        OperandSanityCheck(opcode, SanityCheckOperandVector);
     } catch (const std::exception & e) {
         throw InstructionExpressionError("Operand sanity check for " + instruction + " failed: " + e.what());
     }
@@ -49,6 +49,17 @@ bool isInvalid64BitOperand(const parsed_target_t& operand)
     return isInvalidRegister || isInvalidMemory || isConstant;
 }
 
+bool is8BitOperand(const parsed_target_t& operand)
+{
+    switch (operand.TargetType)
+    {
+    case parsed_target_t::REGISTER: return operand.RegisterName.at(1) == 'R';
+    case parsed_target_t::MEMORY:   return operand.memory.MemoryWidth == "8";
+    case parsed_target_t::CONSTANT: return operand.ConstantWidth == "8";
+    default: return false;
+    }
+}
+
 
 void OperandSanityCheck(const uint8_t opcode, const std::vector < parsed_target_t > & operands)
 {
@@ -116,12 +127,33 @@ void OperandSanityCheck(const uint8_t opcode, const std::vector < parsed_target_
     case OPCODE_JO:
     case OPCODE_JNO:
     case OPCODE_LOOP:
+    case OPCODE_LPT:
         if (!(isInvalid64BitOperand(operands.at(0)) && isInvalid64BitOperand(operands.at(1))))
         {
             throw InstructionExpressionError(
                 "Control Flow instruction operand width is inconsistent with width enforcement scheme (WES)");
         }
         break;
+    case OPCODE_STOS:
+    case OPCODE_SCAS:
+        if (!is8BitOperand(operands.at(0))) {
+            throw InstructionExpressionError("STOS and SCAS only accept an 8bit operand");
+        }
+        break;
+    case OPCODE_INVLPG:
+        if (!isInvalid64BitOperand(operands.at(0))) {
+            throw InstructionExpressionError("INVLPG operand width is inconsistent with width enforcement scheme (WES)");
+        }
+        break;
+    case OPCODE_RDPFA:
+        if (operands.at(0).TargetType == parsed_target_t::CONSTANT) {
+            throw_constant_error();
+        }
+
+        if (!isInvalid64BitOperand(operands.at(0))) {
+            throw InstructionExpressionError("RDPFA operand width is inconsistent with width enforcement scheme (WES)");
+        }
+        break;
     default:;
     }
 }
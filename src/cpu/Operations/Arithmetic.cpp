@@ -20,51 +20,78 @@
 
 #include <SysdarftInstructionExec.h>
 
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::add(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const __uint128_t result = operand1 + operand2;
-    WidthAndOperands.second[0].set_val(check_overflow(WidthAndOperands.first /* BCD Width */, result));
+    WidthAndOperands.second[0].set_val(check_overflow<WidthType>(result));
 }
 
+instantiate_width_specialized_instruction_exec(add);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::adc(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const auto CF = SysdarftRegister::load<FlagRegisterType>().Carry;
     const __uint128_t result = operand1 + operand2 + CF;
-    WidthAndOperands.second[0].set_val(check_overflow(WidthAndOperands.first /* BCD Width */, result));
+    WidthAndOperands.second[0].set_val(check_overflow<WidthType>(result));
 }
 
+instantiate_width_specialized_instruction_exec(adc);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::sub(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const __uint128_t result = operand1 - operand2;
-    WidthAndOperands.second[0].set_val(check_overflow(WidthAndOperands.first /* BCD Width */, result));
+    WidthAndOperands.second[0].set_val(check_overflow<WidthType>(result));
 }
 
+instantiate_width_specialized_instruction_exec(sub);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::sbb(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const auto CF = SysdarftRegister::load<FlagRegisterType>().Carry;
     const __uint128_t result = operand1 - operand2 - CF;
-    WidthAndOperands.second[0].set_val(check_overflow(WidthAndOperands.first /* BCD Width */, result));
+    WidthAndOperands.second[0].set_val(check_overflow<WidthType>(result));
 }
 
+instantiate_width_specialized_instruction_exec(sbb);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::imul(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
-    uint64_t TargetRegister0;
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  TargetRegister0 = SysdarftRegister::load<RegisterType, 0>()             | 0xFFFFFFFFFFFFFF00; break;
-    case _16bit_prefix: TargetRegister0 = SysdarftRegister::load<ExtendedRegisterType, 0>()     | 0xFFFFFFFFFFFF0000; break;
-    case _32bit_prefix: TargetRegister0 = SysdarftRegister::load<HalfExtendedRegisterType, 0>() | 0xFFFFFFFF00000000; break;
-    case _64bit_prefix: TargetRegister0 = SysdarftRegister::load<FullyExtendedRegisterType, 0>(); break;
-    default: throw IllegalInstruction("Unknown width");
-    }
+    using RegisterAccessType = typename OperationWidthTraits<WidthType>::RegisterAccessType;
+    const uint64_t TargetRegister0 = SysdarftRegister::load<RegisterAccessType, 0>()
+        | ~static_cast<uint64_t>(std::numeric_limits<WidthType>::max());
     const auto operand1 = WidthAndOperands.second[0].get_val();
+    if (fault_pending()) {
+        return;
+    }
 
     const int64_t factor = *(int64_t*)(&operand1);
     const int64_t base = *(int64_t*)(&TargetRegister0);
@@ -72,58 +99,45 @@ void SysdarftCPUInstructionExecutor::imul(__uint128_t, WidthAndOperandsType & Wi
     const __int128_t signed_result = factor * base;
     uint64_t result;
     if (signed_result > 0) {
-        result = check_overflow(WidthAndOperands.first /* BCD Width */, signed_result);
+        result = check_overflow<WidthType>(signed_result);
     } else {
-        result = check_overflow_signed(WidthAndOperands.first /* BCD Width */, signed_result);
+        result = check_overflow_signed<WidthType>(signed_result);
     }
 
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  SysdarftRegister::store<RegisterType, 0>(result); break;
-    case _16bit_prefix: SysdarftRegister::store<ExtendedRegisterType, 0>(result); break;
-    case _32bit_prefix: SysdarftRegister::store<HalfExtendedRegisterType, 0>(result); break;
-    case _64bit_prefix: SysdarftRegister::store<FullyExtendedRegisterType, 0>(result); break;
-    default: throw IllegalInstruction("Unknown width");
-    }
+    SysdarftRegister::store<RegisterAccessType, 0>(result);
 }
 
+instantiate_width_specialized_instruction_exec(imul);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::mul(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
-    uint64_t TargetRegister0;
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  TargetRegister0 = SysdarftRegister::load<RegisterType, 0>(); break;
-    case _16bit_prefix: TargetRegister0 = SysdarftRegister::load<ExtendedRegisterType, 0>(); break;
-    case _32bit_prefix: TargetRegister0 = SysdarftRegister::load<HalfExtendedRegisterType, 0>(); break;
-    case _64bit_prefix: TargetRegister0 = SysdarftRegister::load<FullyExtendedRegisterType, 0>(); break;
-    default: throw IllegalInstruction("Unknown width");
-    }
+    using RegisterAccessType = typename OperationWidthTraits<WidthType>::RegisterAccessType;
+    const uint64_t TargetRegister0 = SysdarftRegister::load<RegisterAccessType, 0>();
     const auto operand1 = WidthAndOperands.second[0].get_val();
+    if (fault_pending()) {
+        return;
+    }
 
     const uint64_t factor = operand1;
     const uint64_t base = TargetRegister0;
 
     const __uint128_t result = factor * base;
-    const auto trimmed_result = check_overflow(WidthAndOperands.first /* BCD Width */, result);
-
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  SysdarftRegister::store<RegisterType, 0>(trimmed_result); break;
-    case _16bit_prefix: SysdarftRegister::store<ExtendedRegisterType, 0>(trimmed_result); break;
-    case _32bit_prefix: SysdarftRegister::store<HalfExtendedRegisterType, 0>(trimmed_result); break;
-    case _64bit_prefix: SysdarftRegister::store<FullyExtendedRegisterType, 0>(trimmed_result); break;
-    default: throw IllegalInstruction("Unknown width");
-    }
+    SysdarftRegister::store<RegisterAccessType, 0>(check_overflow<WidthType>(result));
 }
 
+instantiate_width_specialized_instruction_exec(mul);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::idiv(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
-    uint64_t TargetRegister0;
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  TargetRegister0 = SysdarftRegister::load<RegisterType, 0>()             | 0xFFFFFFFFFFFFFF00; break;
-    case _16bit_prefix: TargetRegister0 = SysdarftRegister::load<ExtendedRegisterType, 0>()     | 0xFFFFFFFFFFFF0000; break;
-    case _32bit_prefix: TargetRegister0 = SysdarftRegister::load<HalfExtendedRegisterType, 0>() | 0xFFFFFFFF00000000; break;
-    case _64bit_prefix: TargetRegister0 = SysdarftRegister::load<FullyExtendedRegisterType, 0>(); break;
-    default: throw IllegalInstruction("Unknown width");
-    }
+    using RegisterAccessType = typename OperationWidthTraits<WidthType>::RegisterAccessType;
+    const uint64_t TargetRegister0 = SysdarftRegister::load<RegisterAccessType, 0>()
+        | ~static_cast<uint64_t>(std::numeric_limits<WidthType>::max());
     const auto operand1 = WidthAndOperands.second[0].get_val();
+    if (fault_pending()) {
+        return;
+    }
 
     const int64_t factor = *(int64_t*)(&operand1);
     const int64_t base = *(int64_t*)(&TargetRegister0);
@@ -137,49 +151,32 @@ void SysdarftCPUInstructionExecutor::idiv(__uint128_t, WidthAndOperandsType & Wi
     __int128_t remainder = base % factor;
 
     if (quotient > 0) {
-        quotient = check_overflow(WidthAndOperands.first /* BCD Width */, quotient);
+        quotient = check_overflow<WidthType>(quotient);
     } else {
-        quotient = check_overflow_signed(WidthAndOperands.first /* BCD Width */, quotient);
+        quotient = check_overflow_signed<WidthType>(quotient);
     }
 
     if (remainder > 0) {
-        remainder = check_overflow(WidthAndOperands.first /* BCD Width */, remainder);
+        remainder = check_overflow<WidthType>(remainder);
     } else {
-        remainder = check_overflow_signed(WidthAndOperands.first /* BCD Width */, remainder);
+        remainder = check_overflow_signed<WidthType>(remainder);
     }
 
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:
-        SysdarftRegister::store<RegisterType, 0>(quotient);
-        SysdarftRegister::store<RegisterType, 1>(remainder);
-        break;
-    case _16bit_prefix:
-        SysdarftRegister::store<ExtendedRegisterType, 0>(quotient);
-        SysdarftRegister::store<ExtendedRegisterType, 1>(remainder);
-        break;
-    case _32bit_prefix:
-        SysdarftRegister::store<HalfExtendedRegisterType, 0>(quotient);
-        SysdarftRegister::store<HalfExtendedRegisterType, 1>(remainder);
-        break;
-    case _64bit_prefix:
-        SysdarftRegister::store<FullyExtendedRegisterType, 0>(quotient);
-        SysdarftRegister::store<FullyExtendedRegisterType, 1>(remainder);
-        break;
-    default: throw IllegalInstruction("Unknown width");
-    }
+    SysdarftRegister::store<RegisterAccessType, 0>(quotient);
+    SysdarftRegister::store<RegisterAccessType, 1>(remainder);
 }
 
+instantiate_width_specialized_instruction_exec(idiv);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::div(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
-    uint64_t TargetRegister0;
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  TargetRegister0 = SysdarftRegister::load<RegisterType, 0>()             ; break;
-    case _16bit_prefix: TargetRegister0 = SysdarftRegister::load<ExtendedRegisterType, 0>()     ; break;
-    case _32bit_prefix: TargetRegister0 = SysdarftRegister::load<HalfExtendedRegisterType, 0>() ; break;
-    case _64bit_prefix: TargetRegister0 = SysdarftRegister::load<FullyExtendedRegisterType, 0>(); break;
-    default: throw IllegalInstruction("Unknown width");
-    }
+    using RegisterAccessType = typename OperationWidthTraits<WidthType>::RegisterAccessType;
+    const uint64_t TargetRegister0 = SysdarftRegister::load<RegisterAccessType, 0>();
     const auto operand1 = WidthAndOperands.second[0].get_val();
+    if (fault_pending()) {
+        return;
+    }
 
     const uint64_t factor = operand1;
     const uint64_t base = TargetRegister0;
@@ -192,73 +189,66 @@ void SysdarftCPUInstructionExecutor::div(__uint128_t, WidthAndOperandsType & Wid
     __uint128_t quotient = base / factor;
     __uint128_t remainder = base % factor;
 
-    quotient = check_overflow(WidthAndOperands.first /* BCD Width */, quotient);
-    remainder = check_overflow(WidthAndOperands.first /* BCD Width */, remainder);
-
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:
-        SysdarftRegister::store<RegisterType, 0>(quotient);
-        SysdarftRegister::store<RegisterType, 1>(remainder);
-        break;
-    case _16bit_prefix:
-        SysdarftRegister::store<ExtendedRegisterType, 0>(quotient);
-        SysdarftRegister::store<ExtendedRegisterType, 1>(remainder);
-        break;
-    case _32bit_prefix:
-        SysdarftRegister::store<HalfExtendedRegisterType, 0>(quotient);
-        SysdarftRegister::store<HalfExtendedRegisterType, 1>(remainder);
-        break;
-    case _64bit_prefix:
-        SysdarftRegister::store<FullyExtendedRegisterType, 0>(quotient);
-        SysdarftRegister::store<FullyExtendedRegisterType, 1>(remainder);
-        break;
-    default: throw IllegalInstruction("Unknown width");
-    }
+    quotient = check_overflow<WidthType>(quotient);
+    remainder = check_overflow<WidthType>(remainder);
+
+    SysdarftRegister::store<RegisterAccessType, 0>(quotient);
+    SysdarftRegister::store<RegisterAccessType, 1>(remainder);
 }
 
+instantiate_width_specialized_instruction_exec(div);
+
 void SysdarftCPUInstructionExecutor::neg(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     auto operand1 = WidthAndOperands.second[0].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     operand1 = -operand1;
     WidthAndOperands.second[0].set_val(operand1);
-    check_overflow(_8bit_prefix, 0); // clear arithmetic flags
+    if (fault_pending()) {
+        return;
+    }
+
+    check_overflow<uint8_t>(0); // clear arithmetic flags
 }
 
 void SysdarftCPUInstructionExecutor::cmp(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
-
-    auto FG = SysdarftRegister::load<FlagRegisterType>();
-    check_overflow(_8bit_prefix, 0); // clear arithmetic flags
-
-    if (operand1 > operand2) {
-        FG.LargerThan = 1;
-        FG.LessThan = 0;
-        FG.Equal = 0;
-    } else if (operand1 == operand2) {
-        FG.LargerThan = 0;
-        FG.LessThan = 0;
-        FG.Equal = 1;
-    } else if (operand1 < operand2) {
-        FG.LargerThan = 0;
-        FG.LessThan = 1;
-        FG.Equal = 0;
+    if (fault_pending()) {
+        return;
     }
 
-    SysdarftRegister::store<FlagRegisterType>(FG);
+    defer_comparison_flags(operand1, operand2);
 }
 
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::inc(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const __uint128_t result = operand1 + 1;
-    WidthAndOperands.second[0].set_val(check_overflow(WidthAndOperands.first /* BCD Width */, result));
+    WidthAndOperands.second[0].set_val(check_overflow<WidthType>(result));
 }
 
+instantiate_width_specialized_instruction_exec(inc);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::dec(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const __uint128_t result = operand1 - 1;
-    WidthAndOperands.second[0].set_val(check_overflow(WidthAndOperands.first /* BCD Width */, result));
+    WidthAndOperands.second[0].set_val(check_overflow<WidthType>(result));
 }
+
+instantiate_width_specialized_instruction_exec(dec);
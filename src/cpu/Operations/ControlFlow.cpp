@@ -18,12 +18,17 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#include <functional>
 #include <SysdarftInstructionExec.h>
 
 void SysdarftCPUInstructionExecutor::jmp(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const uint64_t addr_base = WidthAndOperands.second[0].get_val();
     const uint64_t ip = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     SysdarftRegister::store<CodeBaseType>(addr_base);
     SysdarftRegister::store<InstructionPointerType>(ip);
 }
@@ -38,6 +43,10 @@ void SysdarftCPUInstructionExecutor::call(__uint128_t, WidthAndOperandsType & Wi
 
     const uint64_t addr_base = WidthAndOperands.second[0].get_val();
     const uint64_t ip = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     SysdarftRegister::store<CodeBaseType>(addr_base);
     SysdarftRegister::store<InstructionPointerType>(ip);
 }
@@ -46,6 +55,10 @@ void SysdarftCPUInstructionExecutor::ret(__uint128_t, WidthAndOperandsType &)
 {
     const auto ip = pop_stack<uint64_t>();
     const auto cb = pop_stack<uint64_t>();
+    if (fault_pending()) {
+        return;
+    }
+
     SysdarftRegister::store<CodeBaseType>(cb);
     SysdarftRegister::store<InstructionPointerType>(ip);
 }
@@ -56,6 +69,10 @@ void SysdarftCPUInstructionExecutor::je(__uint128_t, WidthAndOperandsType & Widt
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
     }
@@ -67,6 +84,10 @@ void SysdarftCPUInstructionExecutor::jne(__uint128_t, WidthAndOperandsType & Wid
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
     }
@@ -78,6 +99,10 @@ void SysdarftCPUInstructionExecutor::jb(__uint128_t, WidthAndOperandsType & Widt
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
     }
@@ -89,6 +114,10 @@ void SysdarftCPUInstructionExecutor::jl(__uint128_t, WidthAndOperandsType & Widt
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
     }
@@ -100,6 +129,10 @@ void SysdarftCPUInstructionExecutor::jbe(__uint128_t, WidthAndOperandsType & Wid
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
     }
@@ -111,6 +144,10 @@ void SysdarftCPUInstructionExecutor::jle(__uint128_t, WidthAndOperandsType & Wid
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
     }
@@ -119,6 +156,10 @@ void SysdarftCPUInstructionExecutor::jle(__uint128_t, WidthAndOperandsType & Wid
 void SysdarftCPUInstructionExecutor::int_(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const uint64_t code = WidthAndOperands.second[0].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     SysdarftCPUInterruption::do_interruption(code);
 }
 
@@ -138,6 +179,10 @@ void SysdarftCPUInstructionExecutor::jc(__uint128_t, WidthAndOperandsType & Widt
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
     }
@@ -149,6 +194,10 @@ void SysdarftCPUInstructionExecutor::jnc(__uint128_t, WidthAndOperandsType & Wid
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
     }
@@ -160,6 +209,10 @@ void SysdarftCPUInstructionExecutor::jo(__uint128_t, WidthAndOperandsType & Widt
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
     }
@@ -171,6 +224,10 @@ void SysdarftCPUInstructionExecutor::jno(__uint128_t, WidthAndOperandsType & Wid
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
     }
@@ -184,6 +241,10 @@ void SysdarftCPUInstructionExecutor::loop(__uint128_t, WidthAndOperandsType & Wi
     {
         const uint64_t addr_base = WidthAndOperands.second[0].get_val();
         const uint64_t ip = WidthAndOperands.second[1].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
         SysdarftRegister::store<CodeBaseType>(addr_base);
         SysdarftRegister::store<InstructionPointerType>(ip);
         SysdarftRegister::store<FullyExtendedRegisterType, 3>(cx);
@@ -191,3 +252,62 @@ void SysdarftCPUInstructionExecutor::loop(__uint128_t, WidthAndOperandsType & Wi
         SysdarftRegister::store<FullyExtendedRegisterType, 3>(0);
     }
 }
+
+template < typename ConditionType >
+void SysdarftCPUInstructionExecutor::compare_and_branch(WidthAndOperandsType & WidthAndOperands,
+    ConditionType && Condition)
+{
+    const auto operand1 = WidthAndOperands.second[0].get_val();
+    const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        // the fault is cmp's, the guest returns to the jump as if the two were never fused
+        SysdarftRegister::store<InstructionPointerType>(
+            SysdarftRegister::load<InstructionPointerType>() - FusedJumpLength);
+        return;
+    }
+
+    // flags are still what cmp leaves behind, for whoever reads them later
+    defer_comparison_flags(operand1, operand2);
+
+    if (Condition(operand1, operand2))
+    {
+        const uint64_t addr_base = WidthAndOperands.second[2].get_val();
+        const uint64_t ip = WidthAndOperands.second[3].get_val();
+        if (fault_pending()) {
+            return;
+        }
+
+        SysdarftRegister::store<CodeBaseType>(addr_base);
+        SysdarftRegister::store<InstructionPointerType>(ip);
+    }
+}
+
+void SysdarftCPUInstructionExecutor::cmp_je(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    compare_and_branch(WidthAndOperands, std::equal_to<uint64_t>());
+}
+
+void SysdarftCPUInstructionExecutor::cmp_jne(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    compare_and_branch(WidthAndOperands, std::not_equal_to<uint64_t>());
+}
+
+void SysdarftCPUInstructionExecutor::cmp_jb(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    compare_and_branch(WidthAndOperands, std::greater<uint64_t>());
+}
+
+void SysdarftCPUInstructionExecutor::cmp_jl(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    compare_and_branch(WidthAndOperands, std::less<uint64_t>());
+}
+
+void SysdarftCPUInstructionExecutor::cmp_jbe(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    compare_and_branch(WidthAndOperands, std::greater_equal<uint64_t>());
+}
+
+void SysdarftCPUInstructionExecutor::cmp_jle(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    compare_and_branch(WidthAndOperands, std::less_equal<uint64_t>());
+}
@@ -23,6 +23,10 @@
 void SysdarftCPUInstructionExecutor::mov(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto src = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     WidthAndOperands.second[0].set_val(src);
 }
 
@@ -30,38 +34,37 @@ void SysdarftCPUInstructionExecutor::xchg(__uint128_t, WidthAndOperandsType & Wi
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
 
     // exchange
     WidthAndOperands.second[0].set_val(operand2);
     WidthAndOperands.second[1].set_val(operand1);
 }
 
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::push(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  push_stack<uint8_t>(operand1);  break;
-    case _16bit_prefix: push_stack<uint16_t>(operand1); break;
-    case _32bit_prefix: push_stack<uint32_t>(operand1); break;
-    case _64bit_prefix: push_stack<uint64_t>(operand1); break;
-    default: throw IllegalInstruction("Unknown width");
+    if (fault_pending()) {
+        return;
     }
+
+    push_stack<WidthType>(operand1);
 }
 
+instantiate_width_specialized_instruction_exec(push);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::pop(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
-    uint64_t val = 0;
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  val = pop_stack<uint8_t>();  break;
-    case _16bit_prefix: val = pop_stack<uint16_t>(); break;
-    case _32bit_prefix: val = pop_stack<uint32_t>(); break;
-    case _64bit_prefix: val = pop_stack<uint64_t>(); break;
-    default: throw IllegalInstruction("Unknown width");
-    }
-
+    const uint64_t val = pop_stack<WidthType>();
     WidthAndOperands.second[0].set_val(val);
 }
 
+instantiate_width_specialized_instruction_exec(pop);
+
 struct pushall_data
 {
     uint64_t FER0;
@@ -149,6 +152,11 @@ void SysdarftCPUInstructionExecutor::popall(__uint128_t, WidthAndOperandsType &)
         EP,
         CPS] = pop_stack<pushall_data>();
 
+    if (fault_pending()) {
+        return;
+    }
+
+    const auto previous = SysdarftRegister::load<WholeRegisterType>();
     SysdarftRegister::store<FullyExtendedRegisterType, 0>(FER0);
     SysdarftRegister::store<FullyExtendedRegisterType, 1>(FER1);
     SysdarftRegister::store<FullyExtendedRegisterType, 2>(FER2);
@@ -173,11 +181,16 @@ void SysdarftCPUInstructionExecutor::popall(__uint128_t, WidthAndOperandsType &)
     SysdarftRegister::store<ExtendedBaseType>(EB);
     SysdarftRegister::store<ExtendedPointerType>(EP);
     SysdarftRegister::store<CurrentProcedureStackPreservationSpaceType>(CPS);
+    restore_privileged_state(previous);
 }
 
 void SysdarftCPUInstructionExecutor::enter(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const auto SP = SysdarftRegister::load<StackPointerType>();
     SysdarftRegister::store<CurrentProcedureStackPreservationSpaceType>(operand1);
     SysdarftRegister::store<StackPointerType>(SP - operand1);
@@ -196,10 +209,10 @@ void SysdarftCPUInstructionExecutor::movs(__uint128_t, WidthAndOperandsType &)
     const uint64_t dest = SysdarftRegister::load<DataPointerType>() + SysdarftRegister::load<DataBaseType>();
     const uint64_t src = SysdarftRegister::load<ExtendedPointerType>() + SysdarftRegister::load<ExtendedBaseType>();
     const uint64_t count = SysdarftRegister::load<FullyExtendedRegisterType, 3>();
-    const auto buffer = new char [count];
-    SysdarftCPUMemoryAccess::read_memory(src, buffer, count);
-    SysdarftCPUMemoryAccess::write_memory(dest, buffer, count);
-    delete[] buffer;
+
+    if (const auto fault = try_move_linear(dest, src, count); fault != SysdarftFaultType::None) {
+        raise_fault(fault);
+    }
 }
 
 void SysdarftCPUInstructionExecutor::lea(__uint128_t, WidthAndOperandsType & WidthAndOperands)
@@ -207,3 +220,66 @@ void SysdarftCPUInstructionExecutor::lea(__uint128_t, WidthAndOperandsType & Wid
     const uint64_t effective_addr = WidthAndOperands.second[1].get_effective_addr();
     WidthAndOperands.second[0].set_val(effective_addr);
 }
+
+void SysdarftCPUInstructionExecutor::stos(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    const uint64_t dest = SysdarftRegister::load<DataPointerType>() + SysdarftRegister::load<DataBaseType>();
+    const uint64_t count = SysdarftRegister::load<FullyExtendedRegisterType, 3>();
+    const auto value = static_cast<uint8_t>(WidthAndOperands.second[0].get_val());
+    if (fault_pending()) {
+        return;
+    }
+
+    if (const auto fault = try_fill_linear(dest, value, count); fault != SysdarftFaultType::None) {
+        raise_fault(fault);
+    }
+}
+
+void SysdarftCPUInstructionExecutor::cmps(__uint128_t, WidthAndOperandsType &)
+{
+    const uint64_t address1 = SysdarftRegister::load<DataPointerType>() + SysdarftRegister::load<DataBaseType>();
+    const uint64_t address2 = SysdarftRegister::load<ExtendedPointerType>() + SysdarftRegister::load<ExtendedBaseType>();
+    const uint64_t count = SysdarftRegister::load<FullyExtendedRegisterType, 3>();
+
+    uint64_t offset = 0;
+    if (const auto fault = try_compare_linear(address1, address2, count, offset); fault != SysdarftFaultType::None) {
+        raise_fault(fault);
+        return;
+    }
+
+    // flags as if the first differing bytes were compared by CMP
+    uint8_t byte1 = 0, byte2 = 0;
+    if (offset != count) {
+        (void)try_load_linear(address1 + offset, byte1);
+        (void)try_load_linear(address2 + offset, byte2);
+        SysdarftRegister::store<FullyExtendedRegisterType, 3>(offset);
+    }
+
+    defer_comparison_flags(byte1, byte2);
+}
+
+void SysdarftCPUInstructionExecutor::scas(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    const uint64_t address = SysdarftRegister::load<DataPointerType>() + SysdarftRegister::load<DataBaseType>();
+    const uint64_t count = SysdarftRegister::load<FullyExtendedRegisterType, 3>();
+    const auto value = static_cast<uint8_t>(WidthAndOperands.second[0].get_val());
+    if (fault_pending()) {
+        return;
+    }
+
+    uint64_t offset = 0;
+    if (const auto fault = try_scan_linear(address, value, count, offset); fault != SysdarftFaultType::None) {
+        raise_fault(fault);
+        return;
+    }
+
+    auto FG = SysdarftRegister::load<FlagRegisterType>();
+    FG.Equal = offset != count;
+    FG.LargerThan = 0;
+    FG.LessThan = 0;
+    SysdarftRegister::store<FlagRegisterType>(FG);
+
+    if (offset != count) {
+        SysdarftRegister::store<FullyExtendedRegisterType, 3>(offset);
+    }
+}
@@ -23,8 +23,23 @@
 void SysdarftCPUInstructionExecutor::in(__uint128_t, WidthAndOperandsType & Operands)
 {
     const auto & port = Operands.second[0].get_val();
-    auto && buffer = SysdarftIOHub::ins(port);
-    const auto & data = buffer.pop<uint64_t>();
+    if (fault_pending() || !require_privilege()) {
+        return;
+    }
+
+    ControllerDataStream * buffer = nullptr;
+    if (const auto fault = SysdarftIOHub::ins(port, buffer); fault != SysdarftFaultType::None) {
+        raise_fault(fault);
+        return;
+    }
+
+    uint64_t data = 0;
+    if (!buffer->try_pop(data)) {
+        // Device buffer is empty
+        raise_fault(SysdarftFaultType::DeviceIOError);
+        return;
+    }
+
     Operands.second[1].set_val(data);
 }
 
@@ -32,10 +47,15 @@ void SysdarftCPUInstructionExecutor::out(__uint128_t, WidthAndOperandsType & Ope
 {
     const auto & port = Operands.second[0].get_val();
     const auto & data = Operands.second[1].get_val();
+    if (fault_pending() || !require_privilege()) {
+        return;
+    }
 
     ControllerDataStream buffer;
     buffer.push(data);
-    SysdarftIOHub::outs(port, buffer);
+    if (const auto fault = SysdarftIOHub::outs(port, buffer); fault != SysdarftFaultType::None) {
+        raise_fault(fault);
+    }
 }
 
 void SysdarftCPUInstructionExecutor::ins(__uint128_t, WidthAndOperandsType & Operands)
@@ -44,28 +64,62 @@ void SysdarftCPUInstructionExecutor::ins(__uint128_t, WidthAndOperandsType & Ope
     const auto DP = SysdarftRegister::load<DataPointerType>();
     const auto CX = SysdarftRegister::load<FullyExtendedRegisterType, 3>();
     const auto & port = Operands.second[0].get_val();
+    if (fault_pending() || !require_privilege()) {
+        return;
+    }
+
+    ControllerDataStream * buffer = nullptr;
+    if (const auto fault = SysdarftIOHub::ins(port, buffer); fault != SysdarftFaultType::None) {
+        raise_fault(fault);
+        return;
+    }
+
+    if (buffer->getSize() != CX) {
+        // IO data length mismatch
+        raise_fault(SysdarftFaultType::DeviceIOError);
+        return;
+    }
+
+    // written to guest memory straight from the data stream, unless it wraps around the end of the ring
+    SysdarftFaultType fault;
+    if (const auto spans = buffer->readable_spans(); spans[1].empty())
+    {
+        fault = try_write_linear(DB + DP, reinterpret_cast<const char*>(spans[0].data()), CX);
+        buffer->consume(CX);
+    } else {
+        std::vector<uint8_t> wbuf(CX);
+        buffer->pop_span(wbuf);
+        fault = try_write_linear(DB + DP, reinterpret_cast<const char*>(wbuf.data()), CX);
+    }
 
-    auto & buffer = SysdarftIOHub::ins(port);
-    if (buffer.getSize() != CX) {
-        throw SysdarftDeviceIOError("IO data length mismatch");
+    if (fault != SysdarftFaultType::None) {
+        raise_fault(fault);
     }
-    std::vector<uint8_t> wbuf = buffer.getObject();
-    buffer.clear();
-    SysdarftCPUMemoryAccess::write_memory(DB + DP, (char*)wbuf.data(), CX);
 }
 
 void SysdarftCPUInstructionExecutor::outs(__uint128_t, WidthAndOperandsType & Operands)
 {
-    ControllerDataStream buffer;
     const auto DB = SysdarftRegister::load<DataBaseType>();
     const auto DP = SysdarftRegister::load<DataPointerType>();
     const auto CX = SysdarftRegister::load<FullyExtendedRegisterType, 3>();
     const auto & port = Operands.second[0].get_val();
+    if (fault_pending() || !require_privilege()) {
+        return;
+    }
 
     std::vector<uint8_t> wbuf;
     wbuf.resize(CX);
 
-    SysdarftCPUMemoryAccess::read_memory(DB + DP, (char*)wbuf.data(), CX);
+    if (const auto fault = try_read_linear(DB + DP, (char*)wbuf.data(), CX);
+        fault != SysdarftFaultType::None)
+    {
+        raise_fault(fault);
+        return;
+    }
+
+    ControllerDataStream buffer(CX);
     buffer.insert(wbuf);
-    SysdarftIOHub::outs(port, buffer);
+    if (const auto fault = SysdarftIOHub::outs(port, buffer); fault != SysdarftFaultType::None) {
+        raise_fault(fault);
+    }
 }
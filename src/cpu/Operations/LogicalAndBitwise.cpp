@@ -24,6 +24,10 @@ void SysdarftCPUInstructionExecutor::and_(__uint128_t, WidthAndOperandsType & Wi
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const auto result = operand1 & operand2;
     WidthAndOperands.second[0].set_val(result);
 }
@@ -32,6 +36,10 @@ void SysdarftCPUInstructionExecutor::or_(__uint128_t, WidthAndOperandsType & Wid
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const auto result = operand1 | operand2;
     WidthAndOperands.second[0].set_val(result);
 }
@@ -40,6 +48,10 @@ void SysdarftCPUInstructionExecutor::xor_(__uint128_t, WidthAndOperandsType & Wi
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const auto result = operand1 ^ operand2;
     WidthAndOperands.second[0].set_val(result);
 }
@@ -47,6 +59,10 @@ void SysdarftCPUInstructionExecutor::xor_(__uint128_t, WidthAndOperandsType & Wi
 void SysdarftCPUInstructionExecutor::not_(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const auto result = ~operand1;
     WidthAndOperands.second[0].set_val(result);
 }
@@ -55,6 +71,10 @@ void SysdarftCPUInstructionExecutor::shl(__uint128_t, WidthAndOperandsType & Wid
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const auto result = operand1 << operand2;
     WidthAndOperands.second[0].set_val(result);
 }
@@ -63,6 +83,10 @@ void SysdarftCPUInstructionExecutor::shr(__uint128_t, WidthAndOperandsType & Wid
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
+    if (fault_pending()) {
+        return;
+    }
+
     const auto result = operand1 >> operand2;
     WidthAndOperands.second[0].set_val(result);
 }
@@ -114,38 +138,36 @@ constexpr typename size_to_uint<SIZE>::type rotate_right(typename size_to_uint<S
     return (value >> n) | (value << (bits - n));
 }
 
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::rol(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
-    uint64_t result;
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  result = rotate_left<8> (static_cast<uint8_t>(operand1), operand2); break;
-    case _16bit_prefix: result = rotate_left<16>(static_cast<uint16_t>(operand1), operand2); break;
-    case _32bit_prefix: result = rotate_left<32>(static_cast<uint32_t>(operand1), operand2); break;
-    case _64bit_prefix: result = rotate_left<64>(static_cast<uint64_t>(operand1), operand2); break;
-    default: throw IllegalInstruction("Unknown width");
+    if (fault_pending()) {
+        return;
     }
 
+    const uint64_t result = rotate_left<sizeof(WidthType) * 8>(static_cast<WidthType>(operand1), operand2);
     WidthAndOperands.second[0].set_val(result);
 }
 
+instantiate_width_specialized_instruction_exec(rol);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::ror(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
-    uint64_t result;
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  result = rotate_right<8> (static_cast<uint8_t>(operand1), operand2); break;
-    case _16bit_prefix: result = rotate_right<16>(static_cast<uint16_t>(operand1), operand2); break;
-    case _32bit_prefix: result = rotate_right<32>(static_cast<uint32_t>(operand1), operand2); break;
-    case _64bit_prefix: result = rotate_right<64>(static_cast<uint64_t>(operand1), operand2); break;
-    default: throw IllegalInstruction("Unknown width");
+    if (fault_pending()) {
+        return;
     }
 
+    const uint64_t result = rotate_right<sizeof(WidthType) * 8>(static_cast<WidthType>(operand1), operand2);
     WidthAndOperands.second[0].set_val(result);
 }
 
+instantiate_width_specialized_instruction_exec(ror);
+
 // ---------------------------------------------------------------------------
 // 2) RCL: Rotate through carry LEFT by 'n' bits
 //    - value: the SIZE-bit operand
@@ -242,42 +264,43 @@ rcr(typename size_to_uint<SIZE>::type value, unsigned n, bool &cf)
     }
     return value;
 }
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::rcl(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
-    bool cf = SysdarftRegister::load<FlagRegisterType>().Carry;
-    uint64_t result;
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  result = ::rcl<8> (static_cast<uint8_t>(operand1), operand2, cf); break;
-    case _16bit_prefix: result = ::rcl<16>(static_cast<uint16_t>(operand1), operand2, cf); break;
-    case _32bit_prefix: result = ::rcl<32>(static_cast<uint32_t>(operand1), operand2, cf); break;
-    case _64bit_prefix: result = ::rcl<64>(operand1, operand2, cf); break;
-    default: throw IllegalInstruction("Unknown width");
+    if (fault_pending()) {
+        return;
     }
 
+    bool cf = SysdarftRegister::load<FlagRegisterType>().Carry;
+    const uint64_t result = ::rcl<sizeof(WidthType) * 8>(static_cast<WidthType>(operand1), operand2, cf);
+
     auto FG = SysdarftRegister::load<FlagRegisterType>();
     FG.Carry = cf;
     SysdarftRegister::store<FlagRegisterType>(FG);
     WidthAndOperands.second[0].set_val(result);
 }
 
+instantiate_width_specialized_instruction_exec(rcl);
+
+template < typename WidthType >
 void SysdarftCPUInstructionExecutor::rcr(__uint128_t, WidthAndOperandsType & WidthAndOperands)
 {
     const auto operand1 = WidthAndOperands.second[0].get_val();
     const auto operand2 = WidthAndOperands.second[1].get_val();
-    bool cf = SysdarftRegister::load<FlagRegisterType>().Carry;
-    uint64_t result;
-    switch (WidthAndOperands.first) {
-    case _8bit_prefix:  result = ::rcr<8> (static_cast<uint8_t>(operand1), operand2, cf); break;
-    case _16bit_prefix: result = ::rcr<16>(static_cast<uint16_t>(operand1), operand2, cf); break;
-    case _32bit_prefix: result = ::rcr<32>(static_cast<uint32_t>(operand1), operand2, cf); break;
-    case _64bit_prefix: result = ::rcr<64>(operand1, operand2, cf); break;
-    default: throw IllegalInstruction("Unknown width");
+    if (fault_pending()) {
+        return;
     }
 
+    bool cf = SysdarftRegister::load<FlagRegisterType>().Carry;
+    const uint64_t result = ::rcr<sizeof(WidthType) * 8>(static_cast<WidthType>(operand1), operand2, cf);
+
     auto FG = SysdarftRegister::load<FlagRegisterType>();
     FG.Carry = cf;
     SysdarftRegister::store<FlagRegisterType>(FG);
     WidthAndOperands.second[0].set_val(result);
 }
+
+instantiate_width_specialized_instruction_exec(rcr);
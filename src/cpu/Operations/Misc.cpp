@@ -27,11 +27,20 @@ void SysdarftCPUInstructionExecutor::nop(__uint128_t, WidthAndOperandsType &)
 
 void SysdarftCPUInstructionExecutor::hlt(__uint128_t, WidthAndOperandsType &)
 {
+    if (!require_privilege()) {
+        return;
+    }
+
     SystemHalted = true;
+    HaltedByGuest = true;
 }
 
 void SysdarftCPUInstructionExecutor::igni(__uint128_t, WidthAndOperandsType &)
 {
+    if (!require_privilege()) {
+        return;
+    }
+
     auto fg = SysdarftRegister::load<FlagRegisterType>();
     fg.InterruptionMask = 1;
     SysdarftRegister::store<FlagRegisterType>(fg);
@@ -39,6 +48,10 @@ void SysdarftCPUInstructionExecutor::igni(__uint128_t, WidthAndOperandsType &)
 
 void SysdarftCPUInstructionExecutor::alwi(__uint128_t, WidthAndOperandsType &)
 {
+    if (!require_privilege()) {
+        return;
+    }
+
     auto fg = SysdarftRegister::load<FlagRegisterType>();
     fg.InterruptionMask = 0;
     SysdarftRegister::store<FlagRegisterType>(fg);
@@ -0,0 +1,98 @@
+/* Paging.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <SysdarftInstructionExec.h>
+
+bool SysdarftCPUInstructionExecutor::require_privilege()
+{
+    if (user_mode()) {
+        raise_fault(SysdarftFaultType::IllegalInstruction);
+        return false;
+    }
+
+    return true;
+}
+
+void SysdarftCPUInstructionExecutor::lpt(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    const auto start = WidthAndOperands.second[0].get_val();
+    const auto entries = WidthAndOperands.second[1].get_val();
+    if (fault_pending() || !require_privilege()) {
+        return;
+    }
+
+    SysdarftRegister::store<BaseSelector>(start);
+    SysdarftRegister::store<BaseSelectorSize>(entries);
+    flush_tlb();
+    translation_changed();
+}
+
+void SysdarftCPUInstructionExecutor::tlbfl(__uint128_t, WidthAndOperandsType &)
+{
+    if (!require_privilege()) {
+        return;
+    }
+
+    flush_tlb();
+}
+
+void SysdarftCPUInstructionExecutor::invlpg(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    const auto linear_address = WidthAndOperands.second[0].get_val();
+    if (fault_pending() || !require_privilege()) {
+        return;
+    }
+
+    flush_tlb_entry(linear_address);
+}
+
+void SysdarftCPUInstructionExecutor::enpg(__uint128_t, WidthAndOperandsType &)
+{
+    if (!require_privilege()) {
+        return;
+    }
+
+    auto fg = SysdarftRegister::load<FlagRegisterType>();
+    fg.PagingEnabled = 1;
+    SysdarftRegister::store<FlagRegisterType>(fg);
+    flush_tlb();
+    translation_changed();
+}
+
+void SysdarftCPUInstructionExecutor::dspg(__uint128_t, WidthAndOperandsType &)
+{
+    if (!require_privilege()) {
+        return;
+    }
+
+    auto fg = SysdarftRegister::load<FlagRegisterType>();
+    fg.PagingEnabled = 0;
+    SysdarftRegister::store<FlagRegisterType>(fg);
+    flush_tlb();
+}
+
+void SysdarftCPUInstructionExecutor::rdpfa(__uint128_t, WidthAndOperandsType & WidthAndOperands)
+{
+    if (!require_privilege()) {
+        return;
+    }
+
+    WidthAndOperands.second[0].set_val(Registers.ProtectedModeRegisters.PageFaultAddress);
+}
@@ -258,6 +258,9 @@ void SysdarftCPUInstructionExecutor::show_context()
         log("  LessThan         = " + std::to_string((int)flags.LessThan) + "\n");
         log("  Equal            = " + std::to_string((int)flags.Equal) + "\n");
         log("  InterruptionMask = " + std::to_string((int)flags.InterruptionMask) + "\n");
+        log("  PrivilegeLevel   = " + std::to_string((int)flags.CurrentPrivilegeLevel) + "\n");
+        log("  ProtectedMode    = " + std::to_string((int)flags.ProtectedModeEnabled) + "\n");
+        log("  Paging           = " + std::to_string((int)flags.PagingEnabled) + "\n");
     }
 
     // --- 64-bit registers: StackBase, StackPointer, CodeBase, InstructionPointer,
@@ -285,6 +288,31 @@ void SysdarftCPUInstructionExecutor::show_context()
         log("CPS = 0x" + to_hex_string(cps) + "\n");
     }
 
+    // --- Guest memory ---
+    log("Memory: ", TotalMemory / 1024 / 1024, " MB configured, ",
+        resident_memory() / 1024 / 1024, " MB resident, ",
+        page_backing_name(PageBacking), " pages\n");
+
+    // --- Paging ---
+    log("Page table: 0x", to_hex_string(SysdarftRegister::load<BaseSelector>()), ", ",
+        SysdarftRegister::load<BaseSelectorSize>(), " entries, last page fault at 0x",
+        to_hex_string(Registers.ProtectedModeRegisters.PageFaultAddress), "\n");
+    log("TLB: ", TLBHits.load(), " hits, ", TLBMisses.load(), " misses, ", TLBFlushes.load(), " flushes\n");
+
+    // --- Decoded instruction cache ---
+    log("Decoded instruction cache: ",
+        (DecodedInstructionCacheEnabled ? "enabled, " : "disabled, "),
+        DecodedInstructionCacheHits.load(), " hits, ",
+        DecodedInstructionCacheMisses.load(), " misses, ",
+        FusedInstructions.load(), " fused instruction pairs\n");
+
+    // --- Basic block translator ---
+    if (ExecutionEngine == ExecutionEngineType::JIT) {
+        log("JIT: ", JITBlocksTranslated.load(), " blocks translated, ",
+            JITBlocksInvalidated.load(), " invalidated, ",
+            JITInterpretedInstructions.load(), " instructions interpreted\n");
+    }
+
     ////////////////////////////////////////////////////////////////////////////////
     // SHOW DB:DP (128 bytes)
     ////////////////////////////////////////////////////////////////////////////////
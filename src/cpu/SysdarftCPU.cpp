@@ -21,41 +21,56 @@
 #include <SysdarftCPU.h>
 #include <SysdarftDisks.h>
 #include <RealTimeClock.h>
+#include <SysdarftDMA.h>
 
-SysdarftCPU::SysdarftCPU(const uint64_t memory, const std::string & font_name,
+SysdarftCPU::SysdarftCPU(const SysdarftMemoryOptions & memory, const std::string & font_name,
     const std::vector < uint8_t > & bios,
     const std::string & hdd,
     const std::string & fda,
-    const std::string & fdb)
+    const std::string & fdb,
+    const SysdarftDiskCachePolicy disk_cache)
         : SysdarftCPUInstructionExecutor(memory, font_name)
 {
-    // load BIOS to memory
-    constexpr uint64_t off = BIOS_START;
-    uint64_t size = bios.size();
-    if (bios.size() > BIOS_SIZE) {
-        size = BIOS_SIZE;
+    // pick up where the last run on this memory image was stopped, or load BIOS to memory and boot
+    if (sysdarft_register_t state { }; take_memory_image_state(&state, sizeof(state)))
+    {
+        SysdarftRegister::store<WholeRegisterType>(state);
+        log("[CPU] Resuming from memory image\n");
     }
-    write_memory(off, (char*)bios.data(), size);
+    else
+    {
+        constexpr uint64_t off = BIOS_START;
+        uint64_t size = bios.size();
+        if (bios.size() > BIOS_SIZE) {
+            size = BIOS_SIZE;
+        }
+        write_memory(off, (char*)bios.data(), size);
+    }
+
 
+    DMADeviceListType dma_devices { };
 
     // hard disk
     if (!hdd.empty()) {
-        add_device<SysdarftBlockDevices>(hdd);
+        dma_devices[DMA_DEVICE_HDD] = &add_device<SysdarftBlockDevices>(hdd, disk_cache);
     }
 
     // floppy disk a
     if (!fda.empty()) {
-        add_device<SysdarftFloppyDiskA>(fda);
+        dma_devices[DMA_DEVICE_FDA] = &add_device<SysdarftFloppyDiskA>(fda, disk_cache);
     }
 
     // floppy disk b (not bootable)
     if (!fdb.empty()) {
-        add_device<SysdarftFloppyDiskB>(fda);
+        dma_devices[DMA_DEVICE_FDB] = &add_device<SysdarftFloppyDiskB>(fdb, disk_cache);
     }
 
     // RTC
     add_device<SysdarftRealTimeClock>(*this);
 
+    // DMA controller
+    add_device<SysdarftDMAController>(*this, dma_devices);
+
     // reset timestamp
     timestamp = 0;
 }
@@ -63,6 +78,7 @@ SysdarftCPU::SysdarftCPU(const uint64_t memory, const std::string & font_name,
 uint64_t SysdarftCPU::Boot(const bool headless, const bool with_gui)
 {
     SystemHalted = false;
+    HaltedByGuest = false;
     KeyboardIntAbort = false;
     Int3DebugInterrupt = false;
     timestamp = 0;
@@ -160,13 +176,26 @@ uint64_t SysdarftCPU::Boot(const bool headless, const bool with_gui)
         }
 
         try {
-            SysdarftCPUInstructionExecutor::execute(timestamp++);
+            if (ExecutionEngine == ExecutionEngineType::Threaded) {
+                SysdarftCPUInstructionExecutor::execute_threaded(timestamp);
+            } else if (ExecutionEngine == ExecutionEngineType::JIT) {
+                SysdarftCPUInstructionExecutor::execute_jit(timestamp);
+            } else {
+                SysdarftCPUInstructionExecutor::execute(timestamp++);
+            }
         } catch (std::exception & e) {
             std::cerr << "Unexpected error detected: " << e.what() << std::endl;
         }
     }
 
+    publish_register_snapshot();
     SysdarftCursesUI::cleanup();
 
+    // a guest that halted by itself boots again next time, one stopped from outside carries on
+    if (!HaltedByGuest) {
+        const auto state = SysdarftRegister::load<WholeRegisterType>();
+        save_memory_image_state(&state, sizeof(state));
+    }
+
     return SysdarftRegister::load<FullyExtendedRegisterType, 0>();
 }
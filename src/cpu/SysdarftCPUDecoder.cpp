@@ -18,6 +18,7 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#include <algorithm>
 #include <type_traits>
 #include <iomanip>
 #include <InstructionSet.h>
@@ -26,151 +27,142 @@
 
 uint64_t OperandType::do_access_register_based_on_table() const
 {
-    switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterWidthBCD) {
+    return do_access_register(OperandReferenceTable.OperandInfo.RegisterValue.RegisterWidthBCD,
+        OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex);
+}
+
+uint64_t OperandType::do_access_register(const uint8_t RegisterWidthBCD, const uint8_t RegisterIndex) const
+{
+    switch (RegisterWidthBCD) {
     case _8bit_prefix:
-        switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex) {
-        case 0x00: return Access.load<RegisterType, 0>();
-        case 0x01: return Access.load<RegisterType, 1>();
-        case 0x02: return Access.load<RegisterType, 2>();
-        case 0x03: return Access.load<RegisterType, 3>();
-        case 0x04: return Access.load<RegisterType, 4>();
-        case 0x05: return Access.load<RegisterType, 5>();
-        case 0x06: return Access.load<RegisterType, 6>();
-        case 0x07: return Access.load<RegisterType, 7>();
-        default: throw IllegalInstruction("Unknown Register Type");
+        switch (RegisterIndex) {
+        case 0x00: return Access->load<RegisterType, 0>();
+        case 0x01: return Access->load<RegisterType, 1>();
+        case 0x02: return Access->load<RegisterType, 2>();
+        case 0x03: return Access->load<RegisterType, 3>();
+        case 0x04: return Access->load<RegisterType, 4>();
+        case 0x05: return Access->load<RegisterType, 5>();
+        case 0x06: return Access->load<RegisterType, 6>();
+        case 0x07: return Access->load<RegisterType, 7>();
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return 0;
         }
     case _16bit_prefix:
-        switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex) {
-        case 0x00: return Access.load<ExtendedRegisterType, 0>();
-        case 0x01: return Access.load<ExtendedRegisterType, 1>();
-        case 0x02: return Access.load<ExtendedRegisterType, 2>();
-        case 0x03: return Access.load<ExtendedRegisterType, 3>();
-        case 0x04: return Access.load<ExtendedRegisterType, 4>();
-        case 0x05: return Access.load<ExtendedRegisterType, 5>();
-        case 0x06: return Access.load<ExtendedRegisterType, 6>();
-        case 0x07: return Access.load<ExtendedRegisterType, 7>();
-        default: throw IllegalInstruction("Unknown Register Type");
+        switch (RegisterIndex) {
+        case 0x00: return Access->load<ExtendedRegisterType, 0>();
+        case 0x01: return Access->load<ExtendedRegisterType, 1>();
+        case 0x02: return Access->load<ExtendedRegisterType, 2>();
+        case 0x03: return Access->load<ExtendedRegisterType, 3>();
+        case 0x04: return Access->load<ExtendedRegisterType, 4>();
+        case 0x05: return Access->load<ExtendedRegisterType, 5>();
+        case 0x06: return Access->load<ExtendedRegisterType, 6>();
+        case 0x07: return Access->load<ExtendedRegisterType, 7>();
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return 0;
         }
     case _32bit_prefix:
-        switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex) {
-        case 0x00: return Access.load<HalfExtendedRegisterType, 0>();
-        case 0x01: return Access.load<HalfExtendedRegisterType, 1>();
-        case 0x02: return Access.load<HalfExtendedRegisterType, 2>();
-        case 0x03: return Access.load<HalfExtendedRegisterType, 3>();
-        case 0x04: return Access.load<HalfExtendedRegisterType, 4>();
-        case 0x05: return Access.load<HalfExtendedRegisterType, 5>();
-        case 0x06: return Access.load<HalfExtendedRegisterType, 6>();
-        case 0x07: return Access.load<HalfExtendedRegisterType, 7>();
-        default: throw IllegalInstruction("Unknown Register Type");
+        switch (RegisterIndex) {
+        case 0x00: return Access->load<HalfExtendedRegisterType, 0>();
+        case 0x01: return Access->load<HalfExtendedRegisterType, 1>();
+        case 0x02: return Access->load<HalfExtendedRegisterType, 2>();
+        case 0x03: return Access->load<HalfExtendedRegisterType, 3>();
+        case 0x04: return Access->load<HalfExtendedRegisterType, 4>();
+        case 0x05: return Access->load<HalfExtendedRegisterType, 5>();
+        case 0x06: return Access->load<HalfExtendedRegisterType, 6>();
+        case 0x07: return Access->load<HalfExtendedRegisterType, 7>();
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return 0;
         }
     case _64bit_prefix:
-        switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex) {
-        case 0x00: return Access.load<FullyExtendedRegisterType, 0>();
-        case 0x01: return Access.load<FullyExtendedRegisterType, 1>();
-        case 0x02: return Access.load<FullyExtendedRegisterType, 2>();
-        case 0x03: return Access.load<FullyExtendedRegisterType, 3>();
-        case 0x04: return Access.load<FullyExtendedRegisterType, 4>();
-        case 0x05: return Access.load<FullyExtendedRegisterType, 5>();
-        case 0x06: return Access.load<FullyExtendedRegisterType, 6>();
-        case 0x07: return Access.load<FullyExtendedRegisterType, 7>();
-        case 0x08: return Access.load<FullyExtendedRegisterType, 8>();
-        case 0x09: return Access.load<FullyExtendedRegisterType, 9>();
-        case 0x0a: return Access.load<FullyExtendedRegisterType, 10>();
-        case 0x0b: return Access.load<FullyExtendedRegisterType, 11>();
-        case 0x0c: return Access.load<FullyExtendedRegisterType, 12>();
-        case 0x0d: return Access.load<FullyExtendedRegisterType, 13>();
-        case 0x0e: return Access.load<FullyExtendedRegisterType, 14>();
-        case 0x0f: return Access.load<FullyExtendedRegisterType, 15>();
-        case R_StackBase: return Access.load<StackBaseType>();
-        case R_StackPointer: return Access.load<StackPointerType>();
-        case R_CodeBase: return Access.load<CodeBaseType>();
-        case R_DataBase: return Access.load<DataBaseType>();
-        case R_DataPointer: return Access.load<DataPointerType>();;
-        case R_ExtendedBase: return Access.load<ExtendedBaseType>();
-        case R_ExtendedPointer: return Access.load<ExtendedPointerType>();
-        default: throw IllegalInstruction("Unknown Register Type");
+        switch (RegisterIndex) {
+        case 0x00: return Access->load<FullyExtendedRegisterType, 0>();
+        case 0x01: return Access->load<FullyExtendedRegisterType, 1>();
+        case 0x02: return Access->load<FullyExtendedRegisterType, 2>();
+        case 0x03: return Access->load<FullyExtendedRegisterType, 3>();
+        case 0x04: return Access->load<FullyExtendedRegisterType, 4>();
+        case 0x05: return Access->load<FullyExtendedRegisterType, 5>();
+        case 0x06: return Access->load<FullyExtendedRegisterType, 6>();
+        case 0x07: return Access->load<FullyExtendedRegisterType, 7>();
+        case 0x08: return Access->load<FullyExtendedRegisterType, 8>();
+        case 0x09: return Access->load<FullyExtendedRegisterType, 9>();
+        case 0x0a: return Access->load<FullyExtendedRegisterType, 10>();
+        case 0x0b: return Access->load<FullyExtendedRegisterType, 11>();
+        case 0x0c: return Access->load<FullyExtendedRegisterType, 12>();
+        case 0x0d: return Access->load<FullyExtendedRegisterType, 13>();
+        case 0x0e: return Access->load<FullyExtendedRegisterType, 14>();
+        case 0x0f: return Access->load<FullyExtendedRegisterType, 15>();
+        case R_StackBase: return Access->load<StackBaseType>();
+        case R_StackPointer: return Access->load<StackPointerType>();
+        case R_CodeBase: return Access->load<CodeBaseType>();
+        case R_DataBase: return Access->load<DataBaseType>();
+        case R_DataPointer: return Access->load<DataPointerType>();;
+        case R_ExtendedBase: return Access->load<ExtendedBaseType>();
+        case R_ExtendedPointer: return Access->load<ExtendedPointerType>();
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return 0;
         }
-    default: throw IllegalInstruction("Unknown Register Width");
+    default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return 0;
     }
 }
 
-void OperandType::do_decode_register_without_prefix()
+void OperandType::do_decode_register_without_prefix(OperandParameterEncodingType & Parameter)
 {
-    const uint8_t width = Access.pop_code8();
-    const auto register_index = Access.pop_code8();
-    OperandReferenceTable.OperandType = RegisterOperand;
-    OperandReferenceTable.OperandInfo.RegisterValue.RegisterWidthBCD = width;
-    OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex = register_index;
+    Parameter.Prefix = REGISTER_PREFIX;
+    Parameter.WidthBCD = Access->pop_code8();
+    Parameter.RegisterIndex = Access->pop_code8();
+}
+
+void OperandType::do_decode_constant_without_prefix(OperandParameterEncodingType & Parameter)
+{
+    Parameter.Prefix = CONSTANT_PREFIX;
+    Parameter.WidthBCD = Access->pop_code8();
+
+    switch (Parameter.WidthBCD) {
+    case _8bit_prefix:  Parameter.ConstantValue = Access->pop_code8(); break;
+    case _16bit_prefix: Parameter.ConstantValue = Access->pop_code16(); break;
+    case _32bit_prefix: Parameter.ConstantValue = Access->pop_code32(); break;
+    case _64bit_prefix: Parameter.ConstantValue = Access->pop_code64(); break;
+    default: Access->raise_fault(SysdarftFaultType::IllegalInstruction);
+    }
+}
+
+void OperandType::do_decode_memory_without_prefix()
+{
+    Encoding.Operand.Prefix = MEMORY_PREFIX;
+    Encoding.Operand.WidthBCD = Access->pop_code8();
 
-#ifdef __DEBUG__
-    if (width == _64bit_prefix && register_index > 15)
+    for (auto & Parameter : Encoding.MemoryParameters)
     {
-        switch (register_index) {
-        case R_StackBase: OperandReferenceTable.literal = "%SB"; break;
-        case R_StackPointer: OperandReferenceTable.literal = "%SP"; break;
-        case R_CodeBase: OperandReferenceTable.literal = "%CB"; break;
-        case R_DataBase: OperandReferenceTable.literal = "%DB"; break;
-        case R_DataPointer: OperandReferenceTable.literal = "%DP"; break;
-        case R_ExtendedBase: OperandReferenceTable.literal = "%EB"; break;
-        case R_ExtendedPointer: OperandReferenceTable.literal = "%EP"; break;
-        default: throw IllegalInstruction("Unknown register index");
+        switch(/*auto prefix = */Access->pop_code8())
+        {
+        case REGISTER_PREFIX: do_decode_register_without_prefix(Parameter); break;
+        case CONSTANT_PREFIX: do_decode_constant_without_prefix(Parameter); break;
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return;
         }
     }
-    else
+
+    Encoding.MemoryRatioBCD = Access->pop_code8();
+}
+
+void OperandType::do_decode_operand()
+{
+    switch (/*auto prefix = */Access->pop_code8())
     {
-        switch (width) {
-        case _8bit_prefix:  OperandReferenceTable.literal = "%R"   + std::to_string(register_index); break;
-        case _16bit_prefix: OperandReferenceTable.literal = "%EXR" + std::to_string(register_index); break;
-        case _32bit_prefix: OperandReferenceTable.literal = "%HER" + std::to_string(register_index); break;
-        case _64bit_prefix: OperandReferenceTable.literal = "%FER" + std::to_string(register_index); break;
-        default: throw IllegalInstruction("Unknown register type");
-        }
+        case REGISTER_PREFIX: do_decode_register_without_prefix(Encoding.Operand); break;
+        case CONSTANT_PREFIX: do_decode_constant_without_prefix(Encoding.Operand); break;
+        case MEMORY_PREFIX: do_decode_memory_without_prefix(); break;
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction);
     }
-#endif // __DEBUG__
 }
 
-void OperandType::do_decode_constant_without_prefix()
+void OperandType::do_resolve_register(const OperandParameterEncodingType & Parameter)
 {
-    OperandReferenceTable.OperandType = ConstantOperand;
-    const auto & prefix = Access.pop_code8();
-    uint64_t num;
+    OperandReferenceTable.OperandType = RegisterOperand;
+    OperandReferenceTable.OperandInfo.RegisterValue.RegisterWidthBCD = Parameter.WidthBCD;
+    OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex = Parameter.RegisterIndex;
+}
 
-#ifdef __DEBUG__
-    std::stringstream ss;
-    std::string prefix_literal;
-#endif // __DEBUG__
-
-    if (prefix == _8bit_prefix) {
-#ifdef __DEBUG__
-        prefix_literal = "8";
-#endif // __DEBUG__
-        num = Access.pop_code8();
-    } else if (prefix == _16bit_prefix) {
-#ifdef __DEBUG__
-        prefix_literal = "16";
-#endif // __DEBUG__
-        num = Access.pop_code16();
-    } else if (prefix == _32bit_prefix) {
-#ifdef __DEBUG__
-        prefix_literal = "32";
-#endif // __DEBUG__
-        num = Access.pop_code32();
-    } else if (prefix == _64bit_prefix) {
-#ifdef __DEBUG__
-        prefix_literal = "64";
-#endif // __DEBUG__
-        num = Access.pop_code64();
-    } else {
-        throw IllegalInstruction("Unknown constant width");
-    }
-
-    OperandReferenceTable.OperandInfo.ConstantValue = num;
-    OperandReferenceTable.OperandInfo.ConstantWidth = prefix;
-
-#ifdef __DEBUG__
-    ss << "0x" << std::uppercase << std::hex << num;
-    OperandReferenceTable.literal = "$" + prefix_literal + "(" + ss.str() + ")";
-#endif // __DEBUG__
+void OperandType::do_resolve_constant(const OperandParameterEncodingType & Parameter)
+{
+    OperandReferenceTable.OperandType = ConstantOperand;
+    OperandReferenceTable.OperandInfo.ConstantValue = Parameter.ConstantValue;
+    OperandReferenceTable.OperandInfo.ConstantWidth = Parameter.WidthBCD;
 }
 
 template <typename Type, unsigned BitWidth = sizeof(Type) * 8>
@@ -209,84 +201,74 @@ int64_t convert_to_64bit_signed(const Type data)
     return result;
 }
 
-void OperandType::do_decode_memory_without_prefix()
+// memory offset 2 is signed, sign extend it from its own width. false if the width is unknown
+static bool sign_extend_offset(const uint64_t val, const uint8_t WidthBCD, int64_t & result)
 {
-    const auto WidthBCD = Access.pop_code8();
-    std::string literal1, literal2, literal3;
-    uint64_t base, off1;
-    int64_t off2;
+    switch (WidthBCD) {
+    case _8bit_prefix:  result = check_msb(*(uint8_t*)&val) ?  convert_to_64bit_signed(*(uint8_t*)&val) :  static_cast<int64_t>(val); return true;
+    case _16bit_prefix: result = check_msb(*(uint16_t*)&val) ? convert_to_64bit_signed(*(uint16_t*)&val) : static_cast<int64_t>(val); return true;
+    case _32bit_prefix: result = check_msb(*(uint32_t*)&val) ? convert_to_64bit_signed(*(uint32_t*)&val) : static_cast<int64_t>(val); return true;
+    case _64bit_prefix: result = check_msb(*(uint64_t*)&val) ? convert_to_64bit_signed(*(uint64_t*)&val) : static_cast<int64_t>(val); return true;
+    default: return false;
+    }
+}
+
+void OperandType::do_resolve_memory()
+{
+    const auto WidthBCD = Encoding.Operand.WidthBCD;
+    uint64_t base = 0, off1 = 0;
+    int64_t off2 = 0;
 
-    auto decode_each_parameter = [&](std::string & literal, uint64_t & val)
+    auto resolve_each_parameter = [&](const OperandParameterEncodingType & Parameter, uint64_t & val)
     {
-        switch(/*auto prefix = */Access.pop_code8())
+        switch(Parameter.Prefix)
         {
         case REGISTER_PREFIX:
-            do_decode_register_without_prefix();
+            do_resolve_register(Parameter);
             val = do_access_register_based_on_table();
-#ifdef __DEBUG__
-            literal = OperandReferenceTable.literal;
-#endif
             break;
         case CONSTANT_PREFIX:
-            do_decode_constant_without_prefix();
-#ifdef __DEBUG__
-            literal = OperandReferenceTable.literal;
-#endif
+            do_resolve_constant(Parameter);
             val = OperandReferenceTable.OperandInfo.ConstantValue;
             break;
-        default: throw IllegalInstruction("Illegal memory operand");
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction);
         }
     };
 
-    decode_each_parameter(literal1, base);
-    decode_each_parameter(literal2, off1);
-    // decode_each_parameter(literal3, off2);
+    resolve_each_parameter(Encoding.MemoryParameters[0], base);
+    resolve_each_parameter(Encoding.MemoryParameters[1], off1);
 
-    switch(/*auto prefix = */Access.pop_code8())
+    const auto & Offset2 = Encoding.MemoryParameters[2];
+    bool off2_valid = false;
+    switch(Offset2.Prefix)
     {
-    case REGISTER_PREFIX: {
-        do_decode_register_without_prefix();
-#ifdef __DEBUG__
-        literal3 = OperandReferenceTable.literal;
-#endif
-        const auto val = do_access_register_based_on_table();
-        switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterWidthBCD) {
-        case _8bit_prefix:  off2 = check_msb(*(uint8_t*)&val) ?  convert_to_64bit_signed(*(uint8_t*)&val) :  static_cast<int64_t>(val); break;
-        case _16bit_prefix: off2 = check_msb(*(uint16_t*)&val) ? convert_to_64bit_signed(*(uint16_t*)&val) : static_cast<int64_t>(val); break;
-        case _32bit_prefix: off2 = check_msb(*(uint32_t*)&val) ? convert_to_64bit_signed(*(uint32_t*)&val) : static_cast<int64_t>(val); break;
-        case _64bit_prefix: off2 = check_msb(*(uint64_t*)&val) ? convert_to_64bit_signed(*(uint64_t*)&val) : static_cast<int64_t>(val); break;
-        default: throw IllegalInstruction("Unknown register width");
-        }
+    case REGISTER_PREFIX:
+        do_resolve_register(Offset2);
+        off2_valid = sign_extend_offset(do_access_register_based_on_table(),
+            OperandReferenceTable.OperandInfo.RegisterValue.RegisterWidthBCD, off2);
         break;
-    }
-    case CONSTANT_PREFIX: {
-        do_decode_constant_without_prefix();
-        const auto val = OperandReferenceTable.OperandInfo.ConstantValue;
-        switch (OperandReferenceTable.OperandInfo.ConstantWidth) {
-        case _8bit_prefix:  off2 = check_msb(*(uint8_t*)&val) ?  convert_to_64bit_signed(*(uint8_t*)&val) :  static_cast<int64_t>(val); break;
-        case _16bit_prefix: off2 = check_msb(*(uint16_t*)&val) ? convert_to_64bit_signed(*(uint16_t*)&val) : static_cast<int64_t>(val); break;
-        case _32bit_prefix: off2 = check_msb(*(uint32_t*)&val) ? convert_to_64bit_signed(*(uint32_t*)&val) : static_cast<int64_t>(val); break;
-        case _64bit_prefix: off2 = check_msb(*(uint64_t*)&val) ? convert_to_64bit_signed(*(uint64_t*)&val) : static_cast<int64_t>(val); break;
-        default: throw IllegalInstruction("Unknown register width");
-        }
-#ifdef __DEBUG__
-        literal3 = std::to_string(off2);
-#endif
+    case CONSTANT_PREFIX:
+        do_resolve_constant(Offset2);
+        off2_valid = sign_extend_offset(OperandReferenceTable.OperandInfo.ConstantValue,
+            OperandReferenceTable.OperandInfo.ConstantWidth, off2);
         break;
+    default: break;
     }
-    default: throw IllegalInstruction("Illegal memory operand");
+
+    if (!off2_valid) {
+        Access->raise_fault(SysdarftFaultType::IllegalInstruction);
+        return;
     }
 
-    const uint8_t ratio_bcd = Access.pop_code8();
     uint8_t ratio = 0;
 
-    switch (ratio_bcd) {
+    switch (Encoding.MemoryRatioBCD) {
     case 0x01: ratio = 1; break;
     case 0x02: ratio = 2; break;
     case 0x04: ratio = 4; break;
     case 0x08: ratio = 8; break;
     case 0x16: ratio = 16; break;
-    default: throw IllegalInstruction("Unknown ratio");
+    default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return;
     }
 
     const uint64_t calculated_address = (base + off1 + off2) * ratio;
@@ -294,48 +276,102 @@ void OperandType::do_decode_memory_without_prefix()
     OperandReferenceTable.OperandInfo.CalculatedMemoryAddress.MemoryAddress = calculated_address;
     OperandReferenceTable.OperandInfo.CalculatedMemoryAddress.MemoryWidthBCD = WidthBCD;
 
-#ifdef __DEBUG__
-    OperandReferenceTable.literal = "*" + std::to_string(ratio) + "&";
+    if (WidthBCD != _8bit_prefix
+        && WidthBCD != _16bit_prefix
+        && WidthBCD != _32bit_prefix
+        && WidthBCD != _64bit_prefix)
+    {
+        Access->raise_fault(SysdarftFaultType::IllegalInstruction);
+    }
+}
+
+void OperandType::do_resolve_operand()
+{
+    switch (Encoding.Operand.Prefix)
+    {
+        case REGISTER_PREFIX: do_resolve_register(Encoding.Operand); break;
+        case CONSTANT_PREFIX: do_resolve_constant(Encoding.Operand); break;
+        case MEMORY_PREFIX: do_resolve_memory(); break;
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction);
+    }
+}
 
+static std::string width_literal(const uint8_t WidthBCD)
+{
     switch (WidthBCD) {
-    case _8bit_prefix:  OperandReferenceTable.literal += "8"; break;
-    case _16bit_prefix: OperandReferenceTable.literal += "16"; break;
-    case _32bit_prefix: OperandReferenceTable.literal += "32"; break;
-    case _64bit_prefix: OperandReferenceTable.literal += "64"; break;
+    case _8bit_prefix:  return "8";
+    case _16bit_prefix: return "16";
+    case _32bit_prefix: return "32";
+    case _64bit_prefix: return "64";
     default: throw IllegalInstruction("Unknown width");
     }
+}
 
-    OperandReferenceTable.literal += "(" + literal1 + ", " + literal2 + ", " + literal3 + ")";
-#else
-    if (WidthBCD != _8bit_prefix
-        && WidthBCD != _16bit_prefix
-        && WidthBCD != _32bit_prefix
-        && WidthBCD != _64bit_prefix)
+static std::string register_literal(const OperandType::OperandParameterEncodingType & Parameter)
+{
+    const auto register_index = Parameter.RegisterIndex;
+    if (Parameter.WidthBCD == _64bit_prefix && register_index > 15)
     {
-        throw IllegalInstruction("Unknown width");
+        switch (register_index) {
+        case R_StackBase: return "%SB";
+        case R_StackPointer: return "%SP";
+        case R_CodeBase: return "%CB";
+        case R_DataBase: return "%DB";
+        case R_DataPointer: return "%DP";
+        case R_ExtendedBase: return "%EB";
+        case R_ExtendedPointer: return "%EP";
+        default: throw IllegalInstruction("Unknown register index");
+        }
+    }
+
+    switch (Parameter.WidthBCD) {
+    case _8bit_prefix:  return "%R"   + std::to_string(register_index);
+    case _16bit_prefix: return "%EXR" + std::to_string(register_index);
+    case _32bit_prefix: return "%HER" + std::to_string(register_index);
+    case _64bit_prefix: return "%FER" + std::to_string(register_index);
+    default: throw IllegalInstruction("Unknown register type");
     }
-#endif // __DEBUG__
 }
 
-void OperandType::do_decode_operand()
+static std::string constant_literal(const OperandType::OperandParameterEncodingType & Parameter)
 {
-    switch (/*auto prefix = */Access.pop_code8())
+    std::stringstream ss;
+    ss << "0x" << std::uppercase << std::hex << Parameter.ConstantValue;
+    return "$" + width_literal(Parameter.WidthBCD) + "(" + ss.str() + ")";
+}
+
+std::string OperandType::get_literal() const
+{
+    auto parameter_literal = [](const OperandParameterEncodingType & Parameter) -> std::string
     {
-        case REGISTER_PREFIX: do_decode_register_without_prefix(); break;
-        case CONSTANT_PREFIX: do_decode_constant_without_prefix(); break;
-        case MEMORY_PREFIX: do_decode_memory_without_prefix(); break;
-        default: throw IllegalInstruction("Unknown operand type");
+        switch (Parameter.Prefix) {
+        case REGISTER_PREFIX: return register_literal(Parameter);
+        case CONSTANT_PREFIX: return constant_literal(Parameter);
+        default: throw IllegalInstruction("Illegal memory operand");
+        }
+    };
+
+    if (Encoding.Operand.Prefix != MEMORY_PREFIX) {
+        return "<" + parameter_literal(Encoding.Operand) + ">";
     }
 
-#ifdef __DEBUG__
-    OperandReferenceTable.literal = "<" + OperandReferenceTable.literal + ">";
-    if (OperandReferenceTable.OperandType == MemoryOperand) {
-        std::stringstream ss;
-        ss << "0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(16)
-           << OperandReferenceTable.OperandInfo.CalculatedMemoryAddress.MemoryAddress;
-        OperandReferenceTable.literal += " /* = " + ss.str() + " */";
+    const auto & Offset2 = Encoding.MemoryParameters[2];
+    int64_t off2 = 0;
+    if (Offset2.Prefix == CONSTANT_PREFIX && !sign_extend_offset(Offset2.ConstantValue, Offset2.WidthBCD, off2)) {
+        throw IllegalInstruction("Unknown register width");
     }
-#endif // __DEBUG__
+
+    const auto off2_literal = Offset2.Prefix == CONSTANT_PREFIX ? std::to_string(off2) : parameter_literal(Offset2);
+
+    std::stringstream ss;
+    ss << "<*" << (Encoding.MemoryRatioBCD == 0x16 ? 16 : static_cast<int>(Encoding.MemoryRatioBCD))
+       << "&" << width_literal(Encoding.Operand.WidthBCD)
+       << "(" << parameter_literal(Encoding.MemoryParameters[0])
+       << ", " << parameter_literal(Encoding.MemoryParameters[1])
+       << ", " << off2_literal << ")> /* = "
+       << "0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(16)
+       << OperandReferenceTable.OperandInfo.CalculatedMemoryAddress.MemoryAddress << " */";
+    return ss.str();
 }
 
 uint64_t OperandType::do_access_operand_based_on_table() const
@@ -344,7 +380,7 @@ uint64_t OperandType::do_access_operand_based_on_table() const
     case RegisterOperand: return do_access_register_based_on_table();
     case MemoryOperand:   return do_access_width_specified_access_memory_based_on_table();
     case ConstantOperand: return OperandReferenceTable.OperandInfo.ConstantValue;
-    default: throw IllegalInstruction("Unknown error!");
+    default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return 0;
     }
 }
 
@@ -353,7 +389,7 @@ void OperandType::store_value_to_operand_based_on_table(const uint64_t value)
     switch (OperandReferenceTable.OperandType) {
     case RegisterOperand: store_value_to_register_based_on_table(value); break;
     case MemoryOperand:   store_value_to_memory_based_on_table(value); break;
-    default: throw IllegalInstruction("Unknown error!");
+    default: Access->raise_fault(SysdarftFaultType::IllegalInstruction);
     }
 }
 
@@ -362,156 +398,357 @@ void OperandType::store_value_to_register_based_on_table(const uint64_t value)
     switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterWidthBCD) {
     case _8bit_prefix:
         switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex) {
-        case 0x00: Access.store<RegisterType, 0>(value); break;
-        case 0x01: Access.store<RegisterType, 1>(value); break;
-        case 0x02: Access.store<RegisterType, 2>(value); break;
-        case 0x03: Access.store<RegisterType, 3>(value); break;
-        case 0x04: Access.store<RegisterType, 4>(value); break;
-        case 0x05: Access.store<RegisterType, 5>(value); break;
-        case 0x06: Access.store<RegisterType, 6>(value); break;
-        case 0x07: Access.store<RegisterType, 7>(value); break;
-        default: throw IllegalInstruction("Unknown Register Type");
+        case 0x00: Access->store<RegisterType, 0>(value); break;
+        case 0x01: Access->store<RegisterType, 1>(value); break;
+        case 0x02: Access->store<RegisterType, 2>(value); break;
+        case 0x03: Access->store<RegisterType, 3>(value); break;
+        case 0x04: Access->store<RegisterType, 4>(value); break;
+        case 0x05: Access->store<RegisterType, 5>(value); break;
+        case 0x06: Access->store<RegisterType, 6>(value); break;
+        case 0x07: Access->store<RegisterType, 7>(value); break;
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return;
         }
         break;
     case _16bit_prefix:
         switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex) {
-        case 0x00: Access.store<ExtendedRegisterType, 0>(value); break;
-        case 0x01: Access.store<ExtendedRegisterType, 1>(value); break;
-        case 0x02: Access.store<ExtendedRegisterType, 2>(value); break;
-        case 0x03: Access.store<ExtendedRegisterType, 3>(value); break;
-        case 0x04: Access.store<ExtendedRegisterType, 4>(value); break;
-        case 0x05: Access.store<ExtendedRegisterType, 5>(value); break;
-        case 0x06: Access.store<ExtendedRegisterType, 6>(value); break;
-        case 0x07: Access.store<ExtendedRegisterType, 7>(value); break;
-        default: throw IllegalInstruction("Unknown Register Type");
+        case 0x00: Access->store<ExtendedRegisterType, 0>(value); break;
+        case 0x01: Access->store<ExtendedRegisterType, 1>(value); break;
+        case 0x02: Access->store<ExtendedRegisterType, 2>(value); break;
+        case 0x03: Access->store<ExtendedRegisterType, 3>(value); break;
+        case 0x04: Access->store<ExtendedRegisterType, 4>(value); break;
+        case 0x05: Access->store<ExtendedRegisterType, 5>(value); break;
+        case 0x06: Access->store<ExtendedRegisterType, 6>(value); break;
+        case 0x07: Access->store<ExtendedRegisterType, 7>(value); break;
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return;
         }
         break;
     case _32bit_prefix:
         switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex) {
-        case 0x00: Access.store<HalfExtendedRegisterType, 0>(value); break;
-        case 0x01: Access.store<HalfExtendedRegisterType, 1>(value); break;
-        case 0x02: Access.store<HalfExtendedRegisterType, 2>(value); break;
-        case 0x03: Access.store<HalfExtendedRegisterType, 3>(value); break;
-        case 0x04: Access.store<HalfExtendedRegisterType, 4>(value); break;
-        case 0x05: Access.store<HalfExtendedRegisterType, 5>(value); break;
-        case 0x06: Access.store<HalfExtendedRegisterType, 6>(value); break;
-        case 0x07: Access.store<HalfExtendedRegisterType, 7>(value); break;
-        default: throw IllegalInstruction("Unknown Register Type");
+        case 0x00: Access->store<HalfExtendedRegisterType, 0>(value); break;
+        case 0x01: Access->store<HalfExtendedRegisterType, 1>(value); break;
+        case 0x02: Access->store<HalfExtendedRegisterType, 2>(value); break;
+        case 0x03: Access->store<HalfExtendedRegisterType, 3>(value); break;
+        case 0x04: Access->store<HalfExtendedRegisterType, 4>(value); break;
+        case 0x05: Access->store<HalfExtendedRegisterType, 5>(value); break;
+        case 0x06: Access->store<HalfExtendedRegisterType, 6>(value); break;
+        case 0x07: Access->store<HalfExtendedRegisterType, 7>(value); break;
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return;
         }
         break;
     case _64bit_prefix:
         switch (OperandReferenceTable.OperandInfo.RegisterValue.RegisterIndex) {
-        case 0x00: Access.store<FullyExtendedRegisterType, 0>(value); break;
-        case 0x01: Access.store<FullyExtendedRegisterType, 1>(value); break;
-        case 0x02: Access.store<FullyExtendedRegisterType, 2>(value); break;
-        case 0x03: Access.store<FullyExtendedRegisterType, 3>(value); break;
-        case 0x04: Access.store<FullyExtendedRegisterType, 4>(value); break;
-        case 0x05: Access.store<FullyExtendedRegisterType, 5>(value); break;
-        case 0x06: Access.store<FullyExtendedRegisterType, 6>(value); break;
-        case 0x07: Access.store<FullyExtendedRegisterType, 7>(value); break;
-        case 0x08: Access.store<FullyExtendedRegisterType, 8>(value); break;
-        case 0x09: Access.store<FullyExtendedRegisterType, 9>(value); break;
-        case 0x0a: Access.store<FullyExtendedRegisterType, 10>(value); break;
-        case 0x0b: Access.store<FullyExtendedRegisterType, 11>(value); break;
-        case 0x0c: Access.store<FullyExtendedRegisterType, 12>(value); break;
-        case 0x0d: Access.store<FullyExtendedRegisterType, 13>(value); break;
-        case 0x0e: Access.store<FullyExtendedRegisterType, 14>(value); break;
-        case 0x0f: Access.store<FullyExtendedRegisterType, 15>(value); break;
-        case R_StackBase: Access.store<StackBaseType>(value); break;
-        case R_StackPointer: Access.store<StackPointerType>(value); break;
-        case R_CodeBase: Access.store<CodeBaseType>(value); break;
-        case R_DataBase: Access.store<DataBaseType>(value); break;
-        case R_DataPointer: Access.store<DataPointerType>(value); break;
-        case R_ExtendedBase: Access.store<ExtendedBaseType>(value); break;
-        case R_ExtendedPointer: Access.store<ExtendedPointerType>(value); break;
-        default: throw IllegalInstruction("Unknown Register Type");
+        case 0x00: Access->store<FullyExtendedRegisterType, 0>(value); break;
+        case 0x01: Access->store<FullyExtendedRegisterType, 1>(value); break;
+        case 0x02: Access->store<FullyExtendedRegisterType, 2>(value); break;
+        case 0x03: Access->store<FullyExtendedRegisterType, 3>(value); break;
+        case 0x04: Access->store<FullyExtendedRegisterType, 4>(value); break;
+        case 0x05: Access->store<FullyExtendedRegisterType, 5>(value); break;
+        case 0x06: Access->store<FullyExtendedRegisterType, 6>(value); break;
+        case 0x07: Access->store<FullyExtendedRegisterType, 7>(value); break;
+        case 0x08: Access->store<FullyExtendedRegisterType, 8>(value); break;
+        case 0x09: Access->store<FullyExtendedRegisterType, 9>(value); break;
+        case 0x0a: Access->store<FullyExtendedRegisterType, 10>(value); break;
+        case 0x0b: Access->store<FullyExtendedRegisterType, 11>(value); break;
+        case 0x0c: Access->store<FullyExtendedRegisterType, 12>(value); break;
+        case 0x0d: Access->store<FullyExtendedRegisterType, 13>(value); break;
+        case 0x0e: Access->store<FullyExtendedRegisterType, 14>(value); break;
+        case 0x0f: Access->store<FullyExtendedRegisterType, 15>(value); break;
+        case R_StackBase: Access->store<StackBaseType>(value); break;
+        case R_StackPointer: Access->store<StackPointerType>(value); break;
+        case R_CodeBase: Access->store<CodeBaseType>(value); break;
+        case R_DataBase: Access->store<DataBaseType>(value); break;
+        case R_DataPointer: Access->store<DataPointerType>(value); break;
+        case R_ExtendedBase: Access->store<ExtendedBaseType>(value); break;
+        case R_ExtendedPointer: Access->store<ExtendedPointerType>(value); break;
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return;
         }
         break;
-    default: throw IllegalInstruction("Unknown Register Width");
+    default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return;
     }
 }
 
 void OperandType::store_value_to_memory_based_on_table(const uint64_t value)
 {
-    int width = 0;
+    // the instruction has already faulted, leave memory as it is
+    if (Access->fault_pending()) {
+        return;
+    }
+
+    const auto address = OperandReferenceTable.OperandInfo.CalculatedMemoryAddress.MemoryAddress;
+    SysdarftFaultType fault;
     switch (OperandReferenceTable.OperandInfo.CalculatedMemoryAddress.MemoryWidthBCD) {
-    case _8bit_prefix: width = 1; break;
-    case _16bit_prefix: width = 2; break;
-    case _32bit_prefix: width = 4; break;;
-    case _64bit_prefix: width = 8; break;
-    default: throw IllegalInstruction("Unknown Error!");
-    }
-
-    // auto DB = Access.load<DataBaseType>();
-    Access.write_memory(
-        OperandReferenceTable.OperandInfo.CalculatedMemoryAddress.MemoryAddress,
-        (const char*)&value,
-        width);
+    case _8bit_prefix:  fault = Access->try_store_linear(address, static_cast<uint8_t>(value)); break;
+    case _16bit_prefix: fault = Access->try_store_linear(address, static_cast<uint16_t>(value)); break;
+    case _32bit_prefix: fault = Access->try_store_linear(address, static_cast<uint32_t>(value)); break;
+    case _64bit_prefix: fault = Access->try_store_linear(address, value); break;
+    default: fault = SysdarftFaultType::IllegalInstruction; break;
+    }
+
+    if (fault != SysdarftFaultType::None) {
+        Access->raise_fault(fault);
+    }
 }
 
 SysdarftCPUInstructionDecoder::ActiveInstructionType
-SysdarftCPUInstructionDecoder::pop_instruction_from_ip_and_increase_ip()
+SysdarftCPUInstructionDecoder::decode_instruction_from_ip(DecodedInstructionCacheEntryType * entry)
 {
     uint8_t instruction = 0;
     ActiveInstructionType ret { };
-    std::stringstream buffer;
 
     instruction = pop_code8();
+    if (fault_pending()) {
+        return ret;
+    }
+
+    const auto & descriptor = instruction_table[instruction];
+    if (descriptor.mnemonic == nullptr) {
+        raise_fault(SysdarftFaultType::IllegalInstruction);
+        return ret;
+    }
+
+    // register instruction opcode
+    ret.opcode = instruction;
+
+    if (descriptor.require_operation_width_specification)
+    {
+        const auto width = pop_code8();
+        ret.width = width;
 
-    for (const auto &[fst, snd] : instruction_map)
+        switch (width)
+        {
+        case _8bit_prefix:
+        case _16bit_prefix:
+        case _32bit_prefix:
+        case _64bit_prefix:
+            break;
+        default:
+            raise_fault(SysdarftFaultType::IllegalInstruction);
+            return ret;
+        }
+    }
+
+    ret.handler = handler_index(ret.opcode, ret.width);
+    const auto arg_count = descriptor.argument_count;
+
+    if (entry != nullptr) {
+        entry->opcode = ret.opcode;
+        entry->width = ret.width;
+        entry->handler = ret.handler;
+        entry->operand_count = arg_count;
+    }
+
+    for (uint64_t i = 0 ; i < arg_count; i++)
     {
-        if (snd.at(ENTRY_OPCODE) == instruction)
+        ret.operands.emplace_back(*this);
+        if (fault_pending()) {
+            return ret;
+        }
+
+        if (entry != nullptr) {
+            entry->operands[i] = ret.operands.back().get_encoding();
+        }
+    }
+
+    return ret;
+}
+
+SysdarftCPUInstructionDecoder::ActiveInstructionType
+SysdarftCPUInstructionDecoder::rebuild_instruction_from_cache(const DecodedInstructionCacheEntryType & entry,
+    const bool fused)
+{
+    ActiveInstructionType ret { };
+    ret.opcode = entry.opcode;
+    ret.width = entry.width;
+    ret.handler = fused ? entry.fused_handler : entry.handler;
+
+    const uint64_t operand_count = entry.operand_count + (fused ? entry.fused_operand_count : 0);
+    for (uint64_t i = 0; i < operand_count; i++) {
+        ret.operands.emplace_back(*this, entry.operands[i]);
+    }
+
+    return ret;
+}
+
+void SysdarftCPUInstructionDecoder::fuse_next_instruction(DecodedInstructionCacheEntryType & entry)
+{
+    if (std::ranges::none_of(fused_instruction_table, [&](const auto & fused) { return fused.first == entry.opcode; })) {
+        return;
+    }
+
+    const auto IP = SysdarftRegister::load<InstructionPointerType>();
+
+    // a pair crossing a page is never fused with paging enabled, so the lookahead stays within the page entry is in
+    if (paging_enabled()) {
+        const auto linear_address = SysdarftRegister::load<CodeBaseType>() + IP - entry.length;
+        FetchLimit = (linear_address & PAGE_ADDRESS_MASK) + GUEST_PAGE_SIZE;
+    }
+
+    DecodedInstructionCacheEntryType next { };
+    decode_instruction_from_ip(&next);
+    FetchLimit = UINT64_MAX;
+
+    // the next instruction raises its fault by itself once it is reached
+    if (fault_pending()) {
+        PendingFault = SysdarftFaultType::None;
+    }
+    else
+    {
+        for (uint16_t i = 0; i < fused_instruction_table.size(); i++)
         {
-            // register instruction opcode
-            ret.opcode = instruction;
-            buffer << fst;
-
-            if (snd.at(ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION) != 0)
-            {
-                const auto width = pop_code8();
-                ret.width = width;
-
-                switch (width)
-                {
-                case _8bit_prefix:
-#ifdef __DEBUG__
-                    buffer << " .8bit ";
-#endif
-                    break;
-                case _16bit_prefix:
-#ifdef __DEBUG__
-                    buffer << " .16bit";
-#endif
-                    break;
-                case _32bit_prefix:
-#ifdef __DEBUG__
-                    buffer << " .32bit";
-#endif
-                    break;
-                case _64bit_prefix:
-#ifdef __DEBUG__
-                    buffer << " .64bit";
-#endif
-                    break;
-                default: throw IllegalInstruction("Unknown width specification");
-                }
+            if (fused_instruction_table[i].first != entry.opcode || fused_instruction_table[i].second != next.opcode) {
+                continue;
             }
 
-            const auto arg_count = snd.at(ENTRY_ARGUMENT_COUNT);
-            for (uint64_t i = 0 ; i < arg_count; i++)
-            {
-                ret.operands.emplace_back(*this);
-#ifdef __DEBUG__
-                buffer << " " << ret.operands.back().get_literal() << (i == 0 && arg_count > 1 ? "," : "");
-#endif
+            for (uint8_t operand = 0; operand < next.operand_count; operand++) {
+                entry.operands[entry.operand_count + operand] = next.operands[operand];
             }
 
-#ifdef __DEBUG__
-            ret.literal = buffer.str();
-#endif
-            return ret;
+            entry.fused_handler = fused_handler_index(i);
+            entry.fused_operand_count = next.operand_count;
+            entry.fused_length = entry.length + SysdarftRegister::load<InstructionPointerType>() - IP;
+            break;
+        }
+    }
+
+    SysdarftRegister::store<InstructionPointerType>(IP);
+}
+
+std::string SysdarftCPUInstructionDecoder::get_instruction_literal(const uint8_t opcode,
+    const uint8_t width, const OperandListType & operands)
+{
+    std::stringstream buffer;
+
+    if (instruction_table[opcode].mnemonic != nullptr) {
+        buffer << instruction_table[opcode].mnemonic;
+    }
+
+    switch (width) {
+    case _8bit_prefix:  buffer << " .8bit "; break;
+    case _16bit_prefix: buffer << " .16bit"; break;
+    case _32bit_prefix: buffer << " .32bit"; break;
+    case _64bit_prefix: buffer << " .64bit"; break;
+    default: ; // no width specification
+    }
+
+    for (uint64_t i = 0; i < operands.size(); i++) {
+        buffer << " " << operands[i].get_literal() << (i == 0 && operands.size() > 1 ? "," : "");
+    }
+
+    return buffer.str();
+}
+
+void SysdarftCPUInstructionDecoder::drop_invalidated_decoded_instructions()
+{
+    auto blocks = pop_invalidated_code_blocks();
+    for (const auto block : blocks)
+    {
+        DecodedInstructionCache.erase(block);
+
+        // instructions starting in the previous block may spill into this one
+        if (block == 0) {
+            continue;
+        }
+
+        if (const auto previous = DecodedInstructionCache.find(block - 1);
+            previous != DecodedInstructionCache.end())
+        {
+            std::erase_if(previous->second, [&](const auto & cached) {
+                return cached.first + cached.second.fused_length > block * BLOCK_SIZE;
+            });
         }
     }
 
-    throw IllegalInstruction("Unknown instruction");
+    decoded_blocks_invalidated(blocks);
+}
+
+SysdarftCPUInstructionDecoder::ActiveInstructionType
+SysdarftCPUInstructionDecoder::pop_instruction_from_ip_and_increase_ip(bool fuse)
+{
+    const auto CB = SysdarftRegister::load<CodeBaseType>();
+    const auto IP = SysdarftRegister::load<InstructionPointerType>();
+    const auto linear_address = CB + IP;
+
+    // entries are keyed by physical address, so they stay valid whatever the page table looks like
+    uint64_t physical_address;
+    if (const auto fault = translate(linear_address, GuestAccessType::Fetch, physical_address);
+        fault != SysdarftFaultType::None)
+    {
+        raise_fault(fault);
+        return { };
+    }
+
+    if (heatmap_enabled()) [[unlikely]] {
+        count_heatmap(physical_address, 1, GuestAccessType::Fetch);
+    }
+
+    if (!DecodedInstructionCacheEnabled) {
+        return decode_instruction_from_ip(nullptr);
+    }
+
+    if (CodeBlockInvalidated) {
+        drop_invalidated_decoded_instructions();
+    }
+
+    fuse = fuse && MacroOpFusionEnabled;
+
+    const auto block = physical_address / BLOCK_SIZE;
+
+    if (const auto cached_block = DecodedInstructionCache.find(block);
+        cached_block != DecodedInstructionCache.end())
+    {
+        if (const auto cached = cached_block->second.find(physical_address);
+            cached != cached_block->second.end())
+        {
+            ++DecodedInstructionCacheHits;
+            if (fuse && cached->second.fused_handler != 0) {
+                ++FusedInstructions;
+                FusedJumpLength = cached->second.fused_length - cached->second.length;
+                SysdarftRegister::store<InstructionPointerType>(IP + cached->second.fused_length);
+                return rebuild_instruction_from_cache(cached->second, true);
+            }
+
+            SysdarftRegister::store<InstructionPointerType>(IP + cached->second.length);
+            return rebuild_instruction_from_cache(cached->second, false);
+        }
+    }
+
+    ++DecodedInstructionCacheMisses;
+
+    // mark before decoding, so a write racing with the decoder still invalidates the entry
+    mark_code_block(block);
+    mark_code_block(block + 1);
+
+    DecodedInstructionCacheEntryType entry { };
+    auto ret = decode_instruction_from_ip(&entry);
+
+    // a faulting instruction is decoded again every time, it is never cached
+    if (fault_pending()) {
+        return ret;
+    }
+
+    entry.length = entry.fused_length = SysdarftRegister::load<InstructionPointerType>() - IP;
+
+    // the next page may live anywhere in physical memory, an instruction crossing into it is never cached
+    const auto page_offset = linear_address % GUEST_PAGE_SIZE;
+    if (paging_enabled() && page_offset + entry.length > GUEST_PAGE_SIZE) {
+        return ret;
+    }
+
+    fuse_next_instruction(entry);
+    if (paging_enabled() && page_offset + entry.fused_length > GUEST_PAGE_SIZE) {
+        entry.fused_handler = 0;
+        entry.fused_operand_count = 0;
+        entry.fused_length = entry.length;
+    }
+
+    DecodedInstructionCache[block].insert_or_assign(physical_address, entry);
+
+    if (fuse && entry.fused_handler != 0) {
+        ++FusedInstructions;
+        FusedJumpLength = entry.fused_length - entry.length;
+        SysdarftRegister::store<InstructionPointerType>(IP + entry.fused_length);
+        return rebuild_instruction_from_cache(entry, true);
+    }
+
+    return ret;
 }
@@ -40,7 +40,7 @@ void flush_stdin()
 
 #endif
 
-SysdarftCPUInterruption::SysdarftCPUInterruption(const uint64_t memory, const std::string & font_name) :
+SysdarftCPUInterruption::SysdarftCPUInterruption(const SysdarftMemoryOptions & memory, const std::string & font_name) :
     DecoderDataAccess(memory, font_name)
 {
     // Get the current flags for stdin (file descriptor 0)
@@ -70,7 +70,8 @@ std::atomic_bool cleared{false};
 void SysdarftCPUInterruption::do_interruption(const uint64_t code)
 {
     if (code > MAX_INTERRUPTION_ENTRY) {
-        throw SysdarftBadInterruption("Interruption out of range");
+        raise_fault(SysdarftFaultType::BadInterruption);
+        return;
     }
 
     auto fg = SysdarftRegister::load<FlagRegisterType>();
@@ -79,6 +80,7 @@ void SysdarftCPUInterruption::do_interruption(const uint64_t code)
     {
         // mask
         fg.InterruptionMask = 1;
+        enter_interruption_privilege_level(fg);
         SysdarftRegister::store<FlagRegisterType>(fg);
     };
 
@@ -232,11 +234,13 @@ void SysdarftCPUInterruption::do_interruption(const uint64_t code)
     }
 }
 
-void SysdarftCPUInterruption::do_ext_dev_interruption(const uint64_t code)
+void SysdarftCPUInterruption::do_ext_dev_interruption(const uint64_t code, const bool wait)
 {
     if (code > 0x1F && code < MAX_INTERRUPTION_ENTRY)
     {
-        if (!External_Int_Req_Vec_Protector.try_lock()) {
+        if (wait) {
+            External_Int_Req_Vec_Protector.lock();
+        } else if (!External_Int_Req_Vec_Protector.try_lock()) {
             log("External device interruption ignored, number ", code, "\n");
             return; // ignore this interruption, the system is currently masked
             // (the system processing other hardware interruptions, bus not free)
@@ -267,7 +271,11 @@ void SysdarftCPUInterruption::do_preserve_cpu_state()
 {
     const auto SB = SysdarftRegister::load<StackBaseType>();
     auto SP = SysdarftRegister::load<StackPointerType>();
-    DecoderDataAccess::push_memory_to(SB, SP, SysdarftRegister::Registers);
+    // the state cannot be preserved anywhere, be it an overflow or a page fault
+    if (try_push_linear_to(SB, SP, SysdarftRegister::load<WholeRegisterType>()) != SysdarftFaultType::None) {
+        throw StackOverflow();
+    }
+
     SysdarftRegister::store<StackPointerType>(SP);
 }
 
@@ -281,7 +289,17 @@ void SysdarftCPUInterruption::do_iret()
 {
     const auto SB = SysdarftRegister::load<StackBaseType>();
     auto SP = SysdarftRegister::load<StackPointerType>();
-    SysdarftRegister::Registers = DecoderDataAccess::pop_memory_from<sysdarft_register_t>(SB, SP);
+    sysdarft_register_t preserved { };
+    if (const auto fault = try_pop_linear_from(SB, SP, preserved);
+        fault != SysdarftFaultType::None)
+    {
+        raise_fault(fault);
+        return;
+    }
+
+    const auto previous = SysdarftRegister::load<WholeRegisterType>();
+    SysdarftRegister::store<WholeRegisterType>(preserved);
+    restore_privileged_state(previous);
     // iret doesn't need to reset IM
 }
 
@@ -330,7 +348,9 @@ void SysdarftCPUInterruption::do_interruption_set_cur_pos_0x11()
 {
     const auto linear = SysdarftRegister::load<ExtendedRegisterType, 0>();
     if (linear > V_WIDTH * V_HEIGHT - 1) {
-        throw SysdarftBadInterruption("Teletype linear address out of range");
+        // Teletype linear address out of range
+        raise_fault(SysdarftFaultType::BadInterruption);
+        return;
     }
     const auto y = linear / V_WIDTH, x = linear % V_WIDTH;
     SysdarftCursesUI::set_cursor(x, y);
@@ -18,82 +18,53 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#include <algorithm>
 #include <SysdarftInstructionExec.h>
 #include <InstructionSet.h>
 
-SysdarftCPUInstructionExecutor::SysdarftCPUInstructionExecutor(const uint64_t memory, const std::string & font_name)
-    : SysdarftCPUInstructionDecoder(memory, font_name)
+constexpr std::array<SysdarftCPUInstructionExecutor::ExecutorType, SysdarftCPUInstructionExecutor::INSTRUCTION_HANDLER_COUNT>
+SysdarftCPUInstructionExecutor::ExecutorTable = []
 {
-    // Misc
-    make_instruction_execution_procedure(OPCODE_NOP, &SysdarftCPUInstructionExecutor::nop);
-    make_instruction_execution_procedure(OPCODE_HLT, &SysdarftCPUInstructionExecutor::hlt);
-    make_instruction_execution_procedure(OPCODE_IGNI, &SysdarftCPUInstructionExecutor::igni);
-    make_instruction_execution_procedure(OPCODE_ALWI, &SysdarftCPUInstructionExecutor::alwi);
-
-    // Arithmetic
-    make_instruction_execution_procedure(OPCODE_ADD, &SysdarftCPUInstructionExecutor::add);
-    make_instruction_execution_procedure(OPCODE_ADC, &SysdarftCPUInstructionExecutor::adc);
-    make_instruction_execution_procedure(OPCODE_SUB, &SysdarftCPUInstructionExecutor::sub);
-    make_instruction_execution_procedure(OPCODE_SBB, &SysdarftCPUInstructionExecutor::sbb);
-    make_instruction_execution_procedure(OPCODE_IMUL, &SysdarftCPUInstructionExecutor::imul);
-    make_instruction_execution_procedure(OPCODE_MUL, &SysdarftCPUInstructionExecutor::mul);
-    make_instruction_execution_procedure(OPCODE_IDIV, &SysdarftCPUInstructionExecutor::idiv);
-    make_instruction_execution_procedure(OPCODE_DIV, &SysdarftCPUInstructionExecutor::div);
-    make_instruction_execution_procedure(OPCODE_NEG, &SysdarftCPUInstructionExecutor::neg);
-    make_instruction_execution_procedure(OPCODE_CMP, &SysdarftCPUInstructionExecutor::cmp);
-    make_instruction_execution_procedure(OPCODE_INC, &SysdarftCPUInstructionExecutor::inc);
-    make_instruction_execution_procedure(OPCODE_DEC, &SysdarftCPUInstructionExecutor::dec);
-
-    // Data Transfer
-    make_instruction_execution_procedure(OPCODE_MOV, &SysdarftCPUInstructionExecutor::mov);
-    make_instruction_execution_procedure(OPCODE_XCHG, &SysdarftCPUInstructionExecutor::xchg);
-    make_instruction_execution_procedure(OPCODE_PUSH, &SysdarftCPUInstructionExecutor::push);
-    make_instruction_execution_procedure(OPCODE_POP, &SysdarftCPUInstructionExecutor::pop);
-    make_instruction_execution_procedure(OPCODE_PUSHALL, &SysdarftCPUInstructionExecutor::pushall);
-    make_instruction_execution_procedure(OPCODE_POPALL, &SysdarftCPUInstructionExecutor::popall);
-    make_instruction_execution_procedure(OPCODE_ENTER, &SysdarftCPUInstructionExecutor::enter);
-    make_instruction_execution_procedure(OPCODE_LEAVE, &SysdarftCPUInstructionExecutor::leave);
-    make_instruction_execution_procedure(OPCODE_MOVS, &SysdarftCPUInstructionExecutor::movs);
-    make_instruction_execution_procedure(OPCODE_LEA, &SysdarftCPUInstructionExecutor::lea);
-
-    // Logic and Bitwise
-    make_instruction_execution_procedure(OPCODE_AND, &SysdarftCPUInstructionExecutor::and_);
-    make_instruction_execution_procedure(OPCODE_OR, &SysdarftCPUInstructionExecutor::or_);
-    make_instruction_execution_procedure(OPCODE_XOR, &SysdarftCPUInstructionExecutor::xor_);
-    make_instruction_execution_procedure(OPCODE_NOT, &SysdarftCPUInstructionExecutor::not_);
-    make_instruction_execution_procedure(OPCODE_SHL, &SysdarftCPUInstructionExecutor::shl);
-    make_instruction_execution_procedure(OPCODE_SHR, &SysdarftCPUInstructionExecutor::shr);
-    make_instruction_execution_procedure(OPCODE_ROL, &SysdarftCPUInstructionExecutor::rol);
-    make_instruction_execution_procedure(OPCODE_ROR, &SysdarftCPUInstructionExecutor::ror);
-    make_instruction_execution_procedure(OPCODE_RCL, &SysdarftCPUInstructionExecutor::rcl);
-    make_instruction_execution_procedure(OPCODE_RCR, &SysdarftCPUInstructionExecutor::rcr);
-
-    // Controlflow
-    make_instruction_execution_procedure(OPCODE_JMP, &SysdarftCPUInstructionExecutor::jmp);
-    make_instruction_execution_procedure(OPCODE_CALL, &SysdarftCPUInstructionExecutor::call);
-    make_instruction_execution_procedure(OPCODE_RET, &SysdarftCPUInstructionExecutor::ret);
-    make_instruction_execution_procedure(OPCODE_JE, &SysdarftCPUInstructionExecutor::je);
-    make_instruction_execution_procedure(OPCODE_JNE, &SysdarftCPUInstructionExecutor::jne);
-    make_instruction_execution_procedure(OPCODE_JB, &SysdarftCPUInstructionExecutor::jb);
-    make_instruction_execution_procedure(OPCODE_JL, &SysdarftCPUInstructionExecutor::jl);
-    make_instruction_execution_procedure(OPCODE_JBE, &SysdarftCPUInstructionExecutor::jbe);
-    make_instruction_execution_procedure(OPCODE_JLE, &SysdarftCPUInstructionExecutor::jle);
-    make_instruction_execution_procedure(OPCODE_INT, &SysdarftCPUInstructionExecutor::int_);
-    make_instruction_execution_procedure(OPCODE_INT3, &SysdarftCPUInstructionExecutor::int3);
-    make_instruction_execution_procedure(OPCODE_IRET, &SysdarftCPUInstructionExecutor::iret);
-    make_instruction_execution_procedure(OPCODE_LOOP, &SysdarftCPUInstructionExecutor::loop);
-
-    // IOH
-    make_instruction_execution_procedure(OPCODE_IN, &SysdarftCPUInstructionExecutor::in);
-    make_instruction_execution_procedure(OPCODE_OUT, &SysdarftCPUInstructionExecutor::out);
-    make_instruction_execution_procedure(OPCODE_INS, &SysdarftCPUInstructionExecutor::ins);
-    make_instruction_execution_procedure(OPCODE_OUTS, &SysdarftCPUInstructionExecutor::outs);
+    std::array<ExecutorType, INSTRUCTION_HANDLER_COUNT> table { };
+
+    // one executor for every width
+#define SYSDARFT_INSTRUCTION_EXECUTOR_0(code, executor)                                     \
+    for (uint16_t slot = 0; slot < OPERATION_WIDTH_SLOTS; slot++) {                         \
+        table[code * OPERATION_WIDTH_SLOTS + slot] = &SysdarftCPUInstructionExecutor::executor; \
+    }
+#define SYSDARFT_INSTRUCTION_EXECUTOR_1(code, executor) SYSDARFT_INSTRUCTION_EXECUTOR_0(code, executor)
+    // one instantiation per width
+#define SYSDARFT_INSTRUCTION_EXECUTOR_2(code, executor)                                                     \
+    table[handler_index(code, _8bit_prefix)]  = &SysdarftCPUInstructionExecutor::executor<uint8_t>;         \
+    table[handler_index(code, _16bit_prefix)] = &SysdarftCPUInstructionExecutor::executor<uint16_t>;        \
+    table[handler_index(code, _32bit_prefix)] = &SysdarftCPUInstructionExecutor::executor<uint32_t>;        \
+    table[handler_index(code, _64bit_prefix)] = &SysdarftCPUInstructionExecutor::executor<uint64_t>;
+#define SYSDARFT_INSTRUCTION_EXECUTOR(name, code, executor, argc, width) \
+    SYSDARFT_INSTRUCTION_EXECUTOR_##width(code, executor)
+    SYSDARFT_INSTRUCTION_SET(SYSDARFT_INSTRUCTION_EXECUTOR)
+#undef SYSDARFT_INSTRUCTION_EXECUTOR
+#undef SYSDARFT_INSTRUCTION_EXECUTOR_2
+#undef SYSDARFT_INSTRUCTION_EXECUTOR_1
+#undef SYSDARFT_INSTRUCTION_EXECUTOR_0
 
+    uint16_t fused = 0;
+#define SYSDARFT_FUSED_INSTRUCTION_EXECUTOR(first, second, executor) \
+    table[fused_handler_index(fused++)] = &SysdarftCPUInstructionExecutor::executor;
+    SYSDARFT_FUSED_INSTRUCTION_SET(SYSDARFT_FUSED_INSTRUCTION_EXECUTOR)
+#undef SYSDARFT_FUSED_INSTRUCTION_EXECUTOR
+
+    return table;
+}();
+
+SysdarftCPUInstructionExecutor::SysdarftCPUInstructionExecutor(const SysdarftMemoryOptions & memory, const std::string & font_name)
+    : SysdarftCPUInstructionDecoder(memory, font_name)
+{
     // Debug Handler
     bindBreakpointHandler(this, &SysdarftCPUInstructionExecutor::default_breakpoint_handler);
     bindIsBreakHere(this, &SysdarftCPUInstructionExecutor::default_is_break_here);
 }
 
+#ifdef __DEBUG__
 inline std::string to_hex_string(const uint64_t value)
 {
     std::stringstream ss;
@@ -101,91 +72,277 @@ inline std::string to_hex_string(const uint64_t value)
     return ss.str();
 }
 
-void SysdarftCPUInstructionExecutor::execute(const __uint128_t timestamp)
+inline std::string operand_values(const OperandListType & operands)
+{
+    return operands.size() == 2 ?
+        " /* " + operands.at(0).get_literal() + " == " + to_hex_string(operands.at(0).get_val()) + ", "
+               + operands.at(1).get_literal() + " == " + to_hex_string(operands.at(1).get_val()) + " */"
+        : operands.size() == 1 ?
+        " /* " + operands.at(0).get_literal() + " == " + to_hex_string(operands.at(0).get_val()) + " */"
+        : "";
+}
+
+// instructions taking %FER3 as their count, it is shown alongside the operands
+static bool counts_with_fer3(const uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case OPCODE_LOOP:
+    case OPCODE_MOVS:
+    case OPCODE_STOS:
+    case OPCODE_CMPS:
+    case OPCODE_SCAS:
+    case OPCODE_INS:
+    case OPCODE_OUTS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void SysdarftCPUInstructionExecutor::log_instruction(const uint8_t opcode, const WidthAndOperandsType & Arg)
+{
+    if (debug::verbose) {
+        log(get_instruction_literal(opcode, Arg.first, Arg.second), operand_values(Arg.second));
+        if (counts_with_fer3(opcode)) {
+            log(" /* %FER3 == ", SysdarftRegister::load<FullyExtendedRegisterType, 3>(), " */");
+        }
+    }
+}
+
+void SysdarftCPUInstructionExecutor::log_instruction_result(const uint8_t opcode, const WidthAndOperandsType & Arg)
+{
+    if (debug::verbose) {
+        log(" >", operand_values(Arg.second));
+        if (counts_with_fer3(opcode)) {
+            log(" /* %FER3 == ", SysdarftRegister::load<FullyExtendedRegisterType, 3>(), " */\n");
+        } else {
+            log("\n");
+        }
+
+        // flush the fuck out of stderr
+        std::cerr << std::flush << std::flush << std::flush << std::flush << std::flush << std::flush;
+    }
+}
+#endif
+
+void SysdarftCPUInstructionExecutor::deliver_pending_fault()
+{
+    const auto fault = PendingFault;
+    PendingFault = SysdarftFaultType::None;
+
+    switch (fault) {
+    case SysdarftFaultType::None: return;
+    case SysdarftFaultType::IllegalInstruction: do_interruption(INT_ILLEGAL_INSTRUCTION); return;
+    case SysdarftFaultType::StackOverflow: do_interruption(INT_STACKOVERFLOW); return;
+    case SysdarftFaultType::IllegalMemoryAccess: do_interruption(INT_ILLEGAL_MEMORY_ACCESS); return;
+    case SysdarftFaultType::BadInterruption: do_interruption(INT_BAD_INTR); return;
+    case SysdarftFaultType::DeviceIOError:
+        SysdarftRegister::store<ExtendedRegisterType, 0>(0xF0);
+        do_interruption(INT_IO_ERROR);
+        return;
+    case SysdarftFaultType::NoSuchDevice:
+        SysdarftRegister::store<ExtendedRegisterType, 0>(0xF1);
+        do_interruption(INT_IO_ERROR);
+        return;
+    case SysdarftFaultType::PageFault: do_interruption(INT_PAGE_FAULT); return;
+    case SysdarftFaultType::Fatal: do_interruption(INT_FATAL); return;
+    }
+}
+
+template < typename ProcedureType >
+void SysdarftCPUInstructionExecutor::handle_execution_errors(ProcedureType && procedure)
 {
     try {
-        try
-        {
-            ip_before_pop = SysdarftRegister::load<InstructionPointerType>();
-            const bool breakpoint_reached = is_break_here(timestamp);
+        try {
+            procedure();
+        } catch (SysdarftBaseError &) {
+            // host side error escaped from the instruction, all the guest gets to see is a fatal error
+            PendingFault = SysdarftFaultType::None;
+            raise_fault(SysdarftFaultType::Fatal);
+        }
 
-            const auto &[opcode, width, operands, literal]
-                = SysdarftCPUInstructionDecoder::pop_instruction_from_ip_and_increase_ip();
-            WidthAndOperandsType Arg = std::make_pair(width, operands);
+        if (fault_pending()) {
+            deliver_pending_fault();
+        }
+    } catch (SysdarftCPUSubroutineRequestToAbortTheCurrentInstructionExecutionProcedureDueToError&) {
+        return; // Abort this routine
+    }
+}
 
-            current_routine_pop_len = SysdarftRegister::load<InstructionPointerType>() - ip_before_pop;
+uint16_t SysdarftCPUInstructionExecutor::fetch_instruction(const __uint128_t timestamp, WidthAndOperandsType & Arg)
+{
+    publish_register_snapshot();
+
+    ip_before_pop = SysdarftRegister::load<InstructionPointerType>();
+    const bool breakpoint_reached = is_break_here(timestamp);
 
+    // a debugger and the verbose log want to see every single instruction
+    bool fuse = !breakpoints_bound;
 #ifdef __DEBUG__
-            if (debug::verbose) {
-                log(literal,
-                    (operands.size() == 2 ?
-                        " /* " + operands.at(0).get_literal() + " == " + to_hex_string(operands.at(0).get_val()) + ", "
-                               + operands.at(1).get_literal() + " == " + to_hex_string(operands.at(1).get_val()) + " */"
-                        : operands.size() == 1 ?
-                        " /* " + operands.at(0).get_literal() + " == " + to_hex_string(operands.at(0).get_val()) + " */"
-                        : ""));
-                if (opcode == OPCODE_LOOP || opcode == OPCODE_MOVS || opcode == OPCODE_INS || opcode == OPCODE_OUTS) {
-                    log(" /* %FER3 == ", SysdarftRegister::load<FullyExtendedRegisterType, 3>(), " */");
-                }
-            }
+    fuse = fuse && !debug::verbose;
 #endif
 
-            if (Int3DebugInterrupt || breakpoint_reached)
-            {
-                Int3DebugInterrupt = false;
-                breakpoint_handler(timestamp, ip_before_pop, opcode, Arg);
-            }
+    const auto [opcode, width, operands, handler]
+        = SysdarftCPUInstructionDecoder::pop_instruction_from_ip_and_increase_ip(fuse);
+    Arg.first = width;
+    Arg.second = operands;
+
+    // the instruction is not executed, the caller delivers the fault instead
+    if (fault_pending()) {
+        return handler;
+    }
+
+    current_routine_pop_len = SysdarftRegister::load<InstructionPointerType>() - ip_before_pop;
 
-            (this->*ExecutorMap.at(opcode))(timestamp, Arg);
 #ifdef __DEBUG__
-            if (debug::verbose) {
-                log(" >",
-                    (operands.size() == 2 ?
-                        " /* " + operands.at(0).get_literal() + " == " + to_hex_string(operands.at(0).get_val()) + ", "
-                               + operands.at(1).get_literal() + " == " + to_hex_string(operands.at(1).get_val()) + " */"
-                        : operands.size() == 1 ?
-                        " /* " + operands.at(0).get_literal() + " == " + to_hex_string(operands.at(0).get_val()) + " */"
-                        : ""));
-                if (opcode == OPCODE_LOOP || opcode == OPCODE_MOVS || opcode == OPCODE_INS || opcode == OPCODE_OUTS) {
-                    log(" /* %FER3 == ", SysdarftRegister::load<FullyExtendedRegisterType, 3>(), " */\n");
-                } else {
-                    log("\n");
-                }
-
-                // flush the fuck out of stderr
-                std::cerr << std::flush << std::flush << std::flush << std::flush << std::flush << std::flush;
-            }
+    log_instruction(opcode, Arg);
 #endif
+
+    if (Int3DebugInterrupt || breakpoint_reached)
+    {
+        Int3DebugInterrupt = false;
+        breakpoint_handler(timestamp, ip_before_pop, opcode, Arg);
+    }
+
+    return handler;
+}
+
+void SysdarftCPUInstructionExecutor::execute(const __uint128_t timestamp)
+{
+    handle_execution_errors([&]
+    {
+        WidthAndOperandsType Arg;
+        const auto handler = fetch_instruction(timestamp, Arg);
+        if (fault_pending()) {
+            return;
         }
-        catch (SysdarftDeviceIOError&) {
-            SysdarftRegister::store<ExtendedRegisterType, 0>(0xF0);
-            do_interruption(INT_IO_ERROR);
-        }
-        catch (SysdarftBadInterruption &) {
-            do_interruption(INT_BAD_INTR);
-        }
-        catch (SysdarftInterruptionOutOfRange &) {
-            do_interruption(INT_BAD_INTR);
-        }
-        catch (IllegalInstruction &) {
-            do_interruption(INT_ILLEGAL_INSTRUCTION);
-        }
-        catch (StackOverflow &) {
-            do_interruption(INT_STACKOVERFLOW);
-        }
-        catch (IllegalMemoryAccessException &) {
-            do_interruption(INT_ILLEGAL_MEMORY_ACCESS);
-        }
-        catch (SysdarftNoSuchDevice &) {
-            SysdarftRegister::store<ExtendedRegisterType, 0>(0xF1);
-            do_interruption(INT_IO_ERROR);
-        }
-        catch (SysdarftBaseError &) {
-            do_interruption(INT_FATAL);
+
+        (this->*ExecutorTable[handler])(timestamp, Arg);
+#ifdef __DEBUG__
+        if (!fault_pending()) {
+            log_instruction_result(handler_opcode(handler), Arg);
         }
-    } catch (SysdarftCPUSubroutineRequestToAbortTheCurrentInstructionExecutionProcedureDueToError&) {
-        return; // Abort this routine
-    } catch (std::exception &) {
-        throw;
+#endif
+    });
+}
+
+bool SysdarftCPUInstructionExecutor::execution_event_pending() const
+{
+    return SystemHalted || KeyboardIntAbort || CtrlZShutdownRequested || external_device_requested;
+}
+
+// labels as values and computed gotos are GNU extensions, which are the point of this function
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+void SysdarftCPUInstructionExecutor::run_threaded(__uint128_t & timestamp)
+{
+    // Label addresses are only visible inside this function, so the table is built on entry
+    // handler indexed, like ExecutorTable
+    void * dispatch_table[INSTRUCTION_HANDLER_COUNT];
+    std::ranges::fill(dispatch_table, &&illegal_instruction);
+#define SYSDARFT_THREADED_LABEL_0(code, executor)                           \
+    for (uint16_t slot = 0; slot < OPERATION_WIDTH_SLOTS; slot++) {         \
+        dispatch_table[code * OPERATION_WIDTH_SLOTS + slot] = &&handler_##executor; \
+    }
+#define SYSDARFT_THREADED_LABEL_1(code, executor) SYSDARFT_THREADED_LABEL_0(code, executor)
+#define SYSDARFT_THREADED_LABEL_2(code, executor)                               \
+    dispatch_table[handler_index(code, _8bit_prefix)]  = &&handler_##executor##_8;  \
+    dispatch_table[handler_index(code, _16bit_prefix)] = &&handler_##executor##_16; \
+    dispatch_table[handler_index(code, _32bit_prefix)] = &&handler_##executor##_32; \
+    dispatch_table[handler_index(code, _64bit_prefix)] = &&handler_##executor##_64;
+#define SYSDARFT_THREADED_LABEL(name, code, executor, argc, width) \
+    SYSDARFT_THREADED_LABEL_##width(code, executor)
+    SYSDARFT_INSTRUCTION_SET(SYSDARFT_THREADED_LABEL)
+#undef SYSDARFT_THREADED_LABEL
+#undef SYSDARFT_THREADED_LABEL_2
+#undef SYSDARFT_THREADED_LABEL_1
+#undef SYSDARFT_THREADED_LABEL_0
+
+    uint16_t fused = 0;
+#define SYSDARFT_FUSED_THREADED_LABEL(first, second, executor) \
+    dispatch_table[fused_handler_index(fused++)] = &&handler_##executor;
+    SYSDARFT_FUSED_INSTRUCTION_SET(SYSDARFT_FUSED_THREADED_LABEL)
+#undef SYSDARFT_FUSED_THREADED_LABEL
+
+    WidthAndOperandsType Arg;
+    __uint128_t current_timestamp;
+    uint16_t handler;
+
+    // deliver the fault of the previous instruction if any, then fetch, decode and dispatch.
+    // inlined into the tail of every handler
+#define SYSDARFT_THREADED_DISPATCH()                        \
+    if (fault_pending()) {                                  \
+        deliver_pending_fault();                            \
+    }                                                       \
+    if (execution_event_pending()) {                        \
+        return;                                             \
+    }                                                       \
+    current_timestamp = timestamp++;                        \
+    handler = fetch_instruction(current_timestamp, Arg);    \
+    if (fault_pending()) {                                  \
+        goto instruction_fault;                             \
+    }                                                       \
+    goto *dispatch_table[handler]
+
+#ifdef __DEBUG__
+# define SYSDARFT_THREADED_LOG_RESULT() if (!fault_pending()) log_instruction_result(handler_opcode(handler), Arg)
+#else
+# define SYSDARFT_THREADED_LOG_RESULT() static_cast<void>(handler)
+#endif
+
+    SYSDARFT_THREADED_DISPATCH();
+
+#define SYSDARFT_THREADED_HANDLER_0(executor)                       \
+handler_##executor:                                                 \
+    executor(current_timestamp, Arg);                               \
+    SYSDARFT_THREADED_LOG_RESULT();                                 \
+    SYSDARFT_THREADED_DISPATCH();
+#define SYSDARFT_THREADED_HANDLER_1(executor) SYSDARFT_THREADED_HANDLER_0(executor)
+#define SYSDARFT_THREADED_WIDTH_HANDLER(executor, bits)             \
+handler_##executor##_##bits:                                        \
+    executor<uint##bits##_t>(current_timestamp, Arg);               \
+    SYSDARFT_THREADED_LOG_RESULT();                                 \
+    SYSDARFT_THREADED_DISPATCH();
+#define SYSDARFT_THREADED_HANDLER_2(executor)                       \
+    SYSDARFT_THREADED_WIDTH_HANDLER(executor, 8)                    \
+    SYSDARFT_THREADED_WIDTH_HANDLER(executor, 16)                   \
+    SYSDARFT_THREADED_WIDTH_HANDLER(executor, 32)                   \
+    SYSDARFT_THREADED_WIDTH_HANDLER(executor, 64)
+#define SYSDARFT_THREADED_HANDLER(name, code, executor, argc, width) \
+    SYSDARFT_THREADED_HANDLER_##width(executor)
+    SYSDARFT_INSTRUCTION_SET(SYSDARFT_THREADED_HANDLER)
+#undef SYSDARFT_THREADED_HANDLER
+#define SYSDARFT_FUSED_THREADED_HANDLER(first, second, executor) \
+    SYSDARFT_THREADED_HANDLER_0(executor)
+    SYSDARFT_FUSED_INSTRUCTION_SET(SYSDARFT_FUSED_THREADED_HANDLER)
+#undef SYSDARFT_FUSED_THREADED_HANDLER
+#undef SYSDARFT_THREADED_HANDLER_2
+#undef SYSDARFT_THREADED_WIDTH_HANDLER
+#undef SYSDARFT_THREADED_HANDLER_1
+#undef SYSDARFT_THREADED_HANDLER_0
+
+illegal_instruction:
+    raise_fault(SysdarftFaultType::IllegalInstruction);
+
+instruction_fault:
+    SYSDARFT_THREADED_DISPATCH();
+
+#undef SYSDARFT_THREADED_LOG_RESULT
+#undef SYSDARFT_THREADED_DISPATCH
+}
+#pragma GCC diagnostic pop
+
+void SysdarftCPUInstructionExecutor::execute_threaded(__uint128_t & timestamp)
+{
+    while (!execution_event_pending()) {
+        handle_execution_errors([&] { run_threaded(timestamp); });
+    }
+}
+
+void SysdarftCPUInstructionExecutor::execute_jit(__uint128_t & timestamp)
+{
+    while (!execution_event_pending()) {
+        handle_execution_errors([&] { run_jit(timestamp); });
     }
 }
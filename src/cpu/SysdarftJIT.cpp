@@ -0,0 +1,524 @@
+/* SysdarftJIT.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <SysdarftInstructionExec.h>
+#include <InstructionSet.h>
+
+// Host code for a block is laid out as:
+//   exit:   pop rbx; ret                    (eax holds the number of retired instructions)
+//   entry:  push rbx; mov rbx, &Registers
+//           <one sequence per guest instruction>
+//           mov eax, <block length>; jmp exit
+// rbx is the only host register living across guest instructions.
+// Host code reads and writes FlagRegister in memory, so lazy flags are committed
+// on block entry and after every call-out
+
+constexpr uint64_t JIT_CODE_BUFFER_SIZE = 16 * 1024 * 1024;
+constexpr uint64_t JIT_MAX_BLOCK_INSTRUCTIONS = 64;
+constexpr uint64_t JIT_MAX_INSTRUCTION_SIZE = 96;
+constexpr uint64_t JIT_MAX_BLOCK_SIZE = JIT_MAX_BLOCK_INSTRUCTIONS * JIT_MAX_INSTRUCTION_SIZE + 64;
+
+// host registers, as encoded in the reg field of ModRM
+constexpr uint8_t HOST_RAX = 0;
+constexpr uint8_t HOST_RCX = 1;
+
+using FlagType = decltype(sysdarft_register_t::FlagRegister);
+
+constexpr uint64_t flag_bit(void (*set)(FlagType &))
+{
+    FlagType flag { };
+    set(flag);
+    return std::bit_cast<uint64_t>(flag);
+}
+
+constexpr uint64_t FLAG_CARRY = flag_bit([](FlagType & flag) { flag.Carry = 1; });
+constexpr uint64_t FLAG_OVERFLOW = flag_bit([](FlagType & flag) { flag.Overflow = 1; });
+constexpr uint64_t FLAG_LARGER_THAN = flag_bit([](FlagType & flag) { flag.LargerThan = 1; });
+constexpr uint64_t FLAG_LESS_THAN = flag_bit([](FlagType & flag) { flag.LessThan = 1; });
+constexpr uint64_t FLAG_EQUAL = flag_bit([](FlagType & flag) { flag.Equal = 1; });
+
+// the host code below hard codes these positions
+static_assert(FLAG_CARRY == 0x01 && FLAG_OVERFLOW == 0x02 && FLAG_LARGER_THAN == 0x04
+    && FLAG_LESS_THAN == 0x08 && FLAG_EQUAL == 0x10);
+
+// general purpose registers of one width are packed back to back from the start of the register file
+static_assert(offsetof(sysdarft_register_t, FullyExtendedRegister0) == 0);
+static_assert(offsetof(sysdarft_register_t, FullyExtendedRegister1.HalfExtendedRegister3.ExtendedRegister7) == 14);
+static_assert(offsetof(sysdarft_register_t, FullyExtendedRegister3.HalfExtendedRegister7) == 28);
+static_assert(offsetof(sysdarft_register_t, FullyExtendedRegister15) == 120);
+
+constexpr uint32_t FLAG_REGISTER_OFFSET = offsetof(sysdarft_register_t, FlagRegister);
+constexpr uint32_t INSTRUCTION_POINTER_OFFSET = offsetof(sysdarft_register_t, InstructionPointer);
+
+// byte offset of a general purpose register inside sysdarft_register_t, -1 for everything else
+static int64_t register_offset(const OperandType::OperandParameterEncodingType & Parameter)
+{
+    if (Parameter.Prefix != REGISTER_PREFIX) {
+        return -1;
+    }
+
+    switch (Parameter.WidthBCD) {
+    case _8bit_prefix:  return Parameter.RegisterIndex < 8 ? Parameter.RegisterIndex : -1;
+    case _16bit_prefix: return Parameter.RegisterIndex < 8 ? Parameter.RegisterIndex * 2 : -1;
+    case _32bit_prefix: return Parameter.RegisterIndex < 8 ? Parameter.RegisterIndex * 4 : -1;
+    case _64bit_prefix: return Parameter.RegisterIndex < 16 ? Parameter.RegisterIndex * 8 : -1;
+    default: return -1;
+    }
+}
+
+static bool is_native_source(const OperandType::OperandParameterEncodingType & Parameter)
+{
+    return Parameter.Prefix == CONSTANT_PREFIX || register_offset(Parameter) != -1;
+}
+
+// load an operand into a host register, zero extended like OperandType::get_val()
+static void emit_load(SysdarftJITCodeBuffer & Code,
+    const OperandType::OperandParameterEncodingType & Parameter,
+    const uint8_t host_register)
+{
+    if (Parameter.Prefix == CONSTANT_PREFIX) {
+        Code.emit({ 0x48, static_cast<uint8_t>(0xB8 + host_register) });   // mov reg, imm64
+        Code.emit64(Parameter.ConstantValue);
+        return;
+    }
+
+    const uint8_t modrm = 0x83 | (host_register << 3);                      // [rbx + disp32]
+    switch (Parameter.WidthBCD) {
+    case _8bit_prefix:  Code.emit({ 0x0F, 0xB6, modrm }); break;            // movzx reg32, byte
+    case _16bit_prefix: Code.emit({ 0x0F, 0xB7, modrm }); break;            // movzx reg32, word
+    case _32bit_prefix: Code.emit({ 0x8B, modrm }); break;                  // mov reg32, dword
+    case _64bit_prefix: Code.emit({ 0x48, 0x8B, modrm }); break;            // mov reg64, qword
+    default: throw SysdarftJITError("Unknown register width");
+    }
+
+    Code.emit32(static_cast<uint32_t>(register_offset(Parameter)));
+}
+
+// store rax into a register, truncated to the register width like OperandType::set_val()
+static void emit_store_rax(SysdarftJITCodeBuffer & Code, const OperandType::OperandParameterEncodingType & Parameter)
+{
+    switch (Parameter.WidthBCD) {
+    case _8bit_prefix:  Code.emit({ 0x88, 0x83 }); break;                   // mov [rbx + disp32], al
+    case _16bit_prefix: Code.emit({ 0x66, 0x89, 0x83 }); break;             // mov [rbx + disp32], ax
+    case _32bit_prefix: Code.emit({ 0x89, 0x83 }); break;                   // mov [rbx + disp32], eax
+    case _64bit_prefix: Code.emit({ 0x48, 0x89, 0x83 }); break;             // mov [rbx + disp32], rax
+    default: throw SysdarftJITError("Unknown register width");
+    }
+
+    Code.emit32(static_cast<uint32_t>(register_offset(Parameter)));
+}
+
+// same as SysdarftCPUInstructionExecutor::check_overflow() on rax:
+// Carry is set if the value does not fit in the width, Overflow and the comparison flags are cleared,
+// and the value is truncated
+static void emit_check_overflow(SysdarftJITCodeBuffer & Code, const uint8_t BCDWidth)
+{
+    switch (BCDWidth) {
+    case _8bit_prefix:  Code.emit({ 0x0F, 0xB6, 0xD0 }); break;             // movzx edx, al
+    case _16bit_prefix: Code.emit({ 0x0F, 0xB7, 0xD0 }); break;             // movzx edx, ax
+    case _32bit_prefix: Code.emit({ 0x89, 0xC2 }); break;                   // mov edx, eax
+    case _64bit_prefix:
+        // results are computed in 64 bits, nothing is ever out of range
+        Code.emit({ 0x48, 0x83, 0xA3 });                                    // and qword [rbx + FG], ~0x1F
+        Code.emit32(FLAG_REGISTER_OFFSET);
+        Code.emit({ 0xE0 });
+        return;
+    default: throw SysdarftJITError("Unknown operation width");
+    }
+
+    Code.emit({ 0x48, 0x39, 0xC2 });                                        // cmp rdx, rax
+    Code.emit({ 0x0F, 0x95, 0xC1 });                                        // setne cl
+    Code.emit({ 0x0F, 0xB6, 0xC9 });                                        // movzx ecx, cl
+    Code.emit({ 0x48, 0x89, 0xD0 });                                        // mov rax, rdx
+    Code.emit({ 0x48, 0x83, 0xA3 });                                        // and qword [rbx + FG], ~0x1F
+    Code.emit32(FLAG_REGISTER_OFFSET);
+    Code.emit({ 0xE0 });
+    Code.emit({ 0x48, 0x09, 0x8B });                                        // or [rbx + FG], rcx
+    Code.emit32(FLAG_REGISTER_OFFSET);
+}
+
+// same as SysdarftCPUInstructionExecutor::cmp() on rax and rcx:
+// LargerThan, LessThan and Equal from an unsigned comparison, Carry and Overflow are left as they were
+static void emit_compare(SysdarftJITCodeBuffer & Code)
+{
+    Code.emit({ 0x48, 0x39, 0xC8 });                                        // cmp rax, rcx
+    Code.emit({ 0x0F, 0x97, 0xC2 });                                        // seta dl
+    Code.emit({ 0x0F, 0x92, 0xC1 });                                        // setb cl
+    Code.emit({ 0x0F, 0x94, 0xC0 });                                        // sete al
+    Code.emit({ 0x0F, 0xB6, 0xD2, 0xC1, 0xE2, 0x02 });                      // movzx edx, dl; shl edx, 2
+    Code.emit({ 0x0F, 0xB6, 0xC9, 0xC1, 0xE1, 0x03 });                      // movzx ecx, cl; shl ecx, 3
+    Code.emit({ 0x0F, 0xB6, 0xC0, 0xC1, 0xE0, 0x04 });                      // movzx eax, al; shl eax, 4
+    Code.emit({ 0x09, 0xCA, 0x09, 0xC2 });                                  // or edx, ecx; or edx, eax
+    Code.emit({ 0x48, 0x83, 0xA3 });                                        // and qword [rbx + FG], ~0x1C
+    Code.emit32(FLAG_REGISTER_OFFSET);
+    Code.emit({ 0xE3 });
+    Code.emit({ 0x48, 0x09, 0x93 });                                        // or [rbx + FG], rdx
+    Code.emit32(FLAG_REGISTER_OFFSET);
+}
+
+static bool is_block_terminator(const uint8_t opcode)
+{
+    switch (opcode) {
+    case OPCODE_JMP: case OPCODE_CALL: case OPCODE_RET:
+    case OPCODE_JE: case OPCODE_JNE: case OPCODE_JB: case OPCODE_JL: case OPCODE_JBE: case OPCODE_JLE:
+    case OPCODE_JC: case OPCODE_JNC: case OPCODE_JO: case OPCODE_JNO: case OPCODE_LOOP:
+    case OPCODE_INT: case OPCODE_INT3: case OPCODE_IRET: case OPCODE_HLT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool SysdarftCPUInstructionExecutor::jit_emit_native(const JITInstructionType & instruction)
+{
+#ifdef __DEBUG__
+    // verbose log lists every instruction, which only the handlers do
+    if (debug::verbose) {
+        return false;
+    }
+#endif
+
+    const auto & operands = instruction.operands;
+    const bool destination_is_register = instruction.operand_count >= 1 && register_offset(operands[0].Operand) != -1;
+    const bool source_is_native = instruction.operand_count == 2 && is_native_source(operands[1].Operand);
+
+    switch (instruction.opcode)
+    {
+    case OPCODE_NOP:
+        return true;
+
+    case OPCODE_MOV:
+        if (!destination_is_register || !source_is_native) {
+            return false;
+        }
+
+        emit_load(JITCode, operands[1].Operand, HOST_RAX);
+        emit_store_rax(JITCode, operands[0].Operand);
+        return true;
+
+    case OPCODE_ADD:
+    case OPCODE_SUB:
+    case OPCODE_AND:
+    case OPCODE_OR:
+    case OPCODE_XOR:
+        if (!destination_is_register || !source_is_native) {
+            return false;
+        }
+
+        emit_load(JITCode, operands[0].Operand, HOST_RAX);
+        emit_load(JITCode, operands[1].Operand, HOST_RCX);
+        switch (instruction.opcode) {
+        case OPCODE_ADD: JITCode.emit({ 0x48, 0x01, 0xC8 }); break;         // add rax, rcx
+        case OPCODE_SUB: JITCode.emit({ 0x48, 0x29, 0xC8 }); break;         // sub rax, rcx
+        case OPCODE_AND: JITCode.emit({ 0x48, 0x21, 0xC8 }); break;         // and rax, rcx
+        case OPCODE_OR:  JITCode.emit({ 0x48, 0x09, 0xC8 }); break;         // or rax, rcx
+        default:         JITCode.emit({ 0x48, 0x31, 0xC8 }); break;         // xor rax, rcx
+        }
+
+        // logic operations leave the flags alone
+        if (instruction.opcode == OPCODE_ADD || instruction.opcode == OPCODE_SUB) {
+            emit_check_overflow(JITCode, instruction.width);
+        }
+
+        emit_store_rax(JITCode, operands[0].Operand);
+        return true;
+
+    case OPCODE_INC:
+    case OPCODE_DEC:
+        if (!destination_is_register) {
+            return false;
+        }
+
+        emit_load(JITCode, operands[0].Operand, HOST_RAX);
+        if (instruction.opcode == OPCODE_INC) {
+            JITCode.emit({ 0x48, 0xFF, 0xC0 });                             // inc rax
+        } else {
+            JITCode.emit({ 0x48, 0xFF, 0xC8 });                             // dec rax
+        }
+
+        emit_check_overflow(JITCode, instruction.width);
+        emit_store_rax(JITCode, operands[0].Operand);
+        return true;
+
+    case OPCODE_CMP:
+        if (!is_native_source(operands[0].Operand) || !source_is_native) {
+            return false;
+        }
+
+        emit_load(JITCode, operands[0].Operand, HOST_RAX);
+        emit_load(JITCode, operands[1].Operand, HOST_RCX);
+        emit_compare(JITCode);
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+void SysdarftCPUInstructionExecutor::jit_emit_call_out(const JITInstructionType & instruction, const uint64_t exit_offset)
+{
+    JITCode.emit({ 0x48, 0xBF });                                           // mov rdi, this
+    JITCode.emit64(reinterpret_cast<uint64_t>(this));
+    JITCode.emit({ 0x48, 0xBE });                                           // mov rsi, &instruction
+    JITCode.emit64(reinterpret_cast<uint64_t>(&instruction));
+    JITCode.emit({ 0x48, 0xB8 });                                           // mov rax, jit_call_out
+    JITCode.emit64(reinterpret_cast<uint64_t>(&SysdarftCPUInstructionExecutor::jit_call_out));
+    JITCode.emit({ 0xFF, 0xD0 });                                           // call rax
+    JITCode.emit({ 0x84, 0xC0 });                                           // test al, al
+    JITCode.emit({ 0x74, 0x0A });                                           // jz over the exit below
+    JITCode.emit({ 0xB8 });                                                 // mov eax, retired instructions
+    JITCode.emit32(instruction.index + 1);
+    JITCode.emit_jmp(exit_offset);
+}
+
+bool SysdarftCPUInstructionExecutor::jit_call_out(SysdarftCPUInstructionExecutor * cpu,
+    const JITInstructionType * instruction) noexcept
+{
+    // nothing may unwind through host code, the exception is thrown again once the block has returned
+    try {
+        return cpu->jit_execute_instruction(*instruction);
+    } catch (...) {
+        cpu->JITPendingException = std::current_exception();
+        return true;
+    }
+}
+
+bool SysdarftCPUInstructionExecutor::jit_execute_instruction(const JITInstructionType & instruction)
+{
+    ip_before_pop = instruction.ip;
+    SysdarftRegister::store<InstructionPointerType>(instruction.next_ip);
+    current_routine_pop_len = instruction.next_ip - instruction.ip;
+
+    WidthAndOperandsType Arg;
+    Arg.first = instruction.width;
+    for (uint8_t i = 0; i < instruction.operand_count; i++) {
+        Arg.second.emplace_back(*this, instruction.operands[i]);
+    }
+
+    if (!fault_pending())
+    {
+#ifdef __DEBUG__
+        log_instruction(instruction.opcode, Arg);
+#endif
+        (this->*ExecutorTable[instruction.handler])(JITBlockTimestamp + instruction.index, Arg);
+#ifdef __DEBUG__
+        if (!fault_pending()) {
+            log_instruction_result(instruction.opcode, Arg);
+        }
+#endif
+    }
+
+    commit_flags();
+
+    // leave the block if the instruction faulted, jumped away, wrote to code, turned paging on,
+    // or anything needs attention
+    return fault_pending()
+        || execution_event_pending()
+        || Int3DebugInterrupt
+        || CodeBlockInvalidated
+        || paging_enabled()
+        || SysdarftRegister::load<InstructionPointerType>() != instruction.next_ip
+        || SysdarftRegister::load<CodeBaseType>() != instruction.code_base;
+}
+
+void SysdarftCPUInstructionExecutor::jit_flush()
+{
+    JITBlocks.clear();
+    JITBlocksByPage.clear();
+    JITCode.reset();
+}
+
+void SysdarftCPUInstructionExecutor::jit_drop_translations(const std::vector < uint64_t > & pages)
+{
+    for (const auto page : pages)
+    {
+        const auto blocks = JITBlocksByPage.find(page);
+        if (blocks == JITBlocksByPage.end()) {
+            continue;
+        }
+
+        for (const auto linear_address : blocks->second) {
+            JITBlocksInvalidated += JITBlocks.erase(linear_address);
+        }
+
+        JITBlocksByPage.erase(blocks);
+    }
+}
+
+const SysdarftCPUInstructionExecutor::JITBlockType *
+SysdarftCPUInstructionExecutor::jit_translate_block(const uint64_t code_base, const uint64_t ip)
+{
+    // no executable memory from the host, everything is interpreted
+    if (!JITCode.reserve(JIT_CODE_BUFFER_SIZE)) {
+        return nullptr;
+    }
+
+    const auto linear_address = code_base + ip;
+    JITBlockType block { };
+    block.code_base = code_base;
+    block.first_page = linear_address / BLOCK_SIZE;
+
+    // decode the whole block first. IP walks through it, and is put back afterwards
+    uint64_t next_ip = ip;
+    while (block.instructions.size() < JIT_MAX_BLOCK_INSTRUCTIONS)
+    {
+        // mark before decoding, so a write racing with the decoder still drops the translation
+        mark_code_block((code_base + next_ip) / BLOCK_SIZE);
+        mark_code_block((code_base + next_ip) / BLOCK_SIZE + 1);
+
+        const auto [opcode, width, operands, handler] = decode_instruction_uncached();
+        if (fault_pending()) {
+            // the block ends right before it, the interpreter raises the fault again once it gets there
+            PendingFault = SysdarftFaultType::None;
+            break;
+        }
+
+        JITInstructionType instruction { };
+        instruction.opcode = opcode;
+        instruction.width = width;
+        instruction.handler = handler;
+        instruction.operand_count = static_cast<uint8_t>(operands.size());
+        for (uint8_t i = 0; i < instruction.operand_count; i++) {
+            instruction.operands[i] = operands[i].get_encoding();
+        }
+
+        instruction.code_base = code_base;
+        instruction.ip = next_ip;
+        instruction.next_ip = next_ip = SysdarftRegister::load<InstructionPointerType>();
+        instruction.index = static_cast<uint32_t>(block.instructions.size());
+        block.instructions.push_back(instruction);
+
+        if (is_block_terminator(opcode)) {
+            break;
+        }
+    }
+
+    SysdarftRegister::store<InstructionPointerType>(ip);
+
+    if (block.instructions.empty()) {
+        return nullptr;
+    }
+
+    block.last_page = (code_base + next_ip - 1) / BLOCK_SIZE;
+
+    if (JITCode.available() < JIT_MAX_BLOCK_SIZE) {
+        jit_flush();
+    }
+
+    // host code points into the instruction list, so it is emitted from the stored copy
+    auto & stored = JITBlocks.insert_or_assign(linear_address, std::move(block)).first->second;
+
+    JITCode.begin(JIT_MAX_BLOCK_SIZE);
+
+    // exit first, every way out is then a backward jump to a known offset
+    constexpr uint64_t exit_offset = 0;
+    JITCode.emit({ 0x5B, 0xC3 });                                           // pop rbx; ret
+    const auto entry_offset = JITCode.offset();
+    JITCode.emit({ 0x53 });                                                 // push rbx
+    JITCode.emit({ 0x48, 0xBB });                                           // mov rbx, &Registers
+    JITCode.emit64(reinterpret_cast<uint64_t>(&Registers));
+
+    bool last_is_native = false;
+    for (const auto & instruction : stored.instructions)
+    {
+        last_is_native = jit_emit_native(instruction);
+        if (!last_is_native) {
+            jit_emit_call_out(instruction, exit_offset);
+        }
+    }
+
+    // host code does not maintain IP, call-outs set it for themselves
+    if (last_is_native) {
+        JITCode.emit({ 0x48, 0xB8 });                                       // mov rax, next IP
+        JITCode.emit64(stored.instructions.back().next_ip);
+        JITCode.emit({ 0x48, 0x89, 0x83 });                                 // mov [rbx + IP], rax
+        JITCode.emit32(INSTRUCTION_POINTER_OFFSET);
+    }
+
+    JITCode.emit({ 0xB8 });                                                 // mov eax, block length
+    JITCode.emit32(static_cast<uint32_t>(stored.instructions.size()));
+    JITCode.emit_jmp(exit_offset);
+
+    stored.entry = JITCode.commit(entry_offset);
+
+    for (auto page = stored.first_page; page <= stored.last_page; page++)
+    {
+        if (auto & blocks = JITBlocksByPage[page]; std::ranges::find(blocks, linear_address) == blocks.end()) {
+            blocks.push_back(linear_address);
+        }
+    }
+
+    ++JITBlocksTranslated;
+    return &stored;
+}
+
+void SysdarftCPUInstructionExecutor::run_jit(__uint128_t & timestamp)
+{
+    while (!execution_event_pending())
+    {
+        if (CodeBlockInvalidated) {
+            drop_invalidated_decoded_instructions();
+        }
+
+        publish_register_snapshot();
+
+        const auto CB = SysdarftRegister::load<CodeBaseType>();
+        const auto IP = SysdarftRegister::load<InstructionPointerType>();
+        const JITBlockType * block = nullptr;
+
+        // a debugger checks every single instruction, and int3 wants the breakpoint handler
+        // called before the next one. The interpreter takes care of both.
+        // Translations are keyed by linear address, with paging enabled everything is interpreted.
+        // Translated code does not count its accesses, so neither is anything with the heatmap enabled
+        if (!breakpoints_bound && !Int3DebugInterrupt && !paging_enabled() && !heatmap_enabled())
+        {
+            if (const auto cached = JITBlocks.find(CB + IP);
+                cached != JITBlocks.end() && cached->second.code_base == CB)
+            {
+                block = &cached->second;
+            } else {
+                block = jit_translate_block(CB, IP);
+            }
+        }
+
+        if (block == nullptr) {
+            ++JITInterpretedInstructions;
+            execute(timestamp++);
+            continue;
+        }
+
+        commit_flags();
+        JITBlockTimestamp = timestamp;
+        timestamp += block->entry();
+
+        if (JITPendingException) {
+            const auto exception = JITPendingException;
+            JITPendingException = nullptr;
+            std::rethrow_exception(exception);
+        }
+
+        if (fault_pending()) {
+            deliver_pending_fault();
+        }
+    }
+}
@@ -19,127 +19,597 @@
  */
 
 #include <SysdarftMemory.h>
+#include <cerrno>
 #include <cstring>
-#include <mutex>
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cstdint>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <mutex>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
-SysdarftCPUMemoryAccess::SysdarftCPUMemoryAccess(const uint64_t totalMemory)
+// zero filled, and only backed by host memory once touched. Mapped over address if there is one
+static void * map_lazily(const uint64_t size, void * address = nullptr)
 {
-    std::lock_guard<std::mutex> lock(MemoryAccessMutex);
-    Memory.clear();
+    void * mapping = mmap(address, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | (address != nullptr ? MAP_FIXED : 0), -1, 0);
+    if (mapping == MAP_FAILED) {
+        throw SysdarftBaseError("Cannot map guest memory: " + std::string(strerror(errno)));
+    }
+
+    return mapping;
+}
+
+// explicit huge pages come from the host's reserved pool (vm.nr_hugepages).
+// Reserved at map time, so a pool too small for the guest fails here and not on a later page fault
+static bool map_explicit_huge_pages(void * address, const uint64_t size)
+{
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_2MB)
+    if (mmap(address, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0) != MAP_FAILED)
+    {
+        return true;
+    }
+
+    log("[Memory] Explicit huge pages unavailable: ", strerror(errno), "\n");
+#else
+    (void)address;
+    (void)size;
+#endif
+    return false;
+}
+
+// guest RAM in a memfd mapped over address, returns the memfd or -1.
+// Sealed to its size, so no other process mapping it can pull pages out from under the guest,
+// and read only once mapped here, so opening it again through /proc only works for reading
+static int map_shared(void * address, const uint64_t size, const bool explicit_huge_pages)
+{
+    unsigned int flags = MFD_CLOEXEC | MFD_ALLOW_SEALING;
+    int map_flags = MAP_SHARED | MAP_FIXED | MAP_NORESERVE;
+    if (explicit_huge_pages)
+    {
+#if defined(MFD_HUGETLB) && defined(MFD_HUGE_2MB)
+        // reserved at map time like the private mapping, see map_explicit_huge_pages()
+        flags |= MFD_HUGETLB | MFD_HUGE_2MB;
+        map_flags &= ~MAP_NORESERVE;
+#else
+        return -1;
+#endif
+    }
+
+    const int fd = memfd_create("sysdarft-guest-ram", flags);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0
+        || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0
+        || mmap(address, size, PROT_READ | PROT_WRITE, map_flags, fd, 0) == MAP_FAILED
+        || fchmod(fd, S_IRUSR) != 0)
+    {
+        const int error = errno;
+        if (explicit_huge_pages) {
+            log("[Memory] Explicit huge pages unavailable: ", strerror(error), "\n");
+        }
+
+        close(fd);
+        errno = error;
+        return -1;
+    }
+
+    return fd;
+}
+
+// guest RAM in the memory image at path, mapped shared over address. The image is created if it is empty
+static int map_memory_image(const std::string & path, void * address, const uint64_t size, const uint64_t total,
+    SysdarftMemoryImageHeader * & header)
+{
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        throw SysdarftBaseError("Cannot open memory image " + path + ": " + strerror(errno));
+    }
+
+    auto fail = [&](const std::string & reason)
+    {
+        if (header != nullptr) {
+            munmap(header, MEMORY_IMAGE_HEADER_SIZE);
+            header = nullptr;
+        }
+
+        close(fd);
+        throw SysdarftBaseError("Memory image " + path + ": " + reason);
+    };
+
+    // two runs on the same image would be running on the same RAM
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        fail("Already in use");
+    }
+
+    struct stat status { };
+    if (fstat(fd, &status) != 0) {
+        fail(strerror(errno));
+    }
+
+    // an existing file is checked before anything is written to it
+    const bool created = status.st_size == 0;
+    if (!created)
+    {
+        SysdarftMemoryImageHeader existing { };
+        if (pread(fd, &existing, sizeof(existing), 0) != sizeof(existing)
+            || std::strncmp(existing.Magic, MEMORY_IMAGE_MAGIC, sizeof(existing.Magic)) != 0
+            || existing.Version != MEMORY_IMAGE_VERSION)
+        {
+            fail("Not a memory image");
+        }
+
+        if (existing.MemorySize != total) {
+            fail("Made for " + std::to_string(existing.MemorySize / 1024 / 1024) + "MB of memory, not "
+                + std::to_string(total / 1024 / 1024) + "MB");
+        }
+    }
+
+    // RAM rounded up to huge pages may be longer than last time
+    const auto length = static_cast<off_t>(MEMORY_IMAGE_HEADER_SIZE + size);
+    if (status.st_size < length && ftruncate(fd, length) != 0) {
+        fail(strerror(errno));
+    }
+
+    void * mapping = mmap(nullptr, MEMORY_IMAGE_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        fail(strerror(errno));
+    }
+
+    header = static_cast<SysdarftMemoryImageHeader*>(mapping);
+    if (created)
+    {
+        std::strncpy(header->Magic, MEMORY_IMAGE_MAGIC, sizeof(header->Magic));
+        header->Version = MEMORY_IMAGE_VERSION;
+        header->MemorySize = total;
+    }
+
+    if (mmap(address, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, MEMORY_IMAGE_HEADER_SIZE) == MAP_FAILED) {
+        fail(strerror(errno));
+    }
+
+    return fd;
+}
+
+// inaccessible address space, aligned to alignment so guest RAM can be mapped over the start of it
+static uint8_t * reserve_address_space(const uint64_t size, const uint64_t alignment)
+{
+    void * mapping = mmap(nullptr, size + alignment, PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapping == MAP_FAILED) {
+        throw SysdarftBaseError("Cannot reserve guest memory: " + std::string(strerror(errno)));
+    }
+
+    auto * reserved = static_cast<uint8_t*>(mapping);
+    const auto begin = reinterpret_cast<uintptr_t>(reserved);
+    auto * aligned = reinterpret_cast<uint8_t*>((begin + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+
+    // give back what is left on either side
+    if (aligned != reserved) {
+        munmap(reserved, aligned - reserved);
+    }
+
+    const uint64_t tail = alignment - (aligned - reserved);
+    if (tail != 0) {
+        munmap(aligned + size, tail);
+    }
+
+    return aligned;
+}
+
+SysdarftCPUMemoryAccess::SysdarftCPUMemoryAccess(const SysdarftMemoryOptions & options)
+{
+    const uint64_t totalMemory = options.Size;
     TotalMemory = totalMemory;
 
     if (totalMemory == 0) {
         throw SysdarftBaseError("Total memory is zero");
     }
 
-    // Fill the vector with (TotalMemory / BLOCK_SIZE) blocks
-    const uint64_t numBlocks = TotalMemory / BLOCK_SIZE;
-    Memory.reserve(numBlocks);
+    const uint64_t host_page_size = sysconf(_SC_PAGESIZE);
+    MappedMemory = (totalMemory + host_page_size - 1) / host_page_size * host_page_size;
+    if (options.HugePages) {
+        MappedMemory = (totalMemory + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+
+    Memory = reserve_address_space(MappedMemory, options.HugePages ? HUGE_PAGE_SIZE : host_page_size);
+
+    // explicit huge pages first, then transparent huge pages, then regular pages
+    if (!options.File.empty())
+    {
+        if (options.Shared) {
+            throw SysdarftBaseError("Guest memory backed by a memory image cannot be shared");
+        }
+
+        MemoryImageFd = map_memory_image(options.File, Memory, MappedMemory, totalMemory, MemoryImage);
+        log("[Memory] Guest memory backed by memory image ", options.File, "\n");
+    }
+    else if (options.Shared)
+    {
+        if (options.HugePages && (SharedMemoryFd = map_shared(Memory, MappedMemory, true)) >= 0) {
+            PageBacking = SysdarftPageBacking::Explicit;
+        } else if ((SharedMemoryFd = map_shared(Memory, MappedMemory, false)) < 0) {
+            throw SysdarftBaseError("Cannot share guest memory: " + std::string(strerror(errno)));
+        }
+
+        log("[Memory] Guest memory shared at ", shared_memory_path(), "\n");
+    }
+    else if (options.HugePages && map_explicit_huge_pages(Memory, MappedMemory)) {
+        PageBacking = SysdarftPageBacking::Explicit;
+    } else {
+        map_lazily(MappedMemory, Memory);
+    }
+
+    // a memory image lives in the host page cache, which has its own idea of huge pages
+    if (options.HugePages && MemoryImage == nullptr)
+    {
+#ifdef MADV_HUGEPAGE
+        if (PageBacking != SysdarftPageBacking::Explicit)
+        {
+            if (madvise(Memory, MappedMemory, MADV_HUGEPAGE) == 0) {
+                PageBacking = SysdarftPageBacking::Transparent;
+            } else {
+                log("[Memory] Transparent huge pages unavailable: ", strerror(errno), "\n");
+            }
+        }
+#endif
 
-    for (uint64_t i = 0; i < numBlocks; i++) {
-        Memory.emplace_back();
+        log("[Memory] Guest memory backed by ", page_backing_name(PageBacking), " pages\n");
+    }
+
+    // one more block, the decoder marks the block right after the one it decodes from
+    CodeBlockCount = totalMemory / BLOCK_SIZE + 1;
+    CodeBlockCached = static_cast<bool*>(map_lazily(CodeBlockCount));
+
+    DirtyPageWords = (totalMemory + BLOCK_SIZE * 64 - 1) / (BLOCK_SIZE * 64);
+    DirtyPages = static_cast<uint64_t*>(map_lazily(DirtyPageWords * sizeof(uint64_t)));
+
+    if (options.HeatmapGranularity != 0)
+    {
+        HeatmapGranularity = options.HeatmapGranularity;
+        HeatmapBuckets = (totalMemory + HeatmapGranularity - 1) / HeatmapGranularity;
+        Heatmap = static_cast<HeatmapBucketType*>(map_lazily(HeatmapBuckets * sizeof(HeatmapBucketType)));
     }
 }
 
-void SysdarftCPUMemoryAccess::read_memory(const uint64_t address, char* _dest, const uint64_t size)
+SysdarftCPUMemoryAccess::~SysdarftCPUMemoryAccess()
 {
-    std::lock_guard<std::mutex> lock(MemoryAccessMutex);
+    if (Heatmap != nullptr) {
+        munmap(Heatmap, HeatmapBuckets * sizeof(HeatmapBucketType));
+    }
 
-    // Basic range check
-    if (address > TotalMemory || (address + size) > TotalMemory) {
-        throw IllegalMemoryAccessException("Memory access out of bounds");
+    munmap(DirtyPages, DirtyPageWords * sizeof(uint64_t));
+    munmap(CodeBlockCached, CodeBlockCount);
+    munmap(Memory, MappedMemory);
+    if (SharedMemoryFd >= 0) {
+        close(SharedMemoryFd);
     }
 
-    const uint64_t page_address = address / BLOCK_SIZE;
-    const uint64_t page_offset = address % BLOCK_SIZE;
+    if (MemoryImage != nullptr) {
+        munmap(MemoryImage, MEMORY_IMAGE_HEADER_SIZE);
+        close(MemoryImageFd);
+    }
+}
 
-    if (size <= (BLOCK_SIZE - page_offset)) {
-        // Entire read fits in one block
-        std::memcpy(_dest, Memory[page_address].data() + page_offset, size);
-    } else {
-        // Multi-page read
-        const uint64_t leftover_on_first_page = BLOCK_SIZE - page_offset;
-        const uint64_t rest_size = size - leftover_on_first_page;
-        const uint64_t full_pages = rest_size / BLOCK_SIZE;
-        const uint64_t leftover_on_last_page = rest_size % BLOCK_SIZE;
-
-        uint64_t current_offset = 0;
-
-        // 1. Read partial chunk from the first page
-        std::memcpy(_dest, Memory[page_address].data() + page_offset, leftover_on_first_page);
-        current_offset += leftover_on_first_page;
-
-        // 2. Read each full page
-        for (uint64_t i = 1; i <= full_pages; i++) {
-            std::memcpy(_dest + current_offset,
-                        Memory[page_address + i].data(),
-                        BLOCK_SIZE);
-            current_offset += BLOCK_SIZE;
+const char * SysdarftCPUMemoryAccess::page_backing_name(const SysdarftPageBacking backing)
+{
+    switch (backing)
+    {
+    case SysdarftPageBacking::Transparent: return "transparent huge";
+    case SysdarftPageBacking::Explicit: return "explicit huge";
+    default: return "regular";
+    }
+}
+
+std::string SysdarftCPUMemoryAccess::shared_memory_path() const
+{
+    if (SharedMemoryFd < 0) {
+        return "";
+    }
+
+    return "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(SharedMemoryFd);
+}
+
+bool SysdarftCPUMemoryAccess::take_memory_image_state(void * state, const uint64_t size)
+{
+    if (MemoryImage == nullptr || MemoryImage->StateSize != size) {
+        return false;
+    }
+
+    // dropped right away, should this run not stop cleanly the next one boots again
+    std::memcpy(state, MemoryImage->State, size);
+    MemoryImage->StateSize = 0;
+    msync(MemoryImage, MEMORY_IMAGE_HEADER_SIZE, MS_SYNC);
+    return true;
+}
+
+void SysdarftCPUMemoryAccess::save_memory_image_state(const void * state, const uint64_t size)
+{
+    if (MemoryImage == nullptr || size > sizeof(MemoryImage->State)) {
+        return;
+    }
+
+    // RAM first, the state is only worth anything with the RAM it was saved with
+    msync(Memory, MappedMemory, MS_SYNC);
+    std::memcpy(MemoryImage->State, state, size);
+    MemoryImage->StateSize = size;
+    msync(MemoryImage, MEMORY_IMAGE_HEADER_SIZE, MS_SYNC);
+}
+
+uint64_t SysdarftCPUMemoryAccess::resident_memory() const
+{
+    const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    const uint64_t total = TotalMemory;
+
+    // walk the mapping in windows, so the residency vector stays small for any memory size
+    constexpr uint64_t window_pages = 4096;
+    std::array < unsigned char, window_pages > residency { };
+    uint64_t resident_pages = 0;
+
+    for (uint64_t offset = 0; offset < total; offset += window_pages * page_size)
+    {
+        const uint64_t length = std::min(window_pages * page_size, total - offset);
+        if (mincore(Memory + offset, length, residency.data()) != 0) {
+            return 0;
         }
 
-        // 3. Read leftover chunk on the next page
-        if (leftover_on_last_page > 0) {
-            std::memcpy(_dest + current_offset,
-                        Memory[page_address + full_pages + 1].data(),
-                        leftover_on_last_page);
+        const uint64_t pages = (length + page_size - 1) / page_size;
+        for (uint64_t i = 0; i < pages; i++) {
+            resident_pages += residency[i] & 1;
         }
     }
+
+    return resident_pages * page_size;
 }
 
-void SysdarftCPUMemoryAccess::write_memory(const uint64_t address, const char* _source, const uint64_t size)
+void SysdarftCPUMemoryAccess::mark_code_block(const uint64_t block)
 {
-    std::lock_guard<std::mutex> lock(MemoryAccessMutex);
+    if (block < CodeBlockCount) {
+        std::atomic_ref(CodeBlockCached[block]).store(true);
+    }
+}
 
-    // Basic range check
-    if (address > TotalMemory || (address + size) > TotalMemory) {
-        throw IllegalMemoryAccessException("Memory access out of bounds");
+void SysdarftCPUMemoryAccess::queue_invalidated_code_block(const uint64_t block)
+{
+    if (!std::atomic_ref(CodeBlockCached[block]).exchange(false)) {
+        return;
     }
 
-    const uint64_t page_address = address / BLOCK_SIZE;
-    const uint64_t page_offset = address % BLOCK_SIZE;
+    std::lock_guard<std::mutex> lock(MemoryAccessMutex);
+    InvalidatedCodeBlocks.push_back(block);
+    CodeBlockInvalidated = true;
+}
 
-    // Helper lambda to copy data into our Memory blocks with bounds-check
-    auto copy_n = [](std::array<uint8_t, BLOCK_SIZE>& destBlock,
-                     const uint64_t offset,
-                     const char* src,
-                     const uint64_t count) -> void
+std::vector < uint64_t > SysdarftCPUMemoryAccess::pop_invalidated_code_blocks()
+{
+    std::lock_guard<std::mutex> lock(MemoryAccessMutex);
+    std::vector < uint64_t > blocks;
+    blocks.swap(InvalidatedCodeBlocks);
+    CodeBlockInvalidated = false;
+    return blocks;
+}
+
+std::vector < uint64_t > SysdarftCPUMemoryAccess::collect_and_clear_dirty()
+{
+    std::vector < uint64_t > pages;
+    for (uint64_t i = 0; i < DirtyPageWords; i++)
     {
-        if (offset + count > BLOCK_SIZE) {
-            throw IllegalMemoryAccessException("Memory write out of bounds");
+        // most words are clean, only take the exchange on ones that are not
+        const std::atomic_ref word(DirtyPages[i]);
+        if (word.load(std::memory_order_relaxed) == 0) {
+            continue;
         }
-        // Copy byte by byte (could use memcpy if you prefer)
-        for (uint64_t i = 0; i < count; i++) {
-            destBlock[offset + i] = static_cast<uint8_t>(src[i]);
+
+        for (uint64_t bits = word.exchange(0, std::memory_order_acquire); bits != 0; bits &= bits - 1) {
+            pages.push_back(i * 64 + std::countr_zero(bits));
         }
-    };
+    }
 
-    if (size <= (BLOCK_SIZE - page_offset)) {
-        // Entire write fits in one block
-        copy_n(Memory[page_address], page_offset, _source, size);
-    } else {
-        // Multi-page write
-        const uint64_t leftover_on_first_page = BLOCK_SIZE - page_offset;
-        const uint64_t rest_size = size - leftover_on_first_page;
-        const uint64_t full_pages = rest_size / BLOCK_SIZE;
-        const uint64_t leftover_on_last_page = rest_size % BLOCK_SIZE;
-
-        uint64_t current_offset = 0;
-
-        // 1. Write partial chunk to the first page
-        copy_n(Memory[page_address], page_offset, _source, leftover_on_first_page);
-        current_offset += leftover_on_first_page;
-
-        // 2. Write full pages
-        for (uint64_t i = 1; i <= full_pages; i++) {
-            copy_n(Memory[page_address + i], 0, _source + current_offset, BLOCK_SIZE);
-            current_offset += BLOCK_SIZE;
+    return pages;
+}
+
+void SysdarftCPUMemoryAccess::count_heatmap(const uint64_t address, const uint64_t size, const GuestAccessType Access)
+{
+    if (size == 0) {
+        return;
+    }
+
+    const uint64_t last = std::min((address + size - 1) / HeatmapGranularity, HeatmapBuckets - 1);
+    for (uint64_t bucket = address / HeatmapGranularity; bucket <= last; bucket++)
+    {
+        auto & counters = Heatmap[bucket];
+        const std::atomic_ref counter(Access == GuestAccessType::Read ? counters.Reads
+            : Access == GuestAccessType::Write ? counters.Writes : counters.Fetches);
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+std::vector < SysdarftHeatmapRecord > SysdarftCPUMemoryAccess::heatmap_snapshot() const
+{
+    std::vector < SysdarftHeatmapRecord > records;
+    for (uint64_t bucket = 0; bucket < HeatmapBuckets; bucket++)
+    {
+        auto & counters = Heatmap[bucket];
+        const SysdarftHeatmapRecord record {
+            .Bucket = bucket,
+            .Reads = std::atomic_ref(counters.Reads).load(std::memory_order_relaxed),
+            .Writes = std::atomic_ref(counters.Writes).load(std::memory_order_relaxed),
+            .Fetches = std::atomic_ref(counters.Fetches).load(std::memory_order_relaxed),
+        };
+
+        if (record.Reads != 0 || record.Writes != 0 || record.Fetches != 0) {
+            records.push_back(record);
         }
+    }
+
+    return records;
+}
+
+void SysdarftCPUMemoryAccess::write_heatmap(const std::string & path) const
+{
+    const auto records = heatmap_snapshot();
 
-        // 3. Write leftover chunk on the next page
-        if (leftover_on_last_page > 0) {
-            copy_n(Memory[page_address + full_pages + 1], 0,
-                   _source + current_offset, leftover_on_last_page);
+    SysdarftHeatmapHeader header { };
+    std::strncpy(header.Magic, HEATMAP_MAGIC, sizeof(header.Magic));
+    header.Version = HEATMAP_VERSION;
+    header.Granularity = HeatmapGranularity;
+    header.Records = records.size();
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()),
+        static_cast<std::streamsize>(records.size() * sizeof(SysdarftHeatmapRecord)));
+    if (!file) {
+        throw SysdarftBaseError("Cannot write heatmap to " + path);
+    }
+}
+
+void SysdarftCPUMemoryAccess::read_memory(const uint64_t address, char* _dest, const uint64_t size)
+{
+    if (try_read_memory(address, _dest, size) != SysdarftFaultType::None) {
+        throw IllegalMemoryAccessException("Memory access out of bounds");
+    }
+}
+
+void SysdarftCPUMemoryAccess::write_memory(const uint64_t address, const char* _source, const uint64_t size)
+{
+    if (!in_bounds(address, size)) {
+        throw IllegalMemoryAccessException("Memory access out of bounds");
+    }
+
+    std::memcpy(Memory + address, _source, size);
+
+    // The decoder marks a block before it reads code from it. Writing before looking at the marks,
+    // either the decoder sees the new code, or this thread sees the mark and invalidates the block
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (size != 0) {
+        mark_dirty_pages(address / BLOCK_SIZE, (address + size - 1) / BLOCK_SIZE);
+        invalidate_code_blocks(address / BLOCK_SIZE, (address + size - 1) / BLOCK_SIZE);
+    }
+}
+
+SysdarftFaultType SysdarftCPUMemoryAccess::try_read_memory(const uint64_t address, char* _dest, const uint64_t size)
+{
+    if (!in_bounds(address, size)) {
+        return SysdarftFaultType::IllegalMemoryAccess;
+    }
+
+    std::memcpy(_dest, Memory + address, size);
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUMemoryAccess::try_write_memory(const uint64_t address, const char* _source, const uint64_t size)
+{
+    if (!in_bounds(address, size)) {
+        return SysdarftFaultType::IllegalMemoryAccess;
+    }
+
+    std::memcpy(Memory + address, _source, size);
+
+    // Drop decoded instructions living in the blocks just modified
+    if (size != 0) {
+        mark_dirty_pages(address / BLOCK_SIZE, (address + size - 1) / BLOCK_SIZE);
+        invalidate_code_blocks(address / BLOCK_SIZE, (address + size - 1) / BLOCK_SIZE);
+    }
+
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUMemoryAccess::try_move_memory(const uint64_t dest, const uint64_t source, const uint64_t size)
+{
+    if (!in_bounds(dest, size) || !in_bounds(source, size)) {
+        return SysdarftFaultType::IllegalMemoryAccess;
+    }
+
+    std::memmove(Memory + dest, Memory + source, size);
+
+    if (size != 0) {
+        mark_dirty_pages(dest / BLOCK_SIZE, (dest + size - 1) / BLOCK_SIZE);
+        invalidate_code_blocks(dest / BLOCK_SIZE, (dest + size - 1) / BLOCK_SIZE);
+    }
+
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUMemoryAccess::try_fill_memory(const uint64_t address, const uint8_t value, const uint64_t size)
+{
+    if (!in_bounds(address, size)) {
+        return SysdarftFaultType::IllegalMemoryAccess;
+    }
+
+    std::memset(Memory + address, value, size);
+
+    if (size != 0) {
+        mark_dirty_pages(address / BLOCK_SIZE, (address + size - 1) / BLOCK_SIZE);
+        invalidate_code_blocks(address / BLOCK_SIZE, (address + size - 1) / BLOCK_SIZE);
+    }
+
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUMemoryAccess::try_compare_memory(const uint64_t address1, const uint64_t address2,
+    const uint64_t size, uint64_t & offset) const
+{
+    if (!in_bounds(address1, size) || !in_bounds(address2, size)) {
+        return SysdarftFaultType::IllegalMemoryAccess;
+    }
+
+    // memcmp() only tells there is a difference, which byte it is is looked for in that chunk alone
+    constexpr uint64_t chunk_size = 256;
+    for (offset = 0; offset < size; offset += chunk_size)
+    {
+        if (std::memcmp(Memory + address1 + offset, Memory + address2 + offset,
+                std::min(chunk_size, size - offset)) != 0)
+        {
+            while (Memory[address1 + offset] == Memory[address2 + offset]) {
+                offset++;
+            }
+
+            return SysdarftFaultType::None;
         }
     }
+
+    offset = size;
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUMemoryAccess::try_scan_memory(const uint64_t address, const uint8_t value,
+    const uint64_t size, uint64_t & offset) const
+{
+    if (!in_bounds(address, size)) {
+        return SysdarftFaultType::IllegalMemoryAccess;
+    }
+
+    const auto found = static_cast<const uint8_t *>(std::memchr(Memory + address, value, size));
+    offset = found ? found - (Memory + address) : size;
+    return SysdarftFaultType::None;
+}
+
+std::span < uint8_t > SysdarftCPUMemoryAccess::dma_span(const uint64_t address, const uint64_t size) const
+{
+    if (size == 0 || !in_bounds(address, size)) {
+        return { };
+    }
+
+    return { Memory + address, size };
+}
+
+void SysdarftCPUMemoryAccess::dma_written(const uint64_t address, const uint64_t size)
+{
+    if (size == 0) {
+        return;
+    }
+
+    // same ordering as write_memory(), the device may not be running on the CPU thread
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    mark_dirty_pages(address / BLOCK_SIZE, (address + size - 1) / BLOCK_SIZE);
+    invalidate_code_blocks(address / BLOCK_SIZE, (address + size - 1) / BLOCK_SIZE);
 }
@@ -0,0 +1,380 @@
+/* SysdarftPaging.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <vector>
+#include <SysdarftPaging.h>
+
+SysdarftFaultType SysdarftCPUPaging::page_fault(const uint64_t linear_address)
+{
+    Registers.ProtectedModeRegisters.PageFaultAddress = linear_address;
+    return SysdarftFaultType::PageFault;
+}
+
+SysdarftFaultType SysdarftCPUPaging::walk_page_table(const uint64_t linear_address, const GuestAccessType Access,
+    uint64_t & physical_address)
+{
+    count(TLBMisses);
+
+    const uint64_t page = linear_address / GUEST_PAGE_SIZE;
+    if (page >= Registers.ProtectedModeRegisters.SelectorSPaceSize) {
+        return page_fault(linear_address);
+    }
+
+    // a page table out of physical memory maps nothing
+    uint64_t page_table_entry = 0;
+    if (try_load_memory(Registers.ProtectedModeRegisters.SelectorSpaceStart + page * sizeof(uint64_t),
+            page_table_entry) != SysdarftFaultType::None
+        || !(page_table_entry & PAGE_PRESENT))
+    {
+        return page_fault(linear_address);
+    }
+
+    auto & entry = TLB[page % TLB_ENTRIES];
+    entry.LinearPage = page;
+    entry.PhysicalAddress = page_table_entry & PAGE_ADDRESS_MASK;
+    entry.Permissions = page_table_entry & (PAGE_WRITABLE | PAGE_USER);
+
+    if (!access_permitted(entry.Permissions, Access)) {
+        return page_fault(linear_address);
+    }
+
+    physical_address = entry.PhysicalAddress + linear_address % GUEST_PAGE_SIZE;
+    return SysdarftFaultType::None;
+}
+
+void SysdarftCPUPaging::flush_tlb()
+{
+    TLB.fill(TLBEntryType { });
+    count(TLBFlushes);
+}
+
+void SysdarftCPUPaging::flush_tlb_entry(const uint64_t linear_address)
+{
+    const uint64_t page = linear_address / GUEST_PAGE_SIZE;
+    if (auto & entry = TLB[page % TLB_ENTRIES]; entry.LinearPage == page) {
+        entry = TLBEntryType { };
+    }
+}
+
+void SysdarftCPUPaging::restore_privileged_state(const sysdarft_register_t & Previous)
+{
+    auto & Current = Registers;
+
+    if (Previous.FlagRegister.ProtectedModeEnabled
+        && Previous.FlagRegister.CurrentPrivilegeLevel == USER_PRIVILEGE_LEVEL)
+    {
+        Current.FlagRegister.CurrentPrivilegeLevel = Previous.FlagRegister.CurrentPrivilegeLevel;
+        Current.FlagRegister.ProtectedModeEnabled = Previous.FlagRegister.ProtectedModeEnabled;
+        Current.FlagRegister.PagingEnabled = Previous.FlagRegister.PagingEnabled;
+        Current.FlagRegister.InterruptionMask = Previous.FlagRegister.InterruptionMask;
+        Current.ProtectedModeRegisters = Previous.ProtectedModeRegisters;
+        return;
+    }
+
+    if (Current.FlagRegister.PagingEnabled != Previous.FlagRegister.PagingEnabled
+        || Current.ProtectedModeRegisters.SelectorSpaceStart != Previous.ProtectedModeRegisters.SelectorSpaceStart
+        || Current.ProtectedModeRegisters.SelectorSPaceSize != Previous.ProtectedModeRegisters.SelectorSPaceSize)
+    {
+        flush_tlb();
+        translation_changed();
+    }
+}
+
+SysdarftFaultType SysdarftCPUPaging::try_read_linear(const uint64_t address, char * _dest, const uint64_t size,
+    const GuestAccessType Access)
+{
+    if (!paging_enabled()) {
+        return heatmap_count(try_read_memory(address, _dest, size), address, size, Access);
+    }
+
+    uint64_t done = 0;
+    while (done < size)
+    {
+        const uint64_t linear_address = address + done;
+        const uint64_t length = std::min(size - done, GUEST_PAGE_SIZE - linear_address % GUEST_PAGE_SIZE);
+
+        uint64_t physical_address;
+        if (const auto fault = translate(linear_address, Access, physical_address);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        if (const auto fault = heatmap_count(try_read_memory(physical_address, _dest + done, length),
+                physical_address, length, Access);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        done += length;
+    }
+
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUPaging::try_write_linear(const uint64_t address, const char * _source, const uint64_t size)
+{
+    if (!paging_enabled()) {
+        return heatmap_count(try_write_memory(address, _source, size), address, size, GuestAccessType::Write);
+    }
+
+    // translate everything first, so a fault halfway through leaves memory untouched
+    struct SpanType { uint64_t physical_address, offset, length; };
+    std::vector < SpanType > spans;
+
+    uint64_t done = 0;
+    while (done < size)
+    {
+        const uint64_t linear_address = address + done;
+        const uint64_t length = std::min(size - done, GUEST_PAGE_SIZE - linear_address % GUEST_PAGE_SIZE);
+
+        uint64_t physical_address;
+        if (const auto fault = translate(linear_address, GuestAccessType::Write, physical_address);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        if (!in_bounds(physical_address, length)) {
+            return SysdarftFaultType::IllegalMemoryAccess;
+        }
+
+        spans.push_back({ physical_address, done, length });
+        done += length;
+    }
+
+    for (const auto & [physical_address, offset, length] : spans)
+    {
+        if (const auto fault = heatmap_count(try_write_memory(physical_address, _source + offset, length),
+                physical_address, length, GuestAccessType::Write);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+    }
+
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUPaging::probe_linear(const uint64_t address, const uint64_t size,
+    const GuestAccessType Access)
+{
+    uint64_t done = 0;
+    while (done < size)
+    {
+        const uint64_t linear_address = address + done;
+        const uint64_t length = std::min(size - done, GUEST_PAGE_SIZE - linear_address % GUEST_PAGE_SIZE);
+
+        uint64_t physical_address;
+        if (const auto fault = translate(linear_address, Access, physical_address);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        if (!in_bounds(physical_address, length)) {
+            return SysdarftFaultType::IllegalMemoryAccess;
+        }
+
+        done += length;
+    }
+
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUPaging::try_move_linear(const uint64_t dest, const uint64_t source, const uint64_t size)
+{
+    if (!paging_enabled()) {
+        return count_move(try_move_memory(dest, source, size), dest, source, size);
+    }
+
+    if (const auto fault = probe_linear(source, size, GuestAccessType::Read); fault != SysdarftFaultType::None) {
+        return fault;
+    }
+
+    if (const auto fault = probe_linear(dest, size, GuestAccessType::Write); fault != SysdarftFaultType::None) {
+        return fault;
+    }
+
+    // spans are contiguous on both sides. Moving up into an overlapping range starts from the end,
+    // so nothing is overwritten before it is moved
+    const bool backwards = dest > source && dest - source < size;
+    uint64_t remaining = size;
+    while (remaining != 0)
+    {
+        uint64_t offset, length;
+        if (backwards) {
+            length = std::min({ remaining,
+                (source + remaining - 1) % GUEST_PAGE_SIZE + 1,
+                (dest + remaining - 1) % GUEST_PAGE_SIZE + 1 });
+            offset = remaining - length;
+        } else {
+            offset = size - remaining;
+            length = std::min({ remaining,
+                GUEST_PAGE_SIZE - (source + offset) % GUEST_PAGE_SIZE,
+                GUEST_PAGE_SIZE - (dest + offset) % GUEST_PAGE_SIZE });
+        }
+
+        uint64_t physical_source, physical_dest;
+        if (const auto fault = translate(source + offset, GuestAccessType::Read, physical_source);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        if (const auto fault = translate(dest + offset, GuestAccessType::Write, physical_dest);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        if (const auto fault = count_move(try_move_memory(physical_dest, physical_source, length),
+                physical_dest, physical_source, length);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        remaining -= length;
+    }
+
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUPaging::try_fill_linear(const uint64_t address, const uint8_t value, const uint64_t size)
+{
+    if (!paging_enabled()) {
+        return heatmap_count(try_fill_memory(address, value, size), address, size, GuestAccessType::Write);
+    }
+
+    if (const auto fault = probe_linear(address, size, GuestAccessType::Write); fault != SysdarftFaultType::None) {
+        return fault;
+    }
+
+    uint64_t done = 0;
+    while (done < size)
+    {
+        const uint64_t linear_address = address + done;
+        const uint64_t length = std::min(size - done, GUEST_PAGE_SIZE - linear_address % GUEST_PAGE_SIZE);
+
+        uint64_t physical_address;
+        if (const auto fault = translate(linear_address, GuestAccessType::Write, physical_address);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        if (const auto fault = heatmap_count(try_fill_memory(physical_address, value, length),
+                physical_address, length, GuestAccessType::Write);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        done += length;
+    }
+
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUPaging::try_compare_linear(const uint64_t address1, const uint64_t address2,
+    const uint64_t size, uint64_t & offset)
+{
+    if (!paging_enabled()) {
+        const auto fault = try_compare_memory(address1, address2, size, offset);
+        return count_compare(fault, address1, address2, size, offset);
+    }
+
+    uint64_t done = 0;
+    while (done < size)
+    {
+        const uint64_t length = std::min({ size - done,
+            GUEST_PAGE_SIZE - (address1 + done) % GUEST_PAGE_SIZE,
+            GUEST_PAGE_SIZE - (address2 + done) % GUEST_PAGE_SIZE });
+
+        uint64_t physical_address1, physical_address2, difference;
+        if (const auto fault = translate(address1 + done, GuestAccessType::Read, physical_address1);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        if (const auto fault = translate(address2 + done, GuestAccessType::Read, physical_address2);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        const auto fault = try_compare_memory(physical_address1, physical_address2, length, difference);
+        if (count_compare(fault, physical_address1, physical_address2, length, difference) != SysdarftFaultType::None) {
+            return fault;
+        }
+
+        if (difference != length) {
+            offset = done + difference;
+            return SysdarftFaultType::None;
+        }
+
+        done += length;
+    }
+
+    offset = size;
+    return SysdarftFaultType::None;
+}
+
+SysdarftFaultType SysdarftCPUPaging::try_scan_linear(const uint64_t address, const uint8_t value,
+    const uint64_t size, uint64_t & offset)
+{
+    if (!paging_enabled()) {
+        const auto fault = try_scan_memory(address, value, size, offset);
+        return count_scan(fault, address, size, offset);
+    }
+
+    uint64_t done = 0;
+    while (done < size)
+    {
+        const uint64_t linear_address = address + done;
+        const uint64_t length = std::min(size - done, GUEST_PAGE_SIZE - linear_address % GUEST_PAGE_SIZE);
+
+        uint64_t physical_address, found;
+        if (const auto fault = translate(linear_address, GuestAccessType::Read, physical_address);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        const auto fault = try_scan_memory(physical_address, value, length, found);
+        if (count_scan(fault, physical_address, length, found) != SysdarftFaultType::None) {
+            return fault;
+        }
+
+        if (found != length) {
+            offset = done + found;
+            return SysdarftFaultType::None;
+        }
+
+        done += length;
+    }
+
+    offset = size;
+    return SysdarftFaultType::None;
+}
@@ -0,0 +1,367 @@
+/* SysdarftAsyncIO.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <SysdarftAsyncIO.h>
+
+// no liburing, io_uring is set up and driven through its system calls directly
+static int io_uring_setup(const unsigned entries, io_uring_params * params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(const int fd, const unsigned to_submit, const unsigned min_complete, const unsigned flags,
+    const io_uring_getevents_arg * arg = nullptr)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+        arg, arg == nullptr ? 0 : sizeof(*arg)));
+}
+
+SysdarftAsyncIO::SysdarftAsyncIO(const SysdarftAsyncIOBackend preferred)
+{
+    if (preferred == SysdarftAsyncIOBackend::IOUring && setup_io_uring())
+    {
+        Backend = SysdarftAsyncIOBackend::IOUring;
+        Reaper = std::thread(&SysdarftAsyncIO::reap_io_uring, this);
+    }
+    else
+    {
+        Backend = SysdarftAsyncIOBackend::ThreadPool;
+        std::lock_guard lock(QueueMutex);
+        start_workers();
+    }
+
+    log("[AsyncIO] Asynchronous disk I/O runs on ", backend_name(Backend), "\n");
+}
+
+SysdarftAsyncIO::~SysdarftAsyncIO()
+{
+    {
+        std::unique_lock lock(InFlightMutex);
+        InFlightChanged.wait(lock, [this] { return InFlight == 0; });
+    }
+
+    if (Backend == SysdarftAsyncIOBackend::IOUring)
+    {
+        // the no-op only wakes the reaper up early, it sees ReaperStopping within a timeout anyway
+        ReaperStopping = true;
+        queue_io_uring(IORING_OP_NOP, nullptr);
+        Reaper.join();
+        teardown_io_uring();
+    }
+
+    {
+        std::lock_guard lock(QueueMutex);
+        Stopping = true;
+    }
+
+    QueueChanged.notify_all();
+    for (auto & worker : Workers) {
+        worker.join();
+    }
+}
+
+const char * SysdarftAsyncIO::backend_name(const SysdarftAsyncIOBackend backend)
+{
+    switch (backend) {
+    case SysdarftAsyncIOBackend::IOUring: return "io_uring";
+    case SysdarftAsyncIOBackend::ThreadPool: return "thread pool";
+    default: return "unknown";
+    }
+}
+
+bool SysdarftAsyncIO::setup_io_uring()
+{
+    io_uring_params params { };
+    Ring.fd = io_uring_setup(ASYNC_IO_QUEUE_DEPTH, &params);
+    if (Ring.fd < 0) {
+        log("[AsyncIO] io_uring is not available: ", std::strerror(errno), "\n");
+        return false;
+    }
+
+    // the reaper counts on every completion making it to the completion queue
+    if (!(params.features & IORING_FEAT_NODROP)) {
+        log("[AsyncIO] io_uring of this host can drop completions, not using it\n");
+        teardown_io_uring();
+        return false;
+    }
+
+    // nor can it be stopped when its wait cannot time out
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        log("[AsyncIO] io_uring of this host cannot wait with a timeout, not using it\n");
+        teardown_io_uring();
+        return false;
+    }
+
+    Ring.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    Ring.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        Ring.sq_ring_size = Ring.cq_ring_size = std::max(Ring.sq_ring_size, Ring.cq_ring_size);
+    }
+
+    Ring.sq_ring = mmap(nullptr, Ring.sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        Ring.fd, IORING_OFF_SQ_RING);
+    if (Ring.sq_ring == MAP_FAILED) {
+        Ring.sq_ring = nullptr;
+        teardown_io_uring();
+        return false;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        Ring.cq_ring = Ring.sq_ring;
+    } else {
+        Ring.cq_ring = mmap(nullptr, Ring.cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            Ring.fd, IORING_OFF_CQ_RING);
+        if (Ring.cq_ring == MAP_FAILED) {
+            Ring.cq_ring = nullptr;
+            teardown_io_uring();
+            return false;
+        }
+    }
+
+    Ring.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    Ring.sqes = mmap(nullptr, Ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        Ring.fd, IORING_OFF_SQES);
+    if (Ring.sqes == MAP_FAILED) {
+        Ring.sqes = nullptr;
+        teardown_io_uring();
+        return false;
+    }
+
+    const auto sq = static_cast<uint8_t *>(Ring.sq_ring);
+    Ring.sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    Ring.sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    Ring.sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    Ring.sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    const auto cq = static_cast<uint8_t *>(Ring.cq_ring);
+    Ring.cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    Ring.cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    Ring.cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    Ring.cqes = cq + params.cq_off.cqes;
+    return true;
+}
+
+void SysdarftAsyncIO::teardown_io_uring()
+{
+    if (Ring.sqes != nullptr) {
+        munmap(Ring.sqes, Ring.sqes_size);
+    }
+
+    if (Ring.cq_ring != nullptr && Ring.cq_ring != Ring.sq_ring) {
+        munmap(Ring.cq_ring, Ring.cq_ring_size);
+    }
+
+    if (Ring.sq_ring != nullptr) {
+        munmap(Ring.sq_ring, Ring.sq_ring_size);
+    }
+
+    if (Ring.fd >= 0) {
+        close(Ring.fd);
+    }
+
+    Ring = { };
+}
+
+bool SysdarftAsyncIO::queue_io_uring(const uint8_t opcode, RequestType * request)
+{
+    std::lock_guard lock(SubmitMutex);
+
+    // submission entries are taken by the kernel inside io_uring_enter(), or taken back below when it fails,
+    // so the queue is always empty here
+    const unsigned tail = std::atomic_ref(*Ring.sq_tail).load(std::memory_order_relaxed);
+    const unsigned index = tail & Ring.sq_mask;
+    auto & sqe = static_cast<io_uring_sqe *>(Ring.sqes)[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.fd = -1;
+    sqe.user_data = reinterpret_cast<uint64_t>(request);
+    if (request != nullptr)
+    {
+        sqe.fd = request->disk->host_file();
+        sqe.addr = reinterpret_cast<uint64_t>(&request->vector);
+        sqe.len = 1;
+        sqe.off = request->start * DISK_SECTOR_SIZE;
+    }
+
+    Ring.sq_array[index] = index;
+    std::atomic_ref(*Ring.sq_tail).store(tail + 1, std::memory_order_release);
+
+    while (io_uring_enter(Ring.fd, 1, 0, 0) < 0)
+    {
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            // the kernel has not consumed the entry, leaving it there would submit it with the next one
+            log("[AsyncIO] io_uring submission failed: ", std::strerror(errno), "\n");
+            std::atomic_ref(*Ring.sq_tail).store(tail, std::memory_order_release);
+            return false;
+        }
+
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+void SysdarftAsyncIO::reap_io_uring()
+{
+    debug::set_thread_name("AsyncIO");
+    __kernel_timespec timeout { .tv_sec = 0, .tv_nsec = ASYNC_IO_REAP_TIMEOUT_MS * 1000000 };
+    io_uring_getevents_arg wait_arg { };
+    wait_arg.ts = reinterpret_cast<uint64_t>(&timeout);
+    while (true)
+    {
+        const unsigned head = std::atomic_ref(*Ring.cq_head).load(std::memory_order_relaxed);
+        if (head == std::atomic_ref(*Ring.cq_tail).load(std::memory_order_acquire))
+        {
+            // nothing is in flight by the time it is asked to stop, so nothing is left to reap
+            if (ReaperStopping) {
+                return;
+            }
+
+            if (io_uring_enter(Ring.fd, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &wait_arg) < 0
+                && errno != EINTR && errno != ETIME)
+            {
+                log("[AsyncIO] io_uring wait failed: ", std::strerror(errno), "\n");
+            }
+
+            continue;
+        }
+
+        const auto cqe = static_cast<io_uring_cqe *>(Ring.cqes)[head & Ring.cq_mask];
+        std::atomic_ref(*Ring.cq_head).store(head + 1, std::memory_order_release);
+
+        // a request of nullptr is the no-op waking the reaper up to stop
+        if (cqe.user_data == 0) {
+            continue;
+        }
+
+        complete(reinterpret_cast<RequestType *>(cqe.user_data), cqe.res < 0 ? 0 : cqe.res);
+    }
+}
+
+void SysdarftAsyncIO::start_workers()
+{
+    const auto threads = std::clamp<unsigned>(std::thread::hardware_concurrency(), 1, ASYNC_IO_THREADS);
+    for (unsigned i = 0; i < threads; i++) {
+        Workers.emplace_back(&SysdarftAsyncIO::work, this);
+    }
+}
+
+void SysdarftAsyncIO::work()
+{
+    debug::set_thread_name("AsyncIO");
+    while (true)
+    {
+        RequestType * request;
+        {
+            std::unique_lock lock(QueueMutex);
+            QueueChanged.wait(lock, [this] { return Stopping || !Queue.empty(); });
+            if (Queue.empty()) {
+                return;
+            }
+
+            request = Queue.front();
+            Queue.pop_front();
+        }
+
+        const bool done = request->write
+            ? request->disk->write_sectors(request->start, request->count, request->buffer)
+            : request->disk->read_sectors(request->start, request->count, request->buffer);
+        complete(request, done ? request->vector.iov_len : 0);
+    }
+}
+
+void SysdarftAsyncIO::complete(RequestType * request, uint64_t transferred)
+{
+    const uint64_t length = request->vector.iov_len;
+    const int fd = request->disk->host_file();
+    const uint64_t offset = request->start * DISK_SECTOR_SIZE;
+
+    // io_uring can stop short like pread() and pwrite() do, the rest is done here.
+    // Nothing was transferred means it failed
+    while (transferred != 0 && transferred < length)
+    {
+        const auto result = request->write
+            ? pwrite64(fd, request->buffer + transferred, length - transferred,
+                static_cast<off64_t>(offset + transferred))
+            : pread64(fd, request->buffer + transferred, length - transferred,
+                static_cast<off64_t>(offset + transferred));
+        if (result <= 0) {
+            break;
+        }
+
+        transferred += result;
+    }
+
+    request->completion(transferred == length);
+    delete request;
+
+    {
+        std::lock_guard lock(InFlightMutex);
+        InFlight--;
+    }
+
+    InFlightChanged.notify_all();
+}
+
+void SysdarftAsyncIO::submit(SysdarftSectorAccess & disk, const bool write, const uint64_t start,
+    const uint64_t count, uint8_t * buffer, CompletionType completion)
+{
+    {
+        std::unique_lock lock(InFlightMutex);
+        InFlightChanged.wait(lock, [this] { return InFlight < ASYNC_IO_QUEUE_DEPTH; });
+        InFlight++;
+    }
+
+    const auto request = new RequestType {
+        .disk = &disk,
+        .write = write,
+        .start = start,
+        .count = count,
+        .buffer = buffer,
+        .completion = std::move(completion),
+        .vector = { .iov_base = buffer, .iov_len = count * DISK_SECTOR_SIZE },
+    };
+
+    // a request io_uring could not take is done by the thread pool instead
+    if (Backend == SysdarftAsyncIOBackend::IOUring && disk.host_file() >= 0
+        && queue_io_uring(write ? IORING_OP_WRITEV : IORING_OP_READV, request))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard lock(QueueMutex);
+        if (Workers.empty()) {
+            start_workers();
+        }
+
+        Queue.push_back(request);
+    }
+
+    QueueChanged.notify_one();
+}
@@ -18,6 +18,8 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#include <mutex>
+#include <set>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -53,3 +55,29 @@ int lock_file(const int fd, const int cmd, const int type)
 
     return 0;
 }
+
+// files attached as disks by this process, by device and inode
+static std::mutex AttachedFilesMutex;
+static std::set < std::pair < dev_t, ino_t > > AttachedFiles;
+
+bool attach_file(const int fd)
+{
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) == -1) {
+        return false;
+    }
+
+    std::lock_guard lock(AttachedFilesMutex);
+    return AttachedFiles.emplace(file_stat.st_dev, file_stat.st_ino).second;
+}
+
+void detach_file(const int fd)
+{
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) == -1) {
+        return;
+    }
+
+    std::lock_guard lock(AttachedFilesMutex);
+    AttachedFiles.erase({ file_stat.st_dev, file_stat.st_ino });
+}
@@ -0,0 +1,150 @@
+/* SysdarftDMA.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <SysdarftDMA.h>
+
+SysdarftDMAController::SysdarftDMAController(SysdarftCPU & _instance, const DMADeviceListType & devices)
+    : m_cpu(_instance), m_devices(devices)
+{
+    device_buffer.emplace(DMA_REG_DEVICE,       std::make_unique<ControllerDataStream>());
+    device_buffer.emplace(DMA_REG_START_SEC,    std::make_unique<ControllerDataStream>());
+    device_buffer.emplace(DMA_REG_SEC_COUNT,    std::make_unique<ControllerDataStream>());
+    device_buffer.emplace(DMA_REG_ADDRESS,      std::make_unique<ControllerDataStream>());
+    device_buffer.emplace(DMA_REG_INTERRUPT,    std::make_unique<ControllerDataStream>());
+    device_buffer.emplace(DMA_CMD_READ,         std::make_unique<ControllerDataStream>());
+    device_buffer.emplace(DMA_CMD_WRITE,        std::make_unique<ControllerDataStream>());
+    device_buffer.emplace(DMA_REG_MODE,         std::make_unique<ControllerDataStream>());
+    device_buffer.emplace(DMA_REG_STATUS,       std::make_unique<ControllerDataStream>());
+}
+
+bool SysdarftDMAController::transfer(const bool to_memory)
+{
+    // one transfer at a time
+    if (status.load(std::memory_order_acquire) == DMA_STATUS_BUSY) {
+        return false;
+    }
+
+    if (device >= DMA_DEVICE_COUNT || m_devices[device] == nullptr) {
+        return false;
+    }
+
+    const auto disk = m_devices[device];
+    if (sector_count == 0 || sector_count > disk->sectors() || start_sector > disk->sectors() - sector_count) {
+        return false;
+    }
+
+    const uint64_t length = sector_count * DISK_SECTOR_SIZE;
+    const auto memory = m_cpu.dma_span(address, length);
+    if (memory.empty()) {
+        return false;
+    }
+
+    if (mode == DMA_MODE_ASYNC)
+    {
+        if (!async_io) {
+            async_io = std::make_unique<SysdarftAsyncIO>();
+        }
+
+        status.store(DMA_STATUS_BUSY, std::memory_order_release);
+        async_io->submit(*disk, !to_memory, start_sector, sector_count, memory.data(),
+            [this, to_memory, memory_address = address, length, interruption = interruption_number]
+            (const bool done) {
+                complete(to_memory, memory_address, length, interruption, done);
+            });
+        return true;
+    }
+
+    const bool done = to_memory
+        ? disk->read_sectors(start_sector, sector_count, memory.data())
+        : disk->write_sectors(start_sector, sector_count, memory.data());
+
+    // a failed synchronous transfer is reported by failing the command, not by an interruption
+    complete(to_memory, address, length, done ? interruption_number : 0, done);
+    return done;
+}
+
+void SysdarftDMAController::complete(const bool to_memory, const uint64_t memory_address, const uint64_t length,
+    const uint64_t interruption, const bool done)
+{
+    // a failed read may have written part of the range all the same
+    if (to_memory) {
+        m_cpu.dma_written(memory_address, length);
+    }
+
+    status.store(done ? DMA_STATUS_DONE : DMA_STATUS_FAILED, std::memory_order_release);
+
+    if (interruption > 0x1F) {
+        m_cpu.do_ext_dev_interruption(interruption, true);
+    }
+}
+
+bool SysdarftDMAController::request_read(const uint64_t port)
+{
+    if (port == DMA_REG_STATUS) {
+        device_buffer.at(port)->push(status.load(std::memory_order_acquire));
+        return true;
+    }
+
+    return false;
+}
+
+bool SysdarftDMAController::request_write(const uint64_t port)
+{
+    // one value per write, anything past it is dropped so it cannot end up in the next one
+    const auto stream = device_buffer.at(port).get();
+    const auto data = stream->pop<uint64_t>();
+    stream->clear();
+
+    switch (port)
+    {
+    case DMA_REG_DEVICE:
+        device = data;
+        return true;
+    case DMA_REG_START_SEC:
+        start_sector = data;
+        return true;
+    case DMA_REG_SEC_COUNT:
+        sector_count = data;
+        return true;
+    case DMA_REG_ADDRESS:
+        address = data;
+        return true;
+    case DMA_REG_INTERRUPT:
+        if (data >= MAX_INTERRUPTION_ENTRY) {
+            return false;
+        }
+
+        interruption_number = data;
+        return true;
+    case DMA_REG_MODE:
+        if (data != DMA_MODE_SYNC && data != DMA_MODE_ASYNC) {
+            return false;
+        }
+
+        mode = data;
+        return true;
+    case DMA_CMD_READ:
+        return transfer(true);
+    case DMA_CMD_WRITE:
+        return transfer(false);
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,220 @@
+/* SysdarftDiskCache.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+#include <SysdarftDiskCache.h>
+
+static bool read_fully(const int fd, uint8_t * dest, const uint64_t length, const uint64_t offset)
+{
+    uint64_t done = 0;
+    while (done < length)
+    {
+        const auto read_len = pread64(fd, dest + done, length - done, static_cast<off64_t>(offset + done));
+        if (read_len <= 0) {
+            return false;
+        }
+
+        done += read_len;
+    }
+
+    return true;
+}
+
+static bool write_fully(const int fd, const uint8_t * source, const uint64_t length, const uint64_t offset)
+{
+    uint64_t done = 0;
+    while (done < length)
+    {
+        const auto write_len = pwrite64(fd, source + done, length - done, static_cast<off64_t>(offset + done));
+        if (write_len <= 0) {
+            return false;
+        }
+
+        done += write_len;
+    }
+
+    return true;
+}
+
+SysdarftDiskCache::SysdarftDiskCache(const int _fd, const uint64_t _device_size,
+    const SysdarftDiskCachePolicy _policy)
+    : fd(_fd), device_size(_device_size), policy(_policy),
+      flush_worker(this, &SysdarftDiskCache::flush_periodically)
+{
+    if (policy == SysdarftDiskCachePolicy::WriteBack) {
+        flush_worker.start();
+    }
+}
+
+SysdarftDiskCache::~SysdarftDiskCache()
+{
+    flush_worker.stop();
+
+    std::lock_guard lock(CacheMutex);
+    if (!write_back_all()) {
+        log("[DiskCache] Failed to write back the disk cache, the disk image is incomplete\n");
+    }
+
+    if (policy == SysdarftDiskCachePolicy::WriteBack) {
+        fdatasync(fd);
+    }
+}
+
+SysdarftDiskCache::BlockType * SysdarftDiskCache::lookup(const uint64_t block, const bool overwritten)
+{
+    if (const auto it = Blocks.find(block); it != Blocks.end()) {
+        LRU.splice(LRU.begin(), LRU, it->second.lru);
+        return &it->second;
+    }
+
+    // make room, a block that cannot be written back stays
+    for (auto victim = LRU.end(); Blocks.size() >= DISK_CACHE_BLOCKS && victim != LRU.begin(); )
+    {
+        --victim;
+        auto & entry = Blocks.at(*victim);
+        if (entry.dirty && !write_back(*victim, entry)) {
+            continue;
+        }
+
+        Blocks.erase(*victim);
+        victim = LRU.erase(victim);
+    }
+
+    const uint64_t offset = block * DISK_CACHE_BLOCK_SIZE;
+    BlockType entry {
+        .data = std::make_unique_for_overwrite < uint8_t[] > (DISK_CACHE_BLOCK_SIZE),
+        .length = std::min < uint64_t > (DISK_CACHE_BLOCK_SIZE, device_size - offset),
+        .dirty = false,
+        .lru = { },
+    };
+
+    if (!overwritten && !read_fully(fd, entry.data.get(), entry.length, offset)) {
+        return nullptr;
+    }
+
+    LRU.push_front(block);
+    entry.lru = LRU.begin();
+    return &Blocks.emplace(block, std::move(entry)).first->second;
+}
+
+bool SysdarftDiskCache::write_back(const uint64_t block, BlockType & entry) const
+{
+    if (!write_fully(fd, entry.data.get(), entry.length, block * DISK_CACHE_BLOCK_SIZE)) {
+        return false;
+    }
+
+    entry.dirty = false;
+    return true;
+}
+
+bool SysdarftDiskCache::write_back_all()
+{
+    bool done = true;
+    for (auto & [block, entry] : Blocks)
+    {
+        if (entry.dirty && !write_back(block, entry)) {
+            done = false;
+        }
+    }
+
+    return done;
+}
+
+bool SysdarftDiskCache::read(const uint64_t offset, const uint64_t length, uint8_t * dest)
+{
+    std::lock_guard lock(CacheMutex);
+    for (uint64_t done = 0; done < length; )
+    {
+        const uint64_t block = (offset + done) / DISK_CACHE_BLOCK_SIZE;
+        const uint64_t block_offset = (offset + done) % DISK_CACHE_BLOCK_SIZE;
+        const auto entry = lookup(block, false);
+        if (entry == nullptr) {
+            return false;
+        }
+
+        const uint64_t chunk = std::min(entry->length - block_offset, length - done);
+        std::memcpy(dest + done, entry->data.get() + block_offset, chunk);
+        done += chunk;
+    }
+
+    return true;
+}
+
+bool SysdarftDiskCache::write(const uint64_t offset, const uint64_t length, const uint8_t * source)
+{
+    std::lock_guard lock(CacheMutex);
+    for (uint64_t done = 0; done < length; )
+    {
+        const uint64_t block = (offset + done) / DISK_CACHE_BLOCK_SIZE;
+        const uint64_t block_offset = (offset + done) % DISK_CACHE_BLOCK_SIZE;
+        const uint64_t block_length = std::min < uint64_t > (DISK_CACHE_BLOCK_SIZE,
+            device_size - block * DISK_CACHE_BLOCK_SIZE);
+        const uint64_t chunk = std::min(block_length - block_offset, length - done);
+        const auto entry = lookup(block, block_offset == 0 && chunk == block_length);
+        if (entry == nullptr) {
+            return false;
+        }
+
+        std::memcpy(entry->data.get() + block_offset, source + done, chunk);
+        entry->dirty = true;
+        done += chunk;
+    }
+
+    return true;
+}
+
+bool SysdarftDiskCache::flush()
+{
+    if (policy == SysdarftDiskCachePolicy::Unsafe) {
+        return true;
+    }
+
+    {
+        std::lock_guard lock(CacheMutex);
+        if (!write_back_all()) {
+            return false;
+        }
+    }
+
+    return fdatasync(fd) == 0;
+}
+
+void SysdarftDiskCache::flush_periodically(std::atomic < bool > & running)
+{
+    debug::set_thread_name("DiskCache");
+    constexpr auto step = std::chrono::milliseconds(100);
+    auto waited = std::chrono::milliseconds(0);
+
+    while (running)
+    {
+        std::this_thread::sleep_for(step);
+        waited += step;
+        if (waited < std::chrono::seconds(DISK_CACHE_FLUSH_INTERVAL)) {
+            continue;
+        }
+
+        waited = std::chrono::milliseconds(0);
+        if (!flush()) {
+            log("[DiskCache] Periodic flush of the disk cache failed\n");
+        }
+    }
+}
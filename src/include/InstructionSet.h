@@ -22,14 +22,10 @@
 #define INSTRUCTION_DEFINITION_H
 
 #include <unordered_map>
-#include <map>
+#include <array>
 #include <string>
 #include <cstdint>
 
-#define ENTRY_OPCODE "opcode"
-#define ENTRY_ARGUMENT_COUNT "argument_count"
-#define ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION "require_operation_width_specification"
-
 #define OPCODE_NOP      (0x00)
 #define OPCODE_ADD      (0x01)
 #define OPCODE_ADC      (0x02)
@@ -65,6 +61,9 @@
 #define OPCODE_LEAVE    (0x27)
 #define OPCODE_MOVS     (0x28)
 #define OPCODE_LEA      (0x29)
+#define OPCODE_STOS     (0x2A)
+#define OPCODE_CMPS     (0x2B)
+#define OPCODE_SCAS     (0x2C)
 
 #define OPCODE_JMP      (0x30)
 #define OPCODE_CALL     (0x31)
@@ -93,424 +92,131 @@
 #define OPCODE_INS      (0x52)
 #define OPCODE_OUTS     (0x53)
 
-// Initialize the instruction to opcode mapping
-const std::unordered_map<std::string, std::map<std::string, uint64_t>> instruction_map = {
-    {"NOP", {
-         {ENTRY_OPCODE, OPCODE_NOP},
-         {ENTRY_ARGUMENT_COUNT, 0},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"ADD", {
-         {ENTRY_OPCODE, OPCODE_ADD},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"ADC", {
-         {ENTRY_OPCODE, OPCODE_ADC},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"SUB", {
-         {ENTRY_OPCODE, OPCODE_SUB},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"SBB", {
-         {ENTRY_OPCODE, OPCODE_SBB},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"IMUL", {
-         {ENTRY_OPCODE, OPCODE_IMUL},
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"MUL", {
-         {ENTRY_OPCODE, OPCODE_MUL},
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"IDIV", {
-         {ENTRY_OPCODE, OPCODE_IDIV},
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"DIV", {
-         {ENTRY_OPCODE, OPCODE_DIV},
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"NEG", {
-         {ENTRY_OPCODE, OPCODE_NEG},
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"CMP", {
-         {ENTRY_OPCODE, OPCODE_CMP},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"INC", {
-               {ENTRY_OPCODE, OPCODE_INC},
-               {ENTRY_ARGUMENT_COUNT, 1},
-               {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-           }
-    },
-
-    {"DEC", {
-               {ENTRY_OPCODE, OPCODE_DEC},
-               {ENTRY_ARGUMENT_COUNT, 1},
-               {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-           }
-    },
-
-    ////////////////////////////////////////////////////////////////////////////////////////////
-
-    {"AND", {
-         {ENTRY_OPCODE, OPCODE_AND},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"OR", {
-         {ENTRY_OPCODE, OPCODE_OR},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"XOR", {
-         {ENTRY_OPCODE, OPCODE_XOR},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"NOT", {
-         {ENTRY_OPCODE, OPCODE_NOT},
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"SHL", {
-         {ENTRY_OPCODE, OPCODE_SHL},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"SHR", {
-         {ENTRY_OPCODE, OPCODE_SHR},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"ROL", {
-                 {ENTRY_OPCODE, OPCODE_ROL},
-                 {ENTRY_ARGUMENT_COUNT, 2},
-                 {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-             }
-    },
-
-    {"ROR", {
-         {ENTRY_OPCODE, OPCODE_ROR},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"RCL", {
-         {ENTRY_OPCODE, OPCODE_RCL},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"RCR", {
-         {ENTRY_OPCODE, OPCODE_RCR},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    ////////////////////////////////////////////////////////////////////////////////////////////
-
-    {"MOV", {
-         {ENTRY_OPCODE, OPCODE_MOV},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"XCHG", {
-         {ENTRY_OPCODE, OPCODE_XCHG},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"PUSH", {
-         {ENTRY_OPCODE, OPCODE_PUSH},
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"POP", {
-         {ENTRY_OPCODE, OPCODE_POP},
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    {"PUSHALL", {
-         {ENTRY_OPCODE, OPCODE_PUSHALL},
-         {ENTRY_ARGUMENT_COUNT, 0},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"POPALL", {
-         {ENTRY_OPCODE, OPCODE_POPALL},
-         {ENTRY_ARGUMENT_COUNT, 0},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"ENTER", {
-                 {ENTRY_OPCODE, OPCODE_ENTER},
-                 {ENTRY_ARGUMENT_COUNT, 1},
-                 {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-             }
-    },
-
-    {"LEAVE", {
-         {ENTRY_OPCODE, OPCODE_LEAVE},
-         {ENTRY_ARGUMENT_COUNT, 0},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"MOVS", {
-                 {ENTRY_OPCODE, OPCODE_MOVS},
-                 {ENTRY_ARGUMENT_COUNT, 0},
-                 {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-             }
-    },
-
-    {"LEA", {
-                 {ENTRY_OPCODE, OPCODE_LEA},
-                 {ENTRY_ARGUMENT_COUNT, 2},
-                 {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-             }
-    },
-
-    ////////////////////////////////////////////////////////////////////////////////////////////
-
-    {"JMP", {
-         {ENTRY_OPCODE, OPCODE_JMP},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"CALL", {
-         {ENTRY_OPCODE, OPCODE_CALL},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"RET", {
-         {ENTRY_OPCODE, OPCODE_RET},
-         {ENTRY_ARGUMENT_COUNT, 0},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"JE", {
-         {ENTRY_OPCODE, OPCODE_JE},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"JNE", {
-         {ENTRY_OPCODE, OPCODE_JNE},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"JB", {
-         {ENTRY_OPCODE, OPCODE_JB},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"JL", {
-         {ENTRY_OPCODE, OPCODE_JL},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"JBE", {
-         {ENTRY_OPCODE, OPCODE_JBE},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"JLE", {
-         {ENTRY_OPCODE, OPCODE_JLE},
-         {ENTRY_ARGUMENT_COUNT, 2},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"INT", {
-         {ENTRY_OPCODE, OPCODE_INT},
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"INT3", {
-         {ENTRY_OPCODE, OPCODE_INT3},
-         {ENTRY_ARGUMENT_COUNT, 0},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"IRET", {
-         {ENTRY_OPCODE, OPCODE_IRET},
-         {ENTRY_ARGUMENT_COUNT, 0},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    {"JC", {
-               {ENTRY_OPCODE, OPCODE_JC},
-               {ENTRY_ARGUMENT_COUNT, 2},
-               {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-           }
-    },
-
-    {"JNC", {
-               {ENTRY_OPCODE, OPCODE_JNC},
-               {ENTRY_ARGUMENT_COUNT, 2},
-               {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-           }
-    },
-
-    {"JO", {
-               {ENTRY_OPCODE, OPCODE_JO},
-               {ENTRY_ARGUMENT_COUNT, 2},
-               {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-           }
-    },
-
-    {"JNO", {
-               {ENTRY_OPCODE, OPCODE_JNO},
-               {ENTRY_ARGUMENT_COUNT, 2},
-               {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-           }
-    },
-
-    {"IRET", {
-               {ENTRY_OPCODE, OPCODE_IRET},
-               {ENTRY_ARGUMENT_COUNT, 0},
-               {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-           }
-    },
-
-    {"LOOP", {
-               {ENTRY_OPCODE, OPCODE_LOOP},
-               {ENTRY_ARGUMENT_COUNT, 2},
-               {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-           }
-    },
-
-    ////////////////////////////////////////////////////////////////////////////////////////////
-
-    { "HLT", {
-         {ENTRY_OPCODE, OPCODE_HLT },
-         {ENTRY_ARGUMENT_COUNT, 0},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-     }
-    },
-
-    { "IGNI", {
-           {ENTRY_OPCODE, OPCODE_IGNI },
-           {ENTRY_ARGUMENT_COUNT, 0},
-           {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-      }
-    },
-
-    { "ALWI", {
-           {ENTRY_OPCODE, OPCODE_ALWI },
-           {ENTRY_ARGUMENT_COUNT, 0},
-           {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 0},
-      }
-    },
-
-    ////////////////////////////////////////////////////////////////////////////////////////////
-
-    { "IN", {
-           {ENTRY_OPCODE, OPCODE_IN },
-           {ENTRY_ARGUMENT_COUNT, 2},
-           {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-       }
-    },
-
-    { "OUT", {
-           {ENTRY_OPCODE, OPCODE_OUT },
-           {ENTRY_ARGUMENT_COUNT, 2},
-           {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-       }
-    },
-
-    { "INS", {
-         {ENTRY_OPCODE, OPCODE_INS },
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
-
-    { "OUTS", {
-         {ENTRY_OPCODE, OPCODE_OUTS },
-         {ENTRY_ARGUMENT_COUNT, 1},
-         {ENTRY_REQUIRE_OPERATION_WIDTH_SPECIFICATION, 1},
-     }
-    },
+#define OPCODE_LPT      (0x70)
+#define OPCODE_TLBFL    (0x71)
+#define OPCODE_INVLPG   (0x72)
+#define OPCODE_ENPG     (0x73)
+#define OPCODE_DSPG     (0x74)
+#define OPCODE_RDPFA    (0x75)
+
+// Single source of truth of the instruction set, expanded with an X-macro:
+// X(mnemonic, opcode, executor method, argument count, operation width)
+// operation width is 0 if the instruction has none, 1 if it is encoded but the executor does not depend on it,
+// and 2 if the executor is a template instantiated for each width (uint8_t, uint16_t, uint32_t and uint64_t)
+#define SYSDARFT_INSTRUCTION_SET(X) \
+    /* Misc */ \
+    X(NOP,     OPCODE_NOP,      nop,     0, 0) \
+    /* Arithmetic */ \
+    X(ADD,     OPCODE_ADD,      add,     2, 2) \
+    X(ADC,     OPCODE_ADC,      adc,     2, 2) \
+    X(SUB,     OPCODE_SUB,      sub,     2, 2) \
+    X(SBB,     OPCODE_SBB,      sbb,     2, 2) \
+    X(IMUL,    OPCODE_IMUL,     imul,    1, 2) \
+    X(MUL,     OPCODE_MUL,      mul,     1, 2) \
+    X(IDIV,    OPCODE_IDIV,     idiv,    1, 2) \
+    X(DIV,     OPCODE_DIV,      div,     1, 2) \
+    X(NEG,     OPCODE_NEG,      neg,     1, 1) \
+    X(CMP,     OPCODE_CMP,      cmp,     2, 1) \
+    X(INC,     OPCODE_INC,      inc,     1, 2) \
+    X(DEC,     OPCODE_DEC,      dec,     1, 2) \
+    /* Logic and Bitwise */ \
+    X(AND,     OPCODE_AND,      and_,    2, 1) \
+    X(OR,      OPCODE_OR,       or_,     2, 1) \
+    X(XOR,     OPCODE_XOR,      xor_,    2, 1) \
+    X(NOT,     OPCODE_NOT,      not_,    1, 1) \
+    X(SHL,     OPCODE_SHL,      shl,     2, 1) \
+    X(SHR,     OPCODE_SHR,      shr,     2, 1) \
+    X(ROL,     OPCODE_ROL,      rol,     2, 2) \
+    X(ROR,     OPCODE_ROR,      ror,     2, 2) \
+    X(RCL,     OPCODE_RCL,      rcl,     2, 2) \
+    X(RCR,     OPCODE_RCR,      rcr,     2, 2) \
+    /* Data Transfer */ \
+    X(MOV,     OPCODE_MOV,      mov,     2, 1) \
+    X(XCHG,    OPCODE_XCHG,     xchg,    2, 1) \
+    X(PUSH,    OPCODE_PUSH,     push,    1, 2) \
+    X(POP,     OPCODE_POP,      pop,     1, 2) \
+    X(PUSHALL, OPCODE_PUSHALL,  pushall, 0, 0) \
+    X(POPALL,  OPCODE_POPALL,   popall,  0, 0) \
+    X(ENTER,   OPCODE_ENTER,    enter,   1, 1) \
+    X(LEAVE,   OPCODE_LEAVE,    leave,   0, 0) \
+    X(MOVS,    OPCODE_MOVS,     movs,    0, 0) \
+    X(LEA,     OPCODE_LEA,      lea,     2, 0) \
+    X(STOS,    OPCODE_STOS,     stos,    1, 1) \
+    X(CMPS,    OPCODE_CMPS,     cmps,    0, 0) \
+    X(SCAS,    OPCODE_SCAS,     scas,    1, 1) \
+    /* Control Flow */ \
+    X(JMP,     OPCODE_JMP,      jmp,     2, 0) \
+    X(CALL,    OPCODE_CALL,     call,    2, 0) \
+    X(RET,     OPCODE_RET,      ret,     0, 0) \
+    X(JE,      OPCODE_JE,       je,      2, 0) \
+    X(JNE,     OPCODE_JNE,      jne,     2, 0) \
+    X(JB,      OPCODE_JB,       jb,      2, 0) \
+    X(JL,      OPCODE_JL,       jl,      2, 0) \
+    X(JBE,     OPCODE_JBE,      jbe,     2, 0) \
+    X(JLE,     OPCODE_JLE,      jle,     2, 0) \
+    X(INT,     OPCODE_INT,      int_,    1, 0) \
+    X(INT3,    OPCODE_INT3,     int3,    0, 0) \
+    X(IRET,    OPCODE_IRET,     iret,    0, 0) \
+    X(JC,      OPCODE_JC,       jc,      2, 0) \
+    X(JNC,     OPCODE_JNC,      jnc,     2, 0) \
+    X(JO,      OPCODE_JO,       jo,      2, 0) \
+    X(JNO,     OPCODE_JNO,      jno,     2, 0) \
+    X(LOOP,    OPCODE_LOOP,     loop,    2, 0) \
+    /* Misc */ \
+    X(HLT,     OPCODE_HLT,      hlt,     0, 0) \
+    X(IGNI,    OPCODE_IGNI,     igni,    0, 0) \
+    X(ALWI,    OPCODE_ALWI,     alwi,    0, 0) \
+    /* IO */ \
+    X(IN,      OPCODE_IN,       in,      2, 1) \
+    X(OUT,     OPCODE_OUT,      out,     2, 1) \
+    X(INS,     OPCODE_INS,      ins,     1, 1) \
+    X(OUTS,    OPCODE_OUTS,     outs,    1, 1) \
+    /* Paging */ \
+    X(LPT,     OPCODE_LPT,      lpt,     2, 0) \
+    X(TLBFL,   OPCODE_TLBFL,    tlbfl,   0, 0) \
+    X(INVLPG,  OPCODE_INVLPG,   invlpg,  1, 0) \
+    X(ENPG,    OPCODE_ENPG,     enpg,    0, 0) \
+    X(DSPG,    OPCODE_DSPG,     dspg,    0, 0) \
+    X(RDPFA,   OPCODE_RDPFA,    rdpfa,   1, 0)
+
+// Instruction pairs the decoded instruction cache fuses into one superinstruction, expanded with an X-macro:
+// X(first opcode, second opcode, executor method)
+// the executor method receives the operands of both instructions, those of the second one following the first
+#define SYSDARFT_FUSED_INSTRUCTION_SET(X) \
+    X(OPCODE_CMP,  OPCODE_JE,   cmp_je)  \
+    X(OPCODE_CMP,  OPCODE_JNE,  cmp_jne) \
+    X(OPCODE_CMP,  OPCODE_JB,   cmp_jb)  \
+    X(OPCODE_CMP,  OPCODE_JL,   cmp_jl)  \
+    X(OPCODE_CMP,  OPCODE_JBE,  cmp_jbe) \
+    X(OPCODE_CMP,  OPCODE_JLE,  cmp_jle)
+
+struct InstructionDescriptorType
+{
+    const char * mnemonic = nullptr; // nullptr if the opcode is not assigned
+    uint8_t argument_count = 0;
+    bool require_operation_width_specification = false;
+};
 
+// Opcode indexed instruction descriptor table
+constexpr std::array<InstructionDescriptorType, 256> instruction_table = []
+{
+    std::array<InstructionDescriptorType, 256> table { };
+
+#define SYSDARFT_INSTRUCTION_DESCRIPTOR(name, code, executor, argc, width) \
+    if (table[code].mnemonic != nullptr) { throw "Duplicated opcode for " #name; } \
+    table[code] = { #name, argc, width != 0 };
+    SYSDARFT_INSTRUCTION_SET(SYSDARFT_INSTRUCTION_DESCRIPTOR)
+#undef SYSDARFT_INSTRUCTION_DESCRIPTOR
+
+    return table;
+}();
+
+// Mnemonic to opcode mapping, used by the assembler
+inline const std::unordered_map<std::string, uint8_t> instruction_map = {
+#define SYSDARFT_INSTRUCTION_MNEMONIC(name, code, executor, argc, width) \
+    { #name, code },
+    SYSDARFT_INSTRUCTION_SET(SYSDARFT_INSTRUCTION_MNEMONIC)
+#undef SYSDARFT_INSTRUCTION_MNEMONIC
 };
 
 #endif //INSTRUCTION_DEFINITION_H
\ No newline at end of file
@@ -0,0 +1,130 @@
+/* SysdarftAsyncIO.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef SYSDARFTASYNCIO_H
+#define SYSDARFTASYNCIO_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/uio.h>
+#include <SysdarftDisks.h>
+
+#define ASYNC_IO_QUEUE_DEPTH    (64)    // requests in flight at once, submit() waits for room beyond that
+#define ASYNC_IO_THREADS        (4)     // most worker threads of the thread pool backend
+#define ASYNC_IO_REAP_TIMEOUT_MS (100)  // longest the io_uring reaper waits before it looks for a stop request
+
+enum class SysdarftAsyncIOBackend { IOUring, ThreadPool };
+
+/*
+ * Asynchronous sector I/O, a request is queued and submit() returns at once,
+ * its completion is called on a host thread once it is done, true if every sector was transferred.
+ * Runs on io_uring, or on a pool of worker threads doing read_sectors()/write_sectors()
+ * if io_uring was not asked for or the host does not provide it.
+ * A disk without a host file (its sectors are cached in process) is always done by worker threads,
+ * started the first time one is needed.
+ * Destroying it waits for every request submitted so far
+ */
+class SYSDARFT_EXPORT_SYMBOL SysdarftAsyncIO
+{
+public:
+    using CompletionType = std::function < void (bool) >;
+
+private:
+    struct RequestType {
+        SysdarftSectorAccess * disk;
+        bool write;
+        uint64_t start;
+        uint64_t count;
+        uint8_t * buffer;
+        CompletionType completion;
+        iovec vector;   // what io_uring transfers, has to stay put until the request completes
+    };
+
+    SysdarftAsyncIOBackend Backend = SysdarftAsyncIOBackend::ThreadPool;
+
+    // requests submitted and not completed yet
+    std::mutex InFlightMutex;
+    std::condition_variable InFlightChanged;
+    uint64_t InFlight = 0;
+
+    // io_uring, set up and accessed through system calls. Requests are submitted with SubmitMutex held,
+    // and reaped by Reaper, the only thread looking at the completion queue
+    struct IOUringType {
+        int fd = -1;
+        void * sq_ring = nullptr;
+        uint64_t sq_ring_size = 0;
+        void * cq_ring = nullptr;
+        uint64_t cq_ring_size = 0;
+        void * sqes = nullptr;
+        uint64_t sqes_size = 0;
+        unsigned * sq_head = nullptr;
+        unsigned * sq_tail = nullptr;
+        unsigned * sq_array = nullptr;
+        unsigned sq_mask = 0;
+        unsigned * cq_head = nullptr;
+        unsigned * cq_tail = nullptr;
+        unsigned cq_mask = 0;
+        void * cqes = nullptr;
+    } Ring;
+
+    std::mutex SubmitMutex;
+    std::thread Reaper;
+    std::atomic < bool > ReaperStopping = false;
+
+    bool setup_io_uring();
+    void teardown_io_uring();
+    // false when the kernel refused the entry, which is then taken back off the submission queue
+    bool queue_io_uring(uint8_t opcode, RequestType * request);
+    void reap_io_uring();
+
+    // thread pool, Workers is changed with QueueMutex held
+    std::mutex QueueMutex;
+    std::condition_variable QueueChanged;
+    std::deque < RequestType * > Queue;
+    bool Stopping = false;
+    std::vector < std::thread > Workers;
+
+    void start_workers();
+    void work();
+
+    // run the completion of a request done with transferred bytes, and drop it
+    void complete(RequestType * request, uint64_t transferred);
+
+public:
+    explicit SysdarftAsyncIO(SysdarftAsyncIOBackend preferred = SysdarftAsyncIOBackend::IOUring);
+    ~SysdarftAsyncIO();
+    SysdarftAsyncIO(const SysdarftAsyncIO &) = delete;
+    SysdarftAsyncIO & operator=(const SysdarftAsyncIO &) = delete;
+
+    [[nodiscard]] SysdarftAsyncIOBackend backend() const { return Backend; }
+    [[nodiscard]] static const char * backend_name(SysdarftAsyncIOBackend backend);
+
+    // transfer count sectors from start on between disk and buffer, which has to stay valid until completion
+    void submit(SysdarftSectorAccess & disk, bool write, uint64_t start, uint64_t count, uint8_t * buffer,
+        CompletionType completion);
+};
+
+#endif //SYSDARFTASYNCIO_H
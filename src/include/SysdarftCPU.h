@@ -27,6 +27,7 @@
 #include <SysdarftRegister.h>
 #include <SysdarftInstructionExec.h>
 #include <WorkerThread.h>
+#include <SysdarftDiskCache.h>
 
 class MultipleCPUInstanceCreation final : public SysdarftBaseError
 {
@@ -41,11 +42,12 @@ private:
     std::atomic_bool have_I_invoked_shutdown {false};
 
 public:
-    explicit SysdarftCPU(uint64_t memory, const std::string & font_name,
+    explicit SysdarftCPU(const SysdarftMemoryOptions & memory, const std::string & font_name,
         const std::vector < uint8_t > & bios,
         const std::string & hdd,
         const std::string & fda,
-        const std::string & fdb);
+        const std::string & fdb,
+        SysdarftDiskCachePolicy disk_cache);
     ~SysdarftCPU() override { SysdarftCursesUI::cleanup(); }
 
     [[nodiscard]] uint64_t Boot(bool headless = false, bool with_gui = false);
@@ -55,9 +57,12 @@ public:
 
     template <typename DeviceType, typename... Args,
               typename = std::enable_if_t<std::is_base_of_v<SysdarftExternalDeviceBaseClass, DeviceType>>>
-    void add_device(Args &...args)
+    DeviceType & add_device(Args &...args)
     {
-        device_list.emplace_back(std::make_unique<DeviceType>(args...));
+        auto device = std::make_unique<DeviceType>(args...);
+        auto & added = *device;
+        register_device(std::move(device));
+        return added;
     }
 
     explicit operator bool() const
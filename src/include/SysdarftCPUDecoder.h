@@ -21,10 +21,15 @@
 #ifndef SYSDARFTCPUINSTRUCTIONDECODER_H
 #define SYSDARFTCPUINSTRUCTIONDECODER_H
 
+#include <array>
+#include <stdexcept>
+#include <type_traits>
 #include <EncodingDecoding.h>
+#include <InstructionSet.h>
 #include <SysdarftCursesUI.h>
 #include <SysdarftDebug.h>
 #include <SysdarftMemory.h>
+#include <SysdarftPaging.h>
 #include <SysdarftRegister.h>
 
 #define INT_FATAL                   (0x00)
@@ -37,6 +42,7 @@
 #define INT_STACKOVERFLOW           (0x07)
 #define INT_ILLEGAL_MEMORY_ACCESS   (0x08)
 #define INT_SYSTEM_SHUTDOWN         (0x09)
+#define INT_PAGE_FAULT              (0x0A)
 
 #define INT_TELETYPE    (0x10)
 #define INT_SET_CUR_POS (0x11)
@@ -74,20 +80,52 @@ public:
 
 class OperandType;
 
-class DecoderDataAccess
-    : public SysdarftRegister,
-      public SysdarftCursesUI
+class DecoderDataAccess : public SysdarftCPUPaging
 {
 protected:
-    explicit DecoderDataAccess(const uint64_t memory, const std::string & font_name) : SysdarftCursesUI(memory, font_name) { }
+    explicit DecoderDataAccess(const SysdarftMemoryOptions & memory, const std::string & font_name) : SysdarftCPUPaging(memory, font_name) { }
+
+    // Guest fault raised by the instruction being decoded or executed.
+    // Only the first one is kept, the executor delivers it once the instruction returns
+    SysdarftFaultType PendingFault = SysdarftFaultType::None;
+
+    void raise_fault(const SysdarftFaultType fault)
+    {
+        if (PendingFault == SysdarftFaultType::None) {
+            PendingFault = fault;
+        }
+    }
+
+    [[nodiscard]] bool fault_pending() const { return PendingFault != SysdarftFaultType::None; }
+
+    // Linear address code is not fetched from or beyond while looking ahead for fusion.
+    // Fetching there would walk the page table for the next page before the guest ever reaches it
+    uint64_t FetchLimit = UINT64_MAX;
 
     template < typename DataType >
     DataType pop_code_and_inc_ip()
     {
         DataType result { };
+
+        // decoding stops at the first fault, IP is left where the fault happened
+        if (fault_pending()) {
+            return result;
+        }
+
         const auto CB = SysdarftRegister::load<CodeBaseType>();
         auto IP = SysdarftRegister::load<InstructionPointerType>();
-        result = pop_memory_from<DataType>(CB, IP);
+        if (CB + IP + sizeof(DataType) > FetchLimit) {
+            raise_fault(SysdarftFaultType::PageFault);
+            return result;
+        }
+
+        if (const auto fault = try_pop_linear_from<DataType>(CB, IP, result, GuestAccessType::Fetch);
+            fault != SysdarftFaultType::None)
+        {
+            raise_fault(fault);
+            return result;
+        }
+
         SysdarftRegister::store<InstructionPointerType>(IP);
         return result;
     }
@@ -115,11 +153,29 @@ public:
 // short-lived type, valid only for current timestamp
 class SYSDARFT_EXPORT_SYMBOL OperandType
 {
+public:
+    // Raw operand encoding as it appears in the code stream.
+    // It does not depend on register values, so it can be cached and resolved again later
+    struct OperandParameterEncodingType {
+        uint8_t Prefix;         // REGISTER_PREFIX, CONSTANT_PREFIX or MEMORY_PREFIX
+        uint8_t WidthBCD;       // register width, constant width, or memory access width
+        uint8_t RegisterIndex;
+        uint64_t ConstantValue;
+    };
+
+    struct OperandEncodingType {
+        OperandParameterEncodingType Operand;
+        OperandParameterEncodingType MemoryParameters[3]; // *Ratio&Width(Base, Offset 1, Offset 2)
+        uint8_t MemoryRatioBCD;
+    };
+
 protected:
-    DecoderDataAccess & Access;
+    DecoderDataAccess * Access = nullptr;
 
     enum OperandType_t { NaO, RegisterOperand, ConstantOperand, MemoryOperand };
 
+    OperandEncodingType Encoding { };
+
     struct
     {
         OperandType_t OperandType;
@@ -137,19 +193,27 @@ protected:
                 uint8_t MemoryWidthBCD;
             } CalculatedMemoryAddress;
         } OperandInfo { };
-
-        std::string literal; // literal will be wrong for all FPU and signed instructions
-                             // since it decodes to unsigned only.
-                             // These instructions have to output correct literals manually
     } OperandReferenceTable { };
 
+    [[nodiscard]] uint64_t do_access_register(uint8_t RegisterWidthBCD, uint8_t RegisterIndex) const;
     [[nodiscard]] uint64_t do_access_register_based_on_table() const;
 
     template < typename DataType >
     [[nodiscard]] DataType do_width_ambiguous_access_memory_based_on_table() const
     {
-        auto DP = OperandReferenceTable.OperandInfo.CalculatedMemoryAddress.MemoryAddress;
-        return Access.pop_memory_from<DataType>(0, DP);
+        DataType result { };
+        if (Access->fault_pending()) {
+            return result;
+        }
+
+        const auto DP = OperandReferenceTable.OperandInfo.CalculatedMemoryAddress.MemoryAddress;
+        if (const auto fault = Access->try_load_linear<DataType>(DP, result);
+            fault != SysdarftFaultType::None)
+        {
+            Access->raise_fault(fault);
+        }
+
+        return result;
     }
 
     [[nodiscard]] uint64_t do_access_width_specified_access_memory_based_on_table() const
@@ -159,18 +223,25 @@ protected:
         case _16bit_prefix: return do_width_ambiguous_access_memory_based_on_table<uint16_t>();
         case _32bit_prefix: return do_width_ambiguous_access_memory_based_on_table<uint32_t>();
         case _64bit_prefix: return do_width_ambiguous_access_memory_based_on_table<uint64_t>();
-        default: throw IllegalInstruction("Unknown memory access width");
+        default: Access->raise_fault(SysdarftFaultType::IllegalInstruction); return 0;
         }
     }
 
     void store_value_to_register_based_on_table(uint64_t value);
     void store_value_to_memory_based_on_table(uint64_t value);
 
-    void do_decode_register_without_prefix();
-    void do_decode_constant_without_prefix();
+    // decode the code stream into Encoding
+    void do_decode_register_without_prefix(OperandParameterEncodingType & Parameter);
+    void do_decode_constant_without_prefix(OperandParameterEncodingType & Parameter);
     void do_decode_memory_without_prefix();
     void do_decode_operand();
 
+    // resolve Encoding against the current register values into OperandReferenceTable
+    void do_resolve_register(const OperandParameterEncodingType & Parameter);
+    void do_resolve_constant(const OperandParameterEncodingType & Parameter);
+    void do_resolve_memory();
+    void do_resolve_operand();
+
     [[nodiscard]] uint64_t do_access_operand_based_on_table() const;
     void store_value_to_operand_based_on_table(uint64_t value);
 
@@ -178,8 +249,79 @@ public:
     [[nodiscard]] uint64_t get_val() const { return do_access_operand_based_on_table(); }
     [[nodiscard]] uint64_t get_effective_addr() const { return OperandReferenceTable.OperandInfo.CalculatedMemoryAddress.MemoryAddress; }
     void set_val(const uint64_t val) { store_value_to_operand_based_on_table(val); }
-    [[nodiscard]] std::string get_literal() const { return OperandReferenceTable.literal; }
-    explicit OperandType(DecoderDataAccess & Access_) : Access(Access_) { do_decode_operand(); }
+    // literal is built on demand from the encoding, and will be wrong for all FPU and signed instructions
+    // since it decodes to unsigned only. These instructions have to output correct literals manually
+    [[nodiscard]] std::string get_literal() const;
+    [[nodiscard]] const OperandEncodingType & get_encoding() const { return Encoding; }
+
+    // empty slot, see OperandListType
+    OperandType() = default;
+
+    // decode from the code stream, a malformed operand raises a fault on Access_ instead of throwing
+    explicit OperandType(DecoderDataAccess & Access_) : Access(&Access_)
+    {
+        do_decode_operand();
+        if (!Access->fault_pending()) {
+            do_resolve_operand();
+        }
+    }
+
+    // rebuild from an encoding decoded earlier
+    OperandType(DecoderDataAccess & Access_, const OperandEncodingType & Encoding_)
+        : Access(&Access_), Encoding(Encoding_) { do_resolve_operand(); }
+};
+
+// Operands of one instruction, stored inline. The ISA never encodes more than two,
+// a fused instruction (see SYSDARFT_FUSED_INSTRUCTION_SET) carries those of both of its instructions
+class OperandListType
+{
+public:
+    static constexpr uint8_t Capacity = 4;
+
+private:
+    std::array < OperandType, Capacity > Operands { };
+    uint8_t Count = 0;
+
+public:
+    template < typename... Args >
+    OperandType & emplace_back(Args &&... args)
+    {
+        if (Count == Capacity) {
+            throw IllegalInstruction("Too many operands");
+        }
+
+        Operands[Count] = OperandType(std::forward<Args>(args)...);
+        return Operands[Count++];
+    }
+
+    OperandType & at(const size_t index)
+    {
+        if (index >= Count) {
+            throw std::out_of_range("Operand index out of range");
+        }
+
+        return Operands[index];
+    }
+
+    [[nodiscard]] const OperandType & at(const size_t index) const
+    {
+        if (index >= Count) {
+            throw std::out_of_range("Operand index out of range");
+        }
+
+        return Operands[index];
+    }
+
+    OperandType & operator[](const size_t index) { return Operands[index]; }
+    const OperandType & operator[](const size_t index) const { return Operands[index]; }
+    OperandType & back() { return Operands[Count - 1]; }
+    [[nodiscard]] size_t size() const { return Count; }
+    [[nodiscard]] bool empty() const { return Count == 0; }
+    void clear() { Count = 0; }
+    OperandType * begin() { return Operands.data(); }
+    OperandType * end() { return Operands.data() + Count; }
+    [[nodiscard]] const OperandType * begin() const { return Operands.data(); }
+    [[nodiscard]] const OperandType * end() const { return Operands.data() + Count; }
 };
 
 class SYSDARFT_EXPORT_SYMBOL SysdarftCPUInterruption : public DecoderDataAccess
@@ -211,7 +353,7 @@ protected:
      *  [0x07] STACK OVERFLOW
      *  [0x08] MEMORY ACCESS OUT OF BOUNDARY
      *  [0x09] SYSTEM SHUTDOWN (Can only trigger once until IM is 0)
-     *  [0x0A]
+     *  [0x0A] PAGE FAULT (linear address can be read by RDPFA)
      *  [0x0B]
      *  [0x0C]
      *  [0x0D]
@@ -261,38 +403,160 @@ protected:
     void do_interruption(uint64_t code);
     void do_iret();
 
-    explicit SysdarftCPUInterruption(uint64_t memory, const std::string & font_name);
+    explicit SysdarftCPUInterruption(const SysdarftMemoryOptions & memory, const std::string & font_name);
 private:
 
+    // interruption routines run in kernel mode, IRET goes back to the preserved level
+    static void enter_interruption_privilege_level(decltype(sysdarft_register_t::FlagRegister) & fg)
+    {
+        if (fg.ProtectedModeEnabled && fg.CurrentPrivilegeLevel == USER_PRIVILEGE_LEVEL) {
+            fg.CurrentPrivilegeLevel = KERNEL_PRIVILEGE_LEVEL;
+        }
+    }
+
     void set_mask()
     {
         auto fg = SysdarftRegister::load<FlagRegisterType>();
         fg.InterruptionMask = 1;
+        enter_interruption_privilege_level(fg);
         SysdarftRegister::store<FlagRegisterType>(fg);
     }
 
 public:
-    void do_ext_dev_interruption(uint64_t code);
+    // queue an interruption for an external device. A request made while the CPU is busy delivering others
+    // is dropped, unless wait is set, for one time events (like a completion) that must not be lost
+    void do_ext_dev_interruption(uint64_t code, bool wait = false);
     void debugger_pause_0x14() { debugger_pause_blocked_int_0x14 = true;}
 };
 
 class SYSDARFT_EXPORT_SYMBOL SysdarftCPUInstructionDecoder : public SysdarftCPUInterruption
 {
 protected:
+    /*
+     * Executors are selected by handler index, made of the opcode and the operation width.
+     * Width specialized executors (see SYSDARFT_INSTRUCTION_SET) have one handler per width,
+     * every other executor fills all the slots of its opcode.
+     * Fused instructions (see SYSDARFT_FUSED_INSTRUCTION_SET) have one handler each, after all the opcodes
+     */
+    struct FusedInstructionDescriptorType
+    {
+        uint8_t first;
+        uint8_t second;
+    };
+
+    // Fused instruction table, the index is the position in SYSDARFT_FUSED_INSTRUCTION_SET
+    static constexpr std::array fused_instruction_table = {
+#define SYSDARFT_FUSED_INSTRUCTION_DESCRIPTOR(first, second, executor) \
+        FusedInstructionDescriptorType { first, second },
+        SYSDARFT_FUSED_INSTRUCTION_SET(SYSDARFT_FUSED_INSTRUCTION_DESCRIPTOR)
+#undef SYSDARFT_FUSED_INSTRUCTION_DESCRIPTOR
+    };
+
+    static constexpr uint16_t OPERATION_WIDTH_SLOTS = 4;
+    static constexpr uint16_t FUSED_HANDLER_BASE = 256 * OPERATION_WIDTH_SLOTS;
+    static constexpr uint16_t INSTRUCTION_HANDLER_COUNT = FUSED_HANDLER_BASE + fused_instruction_table.size();
+
+    static constexpr uint16_t handler_index(const uint8_t opcode, const uint8_t BCDWidth)
+    {
+        switch (BCDWidth) {
+        case _16bit_prefix: return opcode * OPERATION_WIDTH_SLOTS + 1;
+        case _32bit_prefix: return opcode * OPERATION_WIDTH_SLOTS + 2;
+        case _64bit_prefix: return opcode * OPERATION_WIDTH_SLOTS + 3;
+        default:            return opcode * OPERATION_WIDTH_SLOTS;
+        }
+    }
+
+    static constexpr uint16_t fused_handler_index(const uint16_t fused) { return FUSED_HANDLER_BASE + fused; }
+
+    // opcode of the first instruction for fused handlers
+    static constexpr uint8_t handler_opcode(const uint16_t handler)
+    {
+        if (handler >= FUSED_HANDLER_BASE) {
+            return fused_instruction_table[handler - FUSED_HANDLER_BASE].first;
+        }
+
+        return handler / OPERATION_WIDTH_SLOTS;
+    }
+
+    // plain data, decoding an instruction does not touch the heap
     struct ActiveInstructionType {
         uint8_t opcode;
         uint8_t width;
-        std::vector< OperandType > operands;
-        std::string literal; // again, literals for FPU and signed operations are all wrong
-                             // it will remain this way to reduce the complicity
-                             // manually output these instruction literals
-                             // instead of relying on automatic literalization
+        OperandListType operands;
+        uint16_t handler; // selected once here, so executors never switch on the width
+    };
+
+    static_assert(std::is_trivially_copyable_v<ActiveInstructionType>);
+
+    // fuse == false always returns one single instruction, for anything that has to see each of them
+    ActiveInstructionType pop_instruction_from_ip_and_increase_ip(bool fuse);
+
+    // Length of the jump in the fused pair popped last. IP is already past it,
+    // a fused handler faulting before the jump part moves IP back by this much
+    uint64_t FusedJumpLength = 0;
+
+    // drop decoded instructions living in blocks written since the last call,
+    // then pass those blocks to decoded_blocks_invalidated() so nothing else caching code can miss them
+    void drop_invalidated_decoded_instructions();
+    virtual void decoded_blocks_invalidated(const std::vector < uint64_t > &) { }
+
+    // instructions decoded with paging disabled may cross into the physically next page
+    void translation_changed() override { DecodedInstructionCache.clear(); }
+
+    explicit SysdarftCPUInstructionDecoder(const SysdarftMemoryOptions & memory, const std::string & font_name)
+        : SysdarftCPUInterruption(memory, font_name) { }
+
+private:
+    /*
+     * Decoded instruction cache, keyed by the physical address of CB + IP.
+     * Entries are grouped by the memory block they start in, so that a write
+     * to a block (see SysdarftCPUMemoryAccess::write_memory) drops exactly the
+     * instructions that were decoded from it. An instruction never exceeds one
+     * block in length, so it can only spill into the block right after its own.
+     * A fused pair is far shorter than a block as well.
+     * With paging enabled the next page is not necessarily the next block,
+     * so instructions crossing a page boundary are not cached at all,
+     * and everything decoded before translation changed is dropped.
+     */
+    struct DecodedInstructionCacheEntryType {
+        uint8_t opcode;
+        uint8_t width;
+        uint16_t handler;
+        uint8_t operand_count;
+        std::array < OperandType::OperandEncodingType, OperandListType::Capacity > operands;
+        uint64_t length;
+
+        // set if this instruction fuses with the one right after it, whose operands follow its own
+        uint16_t fused_handler; // 0 if it does not
+        uint8_t fused_operand_count;
+        uint64_t fused_length; // both instructions, same as length if not fused
     };
 
-    ActiveInstructionType pop_instruction_from_ip_and_increase_ip();
+    std::unordered_map < uint64_t /* block */,
+        std::unordered_map < uint64_t /* physical address */, DecodedInstructionCacheEntryType > > DecodedInstructionCache;
+
+    ActiveInstructionType decode_instruction_from_ip(DecodedInstructionCacheEntryType * entry);
+    ActiveInstructionType rebuild_instruction_from_cache(const DecodedInstructionCacheEntryType & entry, bool fused);
+
+    // look at the instruction following entry, and record the pair in entry if it fuses. IP is left alone
+    void fuse_next_instruction(DecodedInstructionCacheEntryType & entry);
+
+protected:
+    // decode from CB:IP and advance IP, bypassing the decoded instruction cache
+    ActiveInstructionType decode_instruction_uncached() { return decode_instruction_from_ip(nullptr); }
+
+public:
+    // mnemonic, width and operand literals, built on demand for the debugger and verbose logging
+    // literals for FPU and signed operations are all wrong, see OperandType::get_literal()
+    static std::string get_instruction_literal(uint8_t opcode, uint8_t width, const OperandListType & operands);
+
+    std::atomic < bool > DecodedInstructionCacheEnabled = true;
+    std::atomic < uint64_t > DecodedInstructionCacheHits = 0;
+    std::atomic < uint64_t > DecodedInstructionCacheMisses = 0;
 
-    explicit SysdarftCPUInstructionDecoder(const uint64_t total_memory, const std::string & font_name)
-        : SysdarftCPUInterruption(total_memory, font_name) { }
+    // fused pairs come from the decoded instruction cache, disabling the cache disables fusion as well
+    std::atomic < bool > MacroOpFusionEnabled = true;
+    std::atomic < uint64_t > FusedInstructions = 0;
 };
 
 #endif //SYSDARFTCPUINSTRUCTIONDECODER_H
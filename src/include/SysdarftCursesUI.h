@@ -43,7 +43,7 @@ static constexpr int V_HEIGHT = 25;
 class SYSDARFT_EXPORT_SYMBOL SysdarftCursesUI : public SysdarftCPUMemoryAccess
 {
 public:
-    explicit SysdarftCursesUI(uint64_t memory, const std::string & font_name);
+    explicit SysdarftCursesUI(const SysdarftMemoryOptions & memory, const std::string & font_name);
     ~SysdarftCursesUI() override;
 
 protected:
@@ -99,7 +99,6 @@ private:
     WorkerThread ConsoleInputThread;
 
     char& video_at(const int x, const int y) {
-        std::lock_guard<std::mutex> lock(SysdarftCPUMemoryAccess::MemoryAccessMutex);
         return video_memory[y * V_WIDTH + x];
     }
 
@@ -0,0 +1,91 @@
+/* SysdarftDMA.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef SYSDARFTDMA_H
+#define SYSDARFTDMA_H
+
+#include <array>
+#include <memory>
+#include <SysdarftAsyncIO.h>
+#include <SysdarftDisks.h>
+#include <SysdarftCPU.h>
+
+/*
+ * DMA controller, moves whole runs of sectors between a disk and guest RAM in one command,
+ * reading and writing guest RAM in place instead of going through the data streams of the disk.
+ * The guest sets up the registers with OUT, then starts the transfer by writing anything to a command port.
+ * A transfer that cannot be started (busy, no such disk, sectors or memory out of range) fails the command
+ * with a device I/O error.
+ * In synchronous mode the command returns once the transfer is done, and a host I/O error fails it as well.
+ * In asynchronous mode it returns as soon as the transfer is queued, the guest keeps running while the host
+ * does it (see SysdarftAsyncIO), and finds out how it went in the status register.
+ * Either way the completion interruption is raised once the transfer is over
+ */
+#define DMA_REG_DEVICE      (0x140) /* DMA_DEVICE_* */
+#define DMA_REG_START_SEC   (0x141)
+#define DMA_REG_SEC_COUNT   (0x142)
+#define DMA_REG_ADDRESS     (0x143) /* guest physical address */
+#define DMA_REG_INTERRUPT   (0x144) /* completion interruption number, <= 0x1F means no interruption */
+#define DMA_CMD_READ        (0x145) /* disk to memory */
+#define DMA_CMD_WRITE       (0x146) /* memory to disk */
+#define DMA_REG_MODE        (0x147) /* DMA_MODE_* */
+#define DMA_REG_STATUS      (0x148) /* DMA_STATUS_* of the last transfer, read only */
+
+#define DMA_MODE_SYNC       (0x00)
+#define DMA_MODE_ASYNC      (0x01)
+
+#define DMA_STATUS_DONE     (0x00)
+#define DMA_STATUS_BUSY     (0x01)
+#define DMA_STATUS_FAILED   (0x02)
+
+#define DMA_DEVICE_HDD      (0x00)
+#define DMA_DEVICE_FDA      (0x01)
+#define DMA_DEVICE_FDB      (0x02)
+#define DMA_DEVICE_COUNT    (0x03)
+
+using DMADeviceListType = std::array < SysdarftSectorAccess *, DMA_DEVICE_COUNT >;
+
+class SysdarftDMAController final : public SysdarftExternalDeviceBaseClass
+{
+private:
+    SysdarftCPU & m_cpu;
+    const DMADeviceListType m_devices; // nullptr for a disk that is not there
+    uint64_t device = 0;
+    uint64_t start_sector = 0;
+    uint64_t sector_count = 0;
+    uint64_t address = 0;
+    uint64_t interruption_number = 0;
+    uint64_t mode = DMA_MODE_SYNC;
+    std::atomic < uint64_t > status = DMA_STATUS_DONE; // set by the host thread completing an asynchronous transfer
+
+    // set up on the first asynchronous transfer. Declared last so it is destroyed first,
+    // waiting for a transfer in flight while everything its completion uses is still there
+    std::unique_ptr < SysdarftAsyncIO > async_io;
+
+    bool transfer(bool to_memory);
+    void complete(bool to_memory, uint64_t memory_address, uint64_t length, uint64_t interruption, bool done);
+
+public:
+    explicit SysdarftDMAController(SysdarftCPU & _instance, const DMADeviceListType & devices);
+    bool request_read(uint64_t port) override;
+    bool request_write(uint64_t port) override;
+};
+
+#endif //SYSDARFTDMA_H
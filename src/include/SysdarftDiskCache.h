@@ -0,0 +1,88 @@
+/* SysdarftDiskCache.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef SYSDARFTDISKCACHE_H
+#define SYSDARFTDISKCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <WorkerThread.h>
+
+/*
+ * Disk cache policy, the same for every disk.
+ *  WriteThrough    No cache, every write is on the disk once it returns (O_DSYNC)
+ *  WriteBack       Writes are kept in the cache, and written back and synced every
+ *                  DISK_CACHE_FLUSH_INTERVAL seconds, on a FLUSH command, and when the system stops
+ *  Unsafe          Like WriteBack, but written back only when the cache is full or the system stops,
+ *                  never synced, and FLUSH commands are ignored
+ */
+enum class SysdarftDiskCachePolicy { WriteThrough, WriteBack, Unsafe };
+
+#define DISK_CACHE_BLOCK_SIZE       (64 * 1024) // the cache loads and writes back whole blocks
+#define DISK_CACHE_BLOCKS           (1024)      // 64MB of cache per disk
+#define DISK_CACHE_FLUSH_INTERVAL   (5)         // seconds
+
+// in process cache of a disk image, by byte offset. Blocks are dropped least recently used first,
+// a dirty block is written back before it goes. Safe to use from any thread
+class SYSDARFT_EXPORT_SYMBOL SysdarftDiskCache
+{
+private:
+    struct BlockType {
+        std::unique_ptr < uint8_t[] > data;
+        uint64_t length;    // the last block of a disk can be shorter
+        bool dirty;
+        std::list < uint64_t >::iterator lru;
+    };
+
+    const int fd;
+    const uint64_t device_size;
+    const SysdarftDiskCachePolicy policy;
+
+    std::mutex CacheMutex;
+    std::unordered_map < uint64_t /* block */, BlockType > Blocks;
+    std::list < uint64_t > LRU; // most recently used first
+    WorkerThread flush_worker;
+
+    // block loaded from disk unless it is about to be overwritten as a whole, nullptr on a host I/O error.
+    // CacheMutex is held by the caller of this and the two below
+    BlockType * lookup(uint64_t block, bool overwritten);
+    bool write_back(uint64_t block, BlockType & entry) const;
+    bool write_back_all();
+
+    void flush_periodically(std::atomic < bool > & running);
+
+public:
+    explicit SysdarftDiskCache(int _fd, uint64_t _device_size, SysdarftDiskCachePolicy _policy);
+    ~SysdarftDiskCache();
+    SysdarftDiskCache(const SysdarftDiskCache &) = delete;
+    SysdarftDiskCache & operator=(const SysdarftDiskCache &) = delete;
+
+    // false on a host I/O error, the caller checks the range
+    bool read(uint64_t offset, uint64_t length, uint8_t * dest);
+    bool write(uint64_t offset, uint64_t length, const uint8_t * source);
+
+    // write back everything and sync the image, a FLUSH command. Ignored if the policy is Unsafe
+    bool flush();
+};
+
+#endif //SYSDARFTDISKCACHE_H
@@ -22,24 +22,34 @@
 #define SYSDARFTHARDDISK_H
 
 #include <SysdarftIOHub.h>
+#include <SysdarftDiskCache.h>
 
 #define FDA_REG_SIZE        (0x116)
 #define FDA_REG_START_SEC   (0x117)
 #define FDA_REG_SEC_COUNT   (0x118)
 #define FDA_CMD_REQUEST_RD  (0x119)
 #define FDA_CMD_REQUEST_WR  (0x11A)
+#define FDA_CMD_FLUSH       (0x11B)
 
 #define FDB_REG_SIZE        (0x126)
 #define FDB_REG_START_SEC   (0x127)
 #define FDB_REG_SEC_COUNT   (0x128)
 #define FDB_CMD_REQUEST_RD  (0x129)
 #define FDB_CMD_REQUEST_WR  (0x12A)
+#define FDB_CMD_FLUSH       (0x12B)
 
 #define HDD_REG_SIZE        (0x136)
 #define HDD_REG_START_SEC   (0x137)
 #define HDD_REG_SEC_COUNT   (0x138)
 #define HDD_CMD_REQUEST_RD  (0x139)
 #define HDD_CMD_REQUEST_WR  (0x13A)
+#define HDD_CMD_FLUSH       (0x13B)
+
+#define DISK_SECTOR_SIZE    (512)
+
+// largest read or write one request can transfer, the size of the data streams of CMD_REQUEST_RD/WR.
+// Streams are committed by the host as they are used, so this costs nothing up front
+#define DISK_MAX_TRANSFER_SIZE (64 * 1024 * 1024)
 
 class SysdarftDiskError final : public SysdarftDeviceIOError {
 public:
@@ -48,24 +58,59 @@ public:
 
 int lock_file(int fd, int cmd, int type);
 
+// the lock above keeps other processes away, but not this one. A file, by whatever path it is reached,
+// can be attached as one disk only, false if it is attached already
+bool attach_file(int fd);
+void detach_file(int fd);
+
+// sector level access to a disk, what the DMA controller transfers through.
+// A request past the end of the disk, or one that could not be done in full, returns false
+class SysdarftSectorAccess
+{
+public:
+    virtual ~SysdarftSectorAccess() = default;
+    [[nodiscard]] virtual uint64_t sectors() const = 0;
+    virtual bool read_sectors(uint64_t start, uint64_t count, uint8_t * dest) = 0;
+    virtual bool write_sectors(uint64_t start, uint64_t count, const uint8_t * source) = 0;
+
+    // host file holding sector n at byte n * DISK_SECTOR_SIZE, for I/O done without the two above.
+    // -1 if sectors are cached in process, they can only be reached through the two above then
+    [[nodiscard]] virtual int host_file() const = 0;
+};
+
 template <  unsigned REG_SIZE,
             unsigned REG_START_SEC,
             unsigned REG_SEC_COUNT,
             unsigned CMD_REQUEST_RD,
-            unsigned CMD_REQUEST_WR >
-class SYSDARFT_EXPORT_SYMBOL SysdarftDiskImager : public SysdarftExternalDeviceBaseClass
+            unsigned CMD_REQUEST_WR,
+            unsigned CMD_FLUSH >
+class SYSDARFT_EXPORT_SYMBOL SysdarftDiskImager
+    : public SysdarftExternalDeviceBaseClass,
+      public SysdarftSectorAccess
 {
 private:
     int _sysdarftHardDiskFile;
     uint64_t start_sector = 0;
     uint64_t sector_count = 0;
     const uint64_t device_size = 0;
+    std::unique_ptr < SysdarftDiskCache > cache; // nullptr if written through
+
+    [[nodiscard]] bool in_range(uint64_t start, uint64_t count) const;
+
+    // by byte offset, through the cache if there is one
+    bool host_read(uint64_t offset, uint64_t length, uint8_t * dest);
+    bool host_write(uint64_t offset, uint64_t length, const uint8_t * source);
 
 public:
-    explicit SysdarftDiskImager(const std::string & file_name);
+    explicit SysdarftDiskImager(const std::string & file_name, SysdarftDiskCachePolicy cache_policy);
     ~SysdarftDiskImager() noexcept override;
     bool request_read(uint64_t) override;
     bool request_write(uint64_t) override;
+
+    [[nodiscard]] uint64_t sectors() const override { return device_size / DISK_SECTOR_SIZE; }
+    bool read_sectors(uint64_t start, uint64_t count, uint8_t * dest) override;
+    bool write_sectors(uint64_t start, uint64_t count, const uint8_t * source) override;
+    [[nodiscard]] int host_file() const override { return cache ? -1 : _sysdarftHardDiskFile; }
 };
 
 class SYSDARFT_EXPORT_SYMBOL SysdarftBlockDevices final : public SysdarftDiskImager
@@ -73,10 +118,12 @@ class SYSDARFT_EXPORT_SYMBOL SysdarftBlockDevices final : public SysdarftDiskIma
         HDD_REG_START_SEC,
         HDD_REG_SEC_COUNT,
         HDD_CMD_REQUEST_RD,
-        HDD_CMD_REQUEST_WR >
+        HDD_CMD_REQUEST_WR,
+        HDD_CMD_FLUSH >
 {
 public:
-    explicit SysdarftBlockDevices(const std::string & file_name) : SysdarftDiskImager(file_name) { }
+    explicit SysdarftBlockDevices(const std::string & file_name, const SysdarftDiskCachePolicy cache_policy)
+        : SysdarftDiskImager(file_name, cache_policy) { }
 };
 
 class SYSDARFT_EXPORT_SYMBOL SysdarftFloppyDiskA final : public SysdarftDiskImager
@@ -84,10 +131,12 @@ class SYSDARFT_EXPORT_SYMBOL SysdarftFloppyDiskA final : public SysdarftDiskImag
         FDA_REG_START_SEC,
         FDA_REG_SEC_COUNT,
         FDA_CMD_REQUEST_RD,
-        FDA_CMD_REQUEST_WR >
+        FDA_CMD_REQUEST_WR,
+        FDA_CMD_FLUSH >
 {
 public:
-    explicit SysdarftFloppyDiskA(const std::string & file_name) : SysdarftDiskImager(file_name) { }
+    explicit SysdarftFloppyDiskA(const std::string & file_name, const SysdarftDiskCachePolicy cache_policy)
+        : SysdarftDiskImager(file_name, cache_policy) { }
 };
 
 class SYSDARFT_EXPORT_SYMBOL SysdarftFloppyDiskB final : public SysdarftDiskImager
@@ -95,10 +144,12 @@ class SYSDARFT_EXPORT_SYMBOL SysdarftFloppyDiskB final : public SysdarftDiskImag
         FDB_REG_START_SEC,
         FDB_REG_SEC_COUNT,
         FDB_CMD_REQUEST_RD,
-        FDB_CMD_REQUEST_WR >
+        FDB_CMD_REQUEST_WR,
+        FDB_CMD_FLUSH >
 {
 public:
-    explicit SysdarftFloppyDiskB(const std::string & file_name) : SysdarftDiskImager(file_name) { }
+    explicit SysdarftFloppyDiskB(const std::string & file_name, const SysdarftDiskCachePolicy cache_policy)
+        : SysdarftDiskImager(file_name, cache_policy) { }
 };
 
 ssize_t SYSDARFT_EXPORT_SYMBOL getFileSize(int);
@@ -30,11 +30,14 @@ template <  unsigned REG_SIZE,
             unsigned REG_START_SEC,
             unsigned REG_SEC_COUNT,
             unsigned CMD_REQUEST_RD,
-            unsigned CMD_REQUEST_WR >
-SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR > ::
-SysdarftDiskImager(const std::string &file_name)
+            unsigned CMD_REQUEST_WR,
+            unsigned CMD_FLUSH >
+SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR, CMD_FLUSH > ::
+SysdarftDiskImager(const std::string &file_name, const SysdarftDiskCachePolicy cache_policy)
 {
-    _sysdarftHardDiskFile = open(file_name.c_str(), O_RDWR | O_SYNC | O_CLOEXEC);
+    // written through, every write is on the disk once it returns. Anything else goes through the cache
+    const int sync = cache_policy == SysdarftDiskCachePolicy::WriteThrough ? O_DSYNC : 0;
+    _sysdarftHardDiskFile = open(file_name.c_str(), O_RDWR | sync | O_CLOEXEC);
     if (_sysdarftHardDiskFile == -1) {
         throw SysdarftDiskError("Cannot open file " + file_name);
     }
@@ -43,23 +46,38 @@ SysdarftDiskImager(const std::string &file_name)
         throw SysdarftDiskError("Failed to lock file " + file_name + ", possibly used by another process?");
     }
 
+    // two disks over one file would each cache it on their own and overwrite each other.
+    // Not closed here, closing any descriptor of the file drops the lock the other disk holds on it
+    if (!attach_file(_sysdarftHardDiskFile)) {
+        throw SysdarftDiskError("File " + file_name + " is already attached as another disk");
+    }
+
     device_buffer.emplace(REG_SIZE,         std::make_unique<ControllerDataStream>());
     device_buffer.emplace(REG_START_SEC,    std::make_unique<ControllerDataStream>());
     device_buffer.emplace(REG_SEC_COUNT,    std::make_unique<ControllerDataStream>());
-    device_buffer.emplace(CMD_REQUEST_RD,   std::make_unique<ControllerDataStream>());
-    device_buffer.emplace(CMD_REQUEST_WR,   std::make_unique<ControllerDataStream>());
+    device_buffer.emplace(CMD_REQUEST_RD,   std::make_unique<ControllerDataStream>(DISK_MAX_TRANSFER_SIZE));
+    device_buffer.emplace(CMD_REQUEST_WR,   std::make_unique<ControllerDataStream>(DISK_MAX_TRANSFER_SIZE));
+    device_buffer.emplace(CMD_FLUSH,        std::make_unique<ControllerDataStream>());
 
     (*(uint64_t*)&device_size) = getFileSize(_sysdarftHardDiskFile);
+
+    if (cache_policy != SysdarftDiskCachePolicy::WriteThrough) {
+        cache = std::make_unique<SysdarftDiskCache>(_sysdarftHardDiskFile, device_size, cache_policy);
+    }
 }
 
 template <  unsigned REG_SIZE,
             unsigned REG_START_SEC,
             unsigned REG_SEC_COUNT,
             unsigned CMD_REQUEST_RD,
-            unsigned CMD_REQUEST_WR >
-SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR > ::
+            unsigned CMD_REQUEST_WR,
+            unsigned CMD_FLUSH >
+SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR, CMD_FLUSH > ::
 ~SysdarftDiskImager() noexcept
 {
+    // write back what is still cached while the file is open
+    cache.reset();
+
     // try unlock file
     if (lock_file(_sysdarftHardDiskFile, F_SETLK, F_UNLCK) == -1)
     {
@@ -70,6 +88,7 @@ SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD
     }
 
     // close
+    detach_file(_sysdarftHardDiskFile);
     close(_sysdarftHardDiskFile);
 }
 
@@ -77,9 +96,10 @@ template <  unsigned REG_SIZE,
             unsigned REG_START_SEC,
             unsigned REG_SEC_COUNT,
             unsigned CMD_REQUEST_RD,
-            unsigned CMD_REQUEST_WR >
+            unsigned CMD_REQUEST_WR,
+            unsigned CMD_FLUSH >
 bool
-SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR > ::
+SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR, CMD_FLUSH > ::
 request_read(const uint64_t port)
 {
     if (port == REG_SIZE)
@@ -102,23 +122,29 @@ request_read(const uint64_t port)
             return false;
         }
 
-        // Seek to the specified offset
-        if (lseek64(_sysdarftHardDiskFile, start_off, SEEK_SET) == -1) {
+        // read straight into the data stream, nothing is published unless all of it was read
+        const auto stream = device_buffer.at(port).get();
+        const auto spans = stream->writable_spans();
+        if (spans[0].size() + spans[1].size() < length) {
             return false;
         }
 
-        std::vector<uint8_t> buffer;
-        buffer.resize(length);
+        uint64_t done = 0;
+        for (const auto & span : spans)
+        {
+            const uint64_t chunk = std::min<uint64_t>(span.size(), length - done);
+            if (chunk == 0) {
+                break;
+            }
 
-        // Read 'length' bytes from the file
-        const auto read_len = read(_sysdarftHardDiskFile, buffer.data(), static_cast<long>(length));
+            if (!host_read(start_off + done, chunk, span.data())) {
+                return false;
+            }
 
-        if (read_len != static_cast<std::streamsize>(length)) {
-            return false;
+            done += chunk;
         }
 
-        device_buffer.at(port)->insert(buffer);
-
+        stream->commit(length);
         return true;
     }
 
@@ -129,9 +155,10 @@ template <  unsigned REG_SIZE,
             unsigned REG_START_SEC,
             unsigned REG_SEC_COUNT,
             unsigned CMD_REQUEST_RD,
-            unsigned CMD_REQUEST_WR >
+            unsigned CMD_REQUEST_WR,
+            unsigned CMD_FLUSH >
 bool
-SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR > ::
+SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR, CMD_FLUSH > ::
 request_write(const uint64_t port)
 {
     if (port == REG_START_SEC)
@@ -158,30 +185,134 @@ request_write(const uint64_t port)
             return false;
         }
 
-        auto buffer = device_buffer.at(port)->getObject();
-
-        if (length != buffer.size()) {
+        const auto stream = device_buffer.at(port).get();
+        if (length != stream->getSize()) {
             return false;
         }
 
-        // Seek to the specified offset
-        if (lseek64(_sysdarftHardDiskFile, start_off, SEEK_SET) == -1) {
-            return false;
+        // written straight from the data stream
+        uint64_t done = 0;
+        for (const auto & span : stream->readable_spans())
+        {
+            if (span.empty()) {
+                continue;
+            }
+
+            if (!host_write(start_off + done, span.size(), span.data())) {
+                return false;
+            }
+
+            done += span.size();
         }
 
-        const auto write_len = write(_sysdarftHardDiskFile, buffer.data(), static_cast<long>(length));
-        if (write_len != static_cast<std::streamsize>(length)) {
+        stream->consume(length);
+        return true;
+    }
+    else if (port == CMD_FLUSH)
+    {
+        device_buffer.at(port)->clear();
+        return cache ? cache->flush() : fdatasync(_sysdarftHardDiskFile) == 0;
+    }
+
+    return false;
+}
+
+template <  unsigned REG_SIZE,
+            unsigned REG_START_SEC,
+            unsigned REG_SEC_COUNT,
+            unsigned CMD_REQUEST_RD,
+            unsigned CMD_REQUEST_WR,
+            unsigned CMD_FLUSH >
+bool
+SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR, CMD_FLUSH > ::
+in_range(const uint64_t start, const uint64_t count) const
+{
+    const uint64_t total = sectors();
+    return count != 0 && count <= total && start <= total - count;
+}
+
+template <  unsigned REG_SIZE,
+            unsigned REG_START_SEC,
+            unsigned REG_SEC_COUNT,
+            unsigned CMD_REQUEST_RD,
+            unsigned CMD_REQUEST_WR,
+            unsigned CMD_FLUSH >
+bool
+SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR, CMD_FLUSH > ::
+host_read(const uint64_t offset, const uint64_t length, uint8_t * dest)
+{
+    if (cache) {
+        return cache->read(offset, length, dest);
+    }
+
+    uint64_t done = 0;
+    while (done < length)
+    {
+        const auto read_len = pread64(_sysdarftHardDiskFile, dest + done, length - done,
+            static_cast<off64_t>(offset + done));
+        if (read_len <= 0) {
             return false;
         }
 
-        // flash device
-        fsync(_sysdarftHardDiskFile);
+        done += read_len;
+    }
 
-        device_buffer.at(port)->clear();
-        return true;
+    return true;
+}
+
+template <  unsigned REG_SIZE,
+            unsigned REG_START_SEC,
+            unsigned REG_SEC_COUNT,
+            unsigned CMD_REQUEST_RD,
+            unsigned CMD_REQUEST_WR,
+            unsigned CMD_FLUSH >
+bool
+SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR, CMD_FLUSH > ::
+host_write(const uint64_t offset, const uint64_t length, const uint8_t * source)
+{
+    if (cache) {
+        return cache->write(offset, length, source);
     }
 
-    return false;
+    uint64_t done = 0;
+    while (done < length)
+    {
+        const auto write_len = pwrite64(_sysdarftHardDiskFile, source + done, length - done,
+            static_cast<off64_t>(offset + done));
+        if (write_len <= 0) {
+            return false;
+        }
+
+        done += write_len;
+    }
+
+    return true;
+}
+
+template <  unsigned REG_SIZE,
+            unsigned REG_START_SEC,
+            unsigned REG_SEC_COUNT,
+            unsigned CMD_REQUEST_RD,
+            unsigned CMD_REQUEST_WR,
+            unsigned CMD_FLUSH >
+bool
+SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR, CMD_FLUSH > ::
+read_sectors(const uint64_t start, const uint64_t count, uint8_t * dest)
+{
+    return in_range(start, count) && host_read(start * DISK_SECTOR_SIZE, count * DISK_SECTOR_SIZE, dest);
+}
+
+template <  unsigned REG_SIZE,
+            unsigned REG_START_SEC,
+            unsigned REG_SEC_COUNT,
+            unsigned CMD_REQUEST_RD,
+            unsigned CMD_REQUEST_WR,
+            unsigned CMD_FLUSH >
+bool
+SysdarftDiskImager < REG_SIZE, REG_START_SEC, REG_SEC_COUNT, CMD_REQUEST_RD, CMD_REQUEST_WR, CMD_FLUSH > ::
+write_sectors(const uint64_t start, const uint64_t count, const uint8_t * source)
+{
+    return in_range(start, count) && host_write(start * DISK_SECTOR_SIZE, count * DISK_SECTOR_SIZE, source);
 }
 
 #endif //SYSDARFTDISKS_INL
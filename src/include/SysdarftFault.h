@@ -0,0 +1,45 @@
+/* SysdarftFault.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef SYSDARFTFAULT_H
+#define SYSDARFTFAULT_H
+
+#include <cstdint>
+
+/*
+ * Guest faults, returned by the decoder, memory and IO hub instead of being thrown.
+ * The instruction executor turns a fault into its hardware interruption
+ * (see SysdarftCPUInstructionExecutor::deliver_pending_fault()).
+ * Exceptions are left for host side errors only.
+ */
+enum class SysdarftFaultType : uint8_t
+{
+    None = 0,
+    IllegalInstruction,     // INT_ILLEGAL_INSTRUCTION
+    StackOverflow,          // INT_STACKOVERFLOW
+    IllegalMemoryAccess,    // INT_ILLEGAL_MEMORY_ACCESS
+    BadInterruption,        // INT_BAD_INTR
+    DeviceIOError,          // INT_IO_ERROR, %EXR0 == 0xF0
+    NoSuchDevice,           // INT_IO_ERROR, %EXR0 == 0xF1
+    PageFault,              // INT_PAGE_FAULT, linear address in PageFaultAddress
+    Fatal,                  // INT_FATAL
+};
+
+#endif //SYSDARFTFAULT_H
@@ -21,11 +21,20 @@
 #ifndef SYSDARFTIOHUB_H
 #define SYSDARFTIOHUB_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cstdint>
+#include <cstring>
 #include <map>
+#include <unordered_map>
+#include <mutex>
+#include <span>
 #include <vector>
 #include <memory>
 #include <SysdarftDebug.h>
+#include <SysdarftFault.h>
 
 class SysdarftNoSuchDevice final : public SysdarftBaseError
 {
@@ -33,73 +42,173 @@ public:
     explicit SysdarftNoSuchDevice(const std::string& msg) : SysdarftBaseError("No such device: " + msg) { }
 };
 
+class SysdarftPortConflict final : public SysdarftBaseError
+{
+public:
+    explicit SysdarftPortConflict(const std::string& msg) : SysdarftBaseError("I/O port conflict: " + msg) { }
+};
+
 class SysdarftDeviceIOError : public SysdarftBaseError {
 public:
     explicit SysdarftDeviceIOError(const std::string& msg) : SysdarftBaseError("Device I/O Error: " + msg) { }
 };
 
+#define CONTROLLER_DATA_STREAM_DEFAULT_CAPACITY (256)
+
+// Bounded byte ring buffer between a device and the CPU.
+// One thread pushes and one thread pops (it may be the same one), neither of them takes a lock.
+// Positions only ever grow, and are taken modulo the capacity when indexing the ring.
+// Bulk operations are all or nothing, a full or short buffer leaves the stream untouched
 class ControllerDataStream {
 private:
-    std::mutex buffer_mutex_;
-    std::vector < uint8_t > device_buffer;
+    const uint64_t capacity;
+    const std::unique_ptr < uint8_t[] > ring;
+    alignas(64) std::atomic < uint64_t > read_position = 0;    // only written by the consumer
+    alignas(64) std::atomic < uint64_t > write_position = 0;   // only written by the producer
+
+    // part of the ring from position on, as up to two spans since it wraps around at the end
+    template < typename ByteType >
+    std::array < std::span < ByteType >, 2 > spans_from(const uint64_t position, const uint64_t size) const
+    {
+        const uint64_t offset = position & (capacity - 1);
+        const uint64_t first = std::min(size, capacity - offset);
+        return { std::span < ByteType > (ring.get() + offset, first),
+                 std::span < ByteType > (ring.get(), size - first) };
+    }
 
 public:
+    explicit ControllerDataStream(const uint64_t min_capacity = CONTROLLER_DATA_STREAM_DEFAULT_CAPACITY)
+        : capacity(std::bit_ceil(min_capacity)),
+          ring(std::make_unique_for_overwrite < uint8_t[] > (capacity)) { }
+
+    // producer side, false if there is not enough room for data
+    bool push_span(const std::span < const uint8_t > data)
+    {
+        const uint64_t write = write_position.load(std::memory_order_relaxed);
+        const uint64_t read = read_position.load(std::memory_order_acquire);
+        if (capacity - (write - read) < data.size()) {
+            return false;
+        }
+
+        uint64_t done = 0;
+        for (const auto & span : spans_from < uint8_t > (write, data.size())) {
+            std::memcpy(span.data(), data.data() + done, span.size());
+            done += span.size();
+        }
+
+        write_position.store(write + data.size(), std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, false if there are fewer bytes than data.size()
+    bool pop_span(const std::span < uint8_t > data)
+    {
+        const uint64_t read = read_position.load(std::memory_order_relaxed);
+        const uint64_t write = write_position.load(std::memory_order_acquire);
+        if (write - read < data.size()) {
+            return false;
+        }
+
+        uint64_t done = 0;
+        for (const auto & span : spans_from < const uint8_t > (read, data.size())) {
+            std::memcpy(data.data() + done, span.data(), span.size());
+            done += span.size();
+        }
+
+        read_position.store(read + data.size(), std::memory_order_release);
+        return true;
+    }
+
+    // zero copy producer side, the free part of the ring. Filled in and then published by commit()
+    [[nodiscard]] std::array < std::span < uint8_t >, 2 > writable_spans() const
+    {
+        const uint64_t write = write_position.load(std::memory_order_relaxed);
+        const uint64_t read = read_position.load(std::memory_order_acquire);
+        return spans_from < uint8_t > (write, capacity - (write - read));
+    }
+
+    void commit(const uint64_t size) {
+        write_position.store(write_position.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    // zero copy consumer side, what is in the ring. Looked at and then released by consume()
+    [[nodiscard]] std::array < std::span < const uint8_t >, 2 > readable_spans() const
+    {
+        const uint64_t read = read_position.load(std::memory_order_relaxed);
+        const uint64_t write = write_position.load(std::memory_order_acquire);
+        return spans_from < const uint8_t > (read, write - read);
+    }
+
+    void consume(const uint64_t size) {
+        read_position.store(read_position.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
     template < typename DataType >
     void push(const DataType & data)
     {
-        std::lock_guard<std::mutex> lock(buffer_mutex_);
-        for (unsigned int i = 0; i < sizeof(data); i++) {
-            device_buffer.emplace_back(((uint8_t*)&data)[i]);
+        if (!push_span({ reinterpret_cast<const uint8_t*>(&data), sizeof(data) })) {
+            throw SysdarftDeviceIOError("Device buffer is full");
         }
     }
 
     template < typename DataType >
     DataType pop()
     {
-        std::lock_guard<std::mutex> lock(buffer_mutex_);
         DataType data { };
-        for (unsigned int i = 0; i < sizeof(data); i++)
-        {
-            if (device_buffer.empty()) {
-                throw SysdarftDeviceIOError("Device buffer is empty");
-            } else {
-                ((uint8_t*)&data)[i] = device_buffer.front();
-                device_buffer.erase(device_buffer.begin());
-            }
+        if (!pop_span({ reinterpret_cast<uint8_t*>(&data), sizeof(data) })) {
+            throw SysdarftDeviceIOError("Device buffer is empty");
         }
 
         return data;
     }
 
+    // same as pop(), but reports a short buffer by returning false, nothing is consumed in that case
+    template < typename DataType >
+    bool try_pop(DataType & data)
+    {
+        return pop_span({ reinterpret_cast<uint8_t*>(&data), sizeof(DataType) });
+    }
+
     void insert(const std::vector<uint8_t> & data)
     {
-        std::lock_guard<std::mutex> lock(buffer_mutex_);
-        device_buffer.insert(device_buffer.end(), data.begin(), data.end());
+        if (!push_span(data)) {
+            throw SysdarftDeviceIOError("Device buffer is full");
+        }
     }
 
-    void insert(ControllerDataStream & data)
+    // append everything in data, data itself is left as it is. Called by the producer of this stream
+    // and the consumer of data
+    void insert(const ControllerDataStream & data)
     {
-        std::lock_guard lock(buffer_mutex_);
-        std::lock_guard lock2(data.buffer_mutex_);
-        device_buffer.insert(device_buffer.end(), data.device_buffer.begin(), data.device_buffer.end());
+        const auto source = data.readable_spans();
+        if (capacity - getSize() < source[0].size() + source[1].size()) {
+            throw SysdarftDeviceIOError("Device buffer is full");
+        }
+
+        for (const auto & span : source) {
+            push_span(span);
+        }
     }
 
-    std::vector < uint8_t > getObject()
+    std::vector < uint8_t > getObject() const
     {
-        std::lock_guard<std::mutex> lock(buffer_mutex_);
-        return device_buffer;
+        std::vector < uint8_t > object;
+        for (const auto & span : readable_spans()) {
+            object.insert(object.end(), span.begin(), span.end());
+        }
+
+        return object;
     }
 
-    [[nodiscard]] uint64_t getSize()
+    [[nodiscard]] uint64_t getSize() const
     {
-        std::lock_guard lock(buffer_mutex_);
-        return device_buffer.size();
+        return write_position.load(std::memory_order_acquire) - read_position.load(std::memory_order_acquire);
     }
 
+    // consumer side, drop everything pushed so far
     void clear()
     {
-        std::lock_guard<std::mutex> lock(buffer_mutex_);
-        device_buffer.clear();
+        read_position.store(write_position.load(std::memory_order_acquire), std::memory_order_release);
     }
 
     ControllerDataStream & operator=(ControllerDataStream&) = delete;
@@ -110,6 +219,7 @@ class SysdarftExternalDeviceBaseClass
 public:
     virtual ~SysdarftExternalDeviceBaseClass() = default;
     std::mutex buffer_mutex_;
+    // every port the device answers on, set up by its constructor and left alone once it is registered
     std::map < uint64_t /* IO Port */, std::unique_ptr < ControllerDataStream > > device_buffer;
     virtual bool request_read(uint64_t /* IO Port */) { return false; }
     virtual bool request_write(uint64_t /* IO Port */) { return false; }
@@ -118,13 +228,41 @@ public:
 class SYSDARFT_EXPORT_SYMBOL SysdarftIOHub
 {
 private:
-    SysdarftExternalDeviceBaseClass & query_device_based_on_port(uint64_t);
+    // Port routing table, filled in by register_device() and only read afterward, so lookups take no lock.
+    // Low ports are looked up in a flat array, anything higher in a hash map
+    static constexpr uint64_t DIRECT_PORT_COUNT = 0x400;
+
+    struct PortRouteType {
+        SysdarftExternalDeviceBaseClass * device = nullptr;
+        ControllerDataStream * stream = nullptr;
+    };
+
+    std::array < PortRouteType, DIRECT_PORT_COUNT > DirectPorts { };
+    std::unordered_map < uint64_t, PortRouteType > SparsePorts;
+
+    [[nodiscard]] const PortRouteType * route(const uint64_t port) const
+    {
+        if (port < DIRECT_PORT_COUNT) [[likely]] {
+            return DirectPorts[port].device != nullptr ? &DirectPorts[port] : nullptr;
+        }
+
+        const auto route = SparsePorts.find(port);
+        return route != SparsePorts.end() ? &route->second : nullptr;
+    }
 
 protected:
-    std::mutex list_mutex_;
     std::vector < std::unique_ptr < SysdarftExternalDeviceBaseClass > > device_list;
-    ControllerDataStream & ins(uint64_t port);
-    void outs(uint64_t port, ControllerDataStream & buffer);
+
+    // take the device and route its ports to it. Done before the guest runs,
+    // a port some other device already answers on throws SysdarftPortConflict and nothing is registered
+    void register_device(std::unique_ptr < SysdarftExternalDeviceBaseClass > device);
+
+    // guest IO, failures are returned as SysdarftFaultType::NoSuchDevice or SysdarftFaultType::DeviceIOError
+    [[nodiscard]] SysdarftFaultType ins(uint64_t port, ControllerDataStream *& buffer);
+    [[nodiscard]] SysdarftFaultType outs(uint64_t port, ControllerDataStream & buffer);
+
+    // devices go away in the reverse order they were registered in, so a device can use any registered before it
+    ~SysdarftIOHub();
 };
 
 #endif //SYSDARFTIOHUB_H
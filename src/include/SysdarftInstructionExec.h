@@ -22,8 +22,13 @@
 #define SYSDARFTINSTRUCTIONEXEC_H
 
 #include <any>
+#include <array>
+#include <exception>
+#include <limits>
+#include <type_traits>
 #include <SysdarftCPUDecoder.h>
 #include <SysdarftIOHub.h>
+#include <SysdarftJIT.h>
 
 // CPU subroutine request to abort the current instruction execution procedure dur to error
 class SysdarftCPUSubroutineRequestToAbortTheCurrentInstructionExecutionProcedureDueToError final : SysdarftBaseError {
@@ -33,30 +38,94 @@ public:
 };
 
 #define add_instruction_exec(name) void name(__uint128_t, WidthAndOperandsType &)
+#define add_width_specialized_instruction_exec(name) template < typename WidthType > add_instruction_exec(name)
+
+// explicit instantiations of a width specialized executor, placed right after its definition
+#define instantiate_width_specialized_instruction_exec(name) \
+    template void SysdarftCPUInstructionExecutor::name<uint8_t>(__uint128_t, WidthAndOperandsType &); \
+    template void SysdarftCPUInstructionExecutor::name<uint16_t>(__uint128_t, WidthAndOperandsType &); \
+    template void SysdarftCPUInstructionExecutor::name<uint32_t>(__uint128_t, WidthAndOperandsType &); \
+    template void SysdarftCPUInstructionExecutor::name<uint64_t>(__uint128_t, WidthAndOperandsType &)
+
+// Compile time description of an operation width, for width specialized executors
+template < typename WidthType >
+struct OperationWidthTraits;
+
+template <>
+struct OperationWidthTraits<uint8_t> {
+    static constexpr uint8_t BCDWidth = _8bit_prefix;
+    using RegisterAccessType = RegisterType;
+};
+
+template <>
+struct OperationWidthTraits<uint16_t> {
+    static constexpr uint8_t BCDWidth = _16bit_prefix;
+    using RegisterAccessType = ExtendedRegisterType;
+};
+
+template <>
+struct OperationWidthTraits<uint32_t> {
+    static constexpr uint8_t BCDWidth = _32bit_prefix;
+    using RegisterAccessType = HalfExtendedRegisterType;
+};
+
+template <>
+struct OperationWidthTraits<uint64_t> {
+    static constexpr uint8_t BCDWidth = _64bit_prefix;
+    using RegisterAccessType = FullyExtendedRegisterType;
+};
 
 class SYSDARFT_EXPORT_SYMBOL SysdarftCPUInstructionExecutor : public SysdarftCPUInstructionDecoder, public SysdarftIOHub
 {
 private:
-    uint64_t check_overflow(uint8_t BCDWidth, __uint128_t Value);
-    uint64_t check_overflow_signed(uint8_t BCDWidth, __uint128_t Value);
+    // truncate to the operation width, Carry is set once the flags are read if the value does not fit
+    template < typename WidthType >
+    uint64_t check_overflow(const __uint128_t Value)
+    {
+        constexpr uint64_t mask = std::numeric_limits<WidthType>::max();
+        defer_flags(LazyFlagsType::Unsigned, mask, Value);
+        return Value & mask;
+    }
 
+    // truncate to the operation width, Overflow is set once the flags are read if the value does not fit as signed.
+    // 8bit results come back zero extended, wider ones sign extended to 64bit
+    template < typename WidthType >
+    uint64_t check_overflow_signed(const __uint128_t Value)
+    {
+        constexpr uint64_t mask = std::numeric_limits<WidthType>::max();
+        defer_flags(LazyFlagsType::Signed, mask, Value);
+
+        const auto truncated = static_cast<WidthType>(Value);
+        if constexpr (std::is_same_v<WidthType, uint8_t>) {
+            return truncated;
+        } else {
+            return static_cast<uint64_t>(static_cast<int64_t>(static_cast<std::make_signed_t<WidthType>>(truncated)));
+        }
+    }
+
+    // stack accesses raise SysdarftFaultType::StackOverflow (or PageFault), and do nothing once the instruction has faulted
     template < typename DataType >
     void push_stack(const DataType & val)
     {
+        if (fault_pending()) {
+            return;
+        }
+
         const auto SP = SysdarftRegister::load<StackPointerType>();
         const auto SB = SysdarftRegister::load<StackBaseType>();
 
         // Stack overflow
         if (SP < sizeof(DataType)) {
-            throw StackOverflow();
+            raise_fault(SysdarftFaultType::StackOverflow);
+            return;
         }
 
         const auto StackNewLowerEnd = SP - sizeof(DataType);
 
-        try {
-            SysdarftCPUMemoryAccess::write_memory(StackNewLowerEnd + SB, (char*)&val, sizeof(DataType));
-        } catch (IllegalMemoryAccessException & ) {
-            throw StackOverflow();
+        if (const auto fault = try_store_linear(StackNewLowerEnd + SB, val); fault != SysdarftFaultType::None)
+        {
+            raise_fault(fault == SysdarftFaultType::PageFault ? fault : SysdarftFaultType::StackOverflow);
+            return;
         }
 
         SysdarftRegister::store<StackPointerType>(StackNewLowerEnd);
@@ -66,13 +135,17 @@ private:
     DataType pop_stack()
     {
         DataType val { };
+        if (fault_pending()) {
+            return val;
+        }
+
         const auto SP = SysdarftRegister::load<StackPointerType>();
         const auto SB = SysdarftRegister::load<StackBaseType>();
 
-        try {
-            SysdarftCPUMemoryAccess::read_memory(SB + SP, (char*)&val, sizeof(DataType));
-        } catch (IllegalMemoryAccessException & ) {
-            throw StackOverflow();
+        if (const auto fault = try_load_linear(SB + SP, val); fault != SysdarftFaultType::None)
+        {
+            raise_fault(fault == SysdarftFaultType::PageFault ? fault : SysdarftFaultType::StackOverflow);
+            return val;
         }
 
         SysdarftRegister::store<StackPointerType>(SP + sizeof(DataType));
@@ -80,17 +153,13 @@ private:
     }
 
 public:
-    typedef std::pair < uint8_t /* width */, std::vector < OperandType > > WidthAndOperandsType;
+    typedef std::pair < uint8_t /* width */, OperandListType > WidthAndOperandsType;
 
 protected:
-    std::map <uint8_t /* opcode */,
-        void (SysdarftCPUInstructionExecutor::*)(__uint128_t, WidthAndOperandsType &) /* method */ > ExecutorMap;
+    using ExecutorType = void (SysdarftCPUInstructionExecutor::*)(__uint128_t, WidthAndOperandsType &);
 
-    void make_instruction_execution_procedure(uint8_t opcode,
-        void (SysdarftCPUInstructionExecutor::*method)(__uint128_t, WidthAndOperandsType &))
-    {
-        ExecutorMap.emplace(opcode, method);
-    }
+    // Handler indexed executor table (see handler_index()), generated from SYSDARFT_INSTRUCTION_SET
+    static const std::array<ExecutorType, INSTRUCTION_HANDLER_COUNT> ExecutorTable;
 
     void show_context();
     bool default_is_break_here(__uint128_t) { return false; }
@@ -102,6 +171,12 @@ protected:
     IsBreakHereFn is_break_here;
     BreakpointHandlerFn breakpoint_handler;
 
+    // a debugger is attached, and wants to see every single instruction
+    bool breakpoints_bound = false;
+
+    // the system was halted by HLT, and not from outside the guest
+    bool HaltedByGuest = false;
+
 public:
     template < class InstanceType >
     void bindIsBreakHere(InstanceType* instance, bool (InstanceType::*memFunc)(__uint128_t))
@@ -109,6 +184,8 @@ public:
         is_break_here = [instance, memFunc](__uint128_t timestamp) -> bool {
             return (instance->*memFunc)(timestamp);
         };
+
+        breakpoints_bound = !std::is_same_v<InstanceType, SysdarftCPUInstructionExecutor>;
     }
 
     template < class InstanceType >
@@ -131,30 +208,33 @@ private:
     add_instruction_exec(alwi);
 
     // Arithmetic
-    add_instruction_exec(add);
-    add_instruction_exec(adc);
-    add_instruction_exec(sub);
-    add_instruction_exec(sbb);
-    add_instruction_exec(imul);
-    add_instruction_exec(mul);
-    add_instruction_exec(idiv);
-    add_instruction_exec(div);
+    add_width_specialized_instruction_exec(add);
+    add_width_specialized_instruction_exec(adc);
+    add_width_specialized_instruction_exec(sub);
+    add_width_specialized_instruction_exec(sbb);
+    add_width_specialized_instruction_exec(imul);
+    add_width_specialized_instruction_exec(mul);
+    add_width_specialized_instruction_exec(idiv);
+    add_width_specialized_instruction_exec(div);
     add_instruction_exec(neg);
     add_instruction_exec(cmp);
-    add_instruction_exec(inc);
-    add_instruction_exec(dec);
+    add_width_specialized_instruction_exec(inc);
+    add_width_specialized_instruction_exec(dec);
 
     // Data Transfer
     add_instruction_exec(mov);
     add_instruction_exec(xchg);
-    add_instruction_exec(push);
-    add_instruction_exec(pop);
+    add_width_specialized_instruction_exec(push);
+    add_width_specialized_instruction_exec(pop);
     add_instruction_exec(pushall);
     add_instruction_exec(popall);
     add_instruction_exec(enter);
     add_instruction_exec(leave);
     add_instruction_exec(movs);
     add_instruction_exec(lea);
+    add_instruction_exec(stos);
+    add_instruction_exec(cmps);
+    add_instruction_exec(scas);
 
     // Logic and Bitwise
     add_instruction_exec(and_);
@@ -163,10 +243,10 @@ private:
     add_instruction_exec(not_);
     add_instruction_exec(shl);
     add_instruction_exec(shr);
-    add_instruction_exec(rol);
-    add_instruction_exec(ror);
-    add_instruction_exec(rcl);
-    add_instruction_exec(rcr);
+    add_width_specialized_instruction_exec(rol);
+    add_width_specialized_instruction_exec(ror);
+    add_width_specialized_instruction_exec(rcl);
+    add_width_specialized_instruction_exec(rcr);
 
     // Control Flow
     add_instruction_exec(jmp);
@@ -187,20 +267,126 @@ private:
     add_instruction_exec(jno);
     add_instruction_exec(loop);
 
+    // Fused, see SYSDARFT_FUSED_INSTRUCTION_SET
+    add_instruction_exec(cmp_je);
+    add_instruction_exec(cmp_jne);
+    add_instruction_exec(cmp_jb);
+    add_instruction_exec(cmp_jl);
+    add_instruction_exec(cmp_jbe);
+    add_instruction_exec(cmp_jle);
+
+    // cmp and the conditional jump after it, branching on Condition(operand1, operand2) directly
+    template < typename ConditionType >
+    void compare_and_branch(WidthAndOperandsType & WidthAndOperands, ConditionType && Condition);
+
     // IO
     add_instruction_exec(in);
     add_instruction_exec(out);
     add_instruction_exec(ins);
     add_instruction_exec(outs);
 
+    // Paging
+    add_instruction_exec(lpt);
+    add_instruction_exec(tlbfl);
+    add_instruction_exec(invlpg);
+    add_instruction_exec(enpg);
+    add_instruction_exec(dspg);
+    add_instruction_exec(rdpfa);
+
+    // privileged instructions raise SysdarftFaultType::IllegalInstruction in user mode
+    bool require_privilege();
+
+    template < typename ProcedureType >
+    void handle_execution_errors(ProcedureType && procedure);
+    // the only place a guest fault is turned into its hardware interruption
+    void deliver_pending_fault();
+    // returns the handler index, see handler_index()
+    uint16_t fetch_instruction(__uint128_t timestamp, WidthAndOperandsType & Arg);
+    [[nodiscard]] bool execution_event_pending() const;
+    void run_threaded(__uint128_t & timestamp);
+
+    /*
+     * Basic block translator (SysdarftJIT.cpp).
+     * A block runs from its first instruction up to and including the first control flow
+     * instruction (jumps, call, ret, int, int3, iret, loop and hlt).
+     * Register to register and constant to register forms of mov, add, sub, cmp, inc, dec,
+     * and, or and xor are emitted as host code, everything else calls its handler.
+     * Events, faults and breakpoints are handled between blocks.
+     */
+    struct JITInstructionType {
+        uint8_t opcode;
+        uint8_t width;
+        uint16_t handler;
+        uint8_t operand_count;
+        std::array < OperandType::OperandEncodingType, 2 > operands;
+        uint64_t code_base;
+        uint64_t ip;
+        uint64_t next_ip;
+        uint32_t index; // position inside the block, its timestamp is JITBlockTimestamp + index
+    };
+
+    struct JITBlockType {
+        uint64_t code_base;
+        uint64_t first_page;
+        uint64_t last_page;
+        SysdarftJITCodeBuffer::EntryType entry;
+        std::vector < JITInstructionType > instructions; // referenced by the host code, never resized
+    };
+
+    SysdarftJITCodeBuffer JITCode;
+    std::unordered_map < uint64_t /* linear address */, JITBlockType > JITBlocks;
+    std::unordered_map < uint64_t /* memory block */, std::vector < uint64_t > > JITBlocksByPage;
+    __uint128_t JITBlockTimestamp = 0;
+    std::exception_ptr JITPendingException;
+
+    static bool jit_call_out(SysdarftCPUInstructionExecutor * cpu, const JITInstructionType * instruction) noexcept;
+    bool jit_execute_instruction(const JITInstructionType & instruction);
+    bool jit_emit_native(const JITInstructionType & instruction);
+    void jit_emit_call_out(const JITInstructionType & instruction, uint64_t exit_offset);
+    const JITBlockType * jit_translate_block(uint64_t code_base, uint64_t ip);
+    void jit_drop_translations(const std::vector < uint64_t > & pages);
+    // whoever drains the invalidation queue, interpreter fetch included, drops the translations too
+    void decoded_blocks_invalidated(const std::vector < uint64_t > & blocks) override { jit_drop_translations(blocks); }
+    void jit_flush();
+    void run_jit(__uint128_t & timestamp);
+
+#ifdef __DEBUG__
+    void log_instruction(uint8_t opcode, const WidthAndOperandsType & Arg);
+    void log_instruction_result(uint8_t opcode, const WidthAndOperandsType & Arg);
+#endif
+
 protected:
     // initialization
-    explicit SysdarftCPUInstructionExecutor(uint64_t memory, const std::string & font_name);
+    explicit SysdarftCPUInstructionExecutor(const SysdarftMemoryOptions & memory, const std::string & font_name);
 
-    // general code execution
+    // general code execution, one instruction at a time
     void execute(__uint128_t timestamp);
+
+    // direct threaded execution, runs until an event needs to be handled by the caller
+    // (halt, keyboard abort, shutdown request, or external device interruption)
+    void execute_threaded(__uint128_t & timestamp);
+
+    // translated execution, runs until an event needs to be handled by the caller, like execute_threaded()
+    void execute_jit(__uint128_t & timestamp);
+
+    SysdarftRegisterSnapshot RegisterSnapshot;
+
+public:
+    // execution thread only, called at instruction boundaries
+    void publish_register_snapshot() { RegisterSnapshot.publish(SysdarftRegister::load<WholeRegisterType>()); }
+
+    // consistent copy of the registers as of the last published instruction boundary, safe from any thread
+    [[nodiscard]] SysdarftRegister register_snapshot() const { return RegisterSnapshot.read(); }
+
+    enum class ExecutionEngineType { Interpreter, Threaded, JIT };
+    ExecutionEngineType ExecutionEngine = ExecutionEngineType::Interpreter;
+
+    std::atomic < uint64_t > JITBlocksTranslated = 0;
+    std::atomic < uint64_t > JITBlocksInvalidated = 0;
+    std::atomic < uint64_t > JITInterpretedInstructions = 0;
 };
 
+#undef add_width_specialized_instruction_exec
 #undef add_instruction_exec
 
 #endif //SYSDARFTINSTRUCTIONEXEC_H
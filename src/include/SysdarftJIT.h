@@ -0,0 +1,157 @@
+/* SysdarftJIT.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef SYSDARFTJIT_H
+#define SYSDARFTJIT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <SysdarftDebug.h>
+
+#if !defined(__x86_64__)
+# error "The basic block translator emits x86-64 machine code only"
+#endif
+
+class SysdarftJITError final : public SysdarftBaseError
+{
+public:
+    explicit SysdarftJITError(const std::string & msg) : SysdarftBaseError("JIT error: " + msg) { }
+};
+
+/*
+ * Executable buffer for translated basic blocks, bump allocated.
+ * Pages being written are mapped RW and flipped to RX once the block is finished,
+ * so the buffer is never writable and executable at the same time.
+ * Translations are never freed one by one, the owner resets the whole buffer once it is full.
+ */
+class SysdarftJITCodeBuffer
+{
+public:
+    // entry point of a translated block, returns the number of guest instructions retired
+    using EntryType = uint32_t (*)();
+
+private:
+    uint8_t * Buffer = nullptr;
+    uint64_t Capacity = 0;
+    uint64_t Cursor = 0;        // end of the last committed block
+    uint64_t BlockStart = 0;    // start of the block being emitted
+    uint64_t PageSize = 4096;
+
+    void protect(const uint64_t begin, const uint64_t end, const int protection) const
+    {
+        const auto page_begin = begin / PageSize * PageSize;
+        const auto page_end = std::min((end + PageSize - 1) / PageSize * PageSize, Capacity);
+        if (page_end > page_begin && mprotect(Buffer + page_begin, page_end - page_begin, protection) != 0) {
+            throw SysdarftJITError("Cannot change protection of the code buffer");
+        }
+    }
+
+public:
+    SysdarftJITCodeBuffer() = default;
+    SysdarftJITCodeBuffer(const SysdarftJITCodeBuffer &) = delete;
+    SysdarftJITCodeBuffer & operator=(const SysdarftJITCodeBuffer &) = delete;
+
+    ~SysdarftJITCodeBuffer()
+    {
+        if (Buffer != nullptr) {
+            munmap(Buffer, Capacity);
+        }
+    }
+
+    // map the buffer, returns false if the host refuses
+    bool reserve(const uint64_t size)
+    {
+        if (Buffer != nullptr) {
+            return true;
+        }
+
+        PageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        const auto capacity = (size + PageSize - 1) / PageSize * PageSize;
+        void * map = mmap(nullptr, capacity, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            return false;
+        }
+
+        Buffer = static_cast<uint8_t*>(map);
+        Capacity = capacity;
+        Cursor = BlockStart = 0;
+        return true;
+    }
+
+    [[nodiscard]] bool reserved() const { return Buffer != nullptr; }
+    [[nodiscard]] uint64_t available() const { return Capacity - Cursor; }
+
+    // drop every translation, the caller must forget all entry points handed out before
+    void reset() { Cursor = BlockStart = 0; }
+
+    // open a block of at most max_size bytes
+    void begin(const uint64_t max_size)
+    {
+        if (max_size > available()) {
+            throw SysdarftJITError("Code buffer exhausted");
+        }
+
+        BlockStart = Cursor;
+        protect(BlockStart, BlockStart + max_size, PROT_READ | PROT_WRITE);
+    }
+
+    // close the block, and return the address of the byte at entry_offset inside it
+    EntryType commit(const uint64_t entry_offset)
+    {
+        protect(BlockStart, Cursor, PROT_READ | PROT_EXEC);
+        // alignment for the next block
+        Cursor = std::min((Cursor + 15) & ~static_cast<uint64_t>(15), Capacity);
+        return reinterpret_cast<EntryType>(Buffer + BlockStart + entry_offset);
+    }
+
+    // offset of the next byte, relative to the start of the block
+    [[nodiscard]] uint64_t offset() const { return Cursor - BlockStart; }
+
+    void emit(const std::initializer_list < uint8_t > bytes)
+    {
+        for (const auto byte : bytes) {
+            Buffer[Cursor++] = byte;
+        }
+    }
+
+    void emit32(const uint32_t value)
+    {
+        std::memcpy(Buffer + Cursor, &value, sizeof(value));
+        Cursor += sizeof(value);
+    }
+
+    void emit64(const uint64_t value)
+    {
+        std::memcpy(Buffer + Cursor, &value, sizeof(value));
+        Cursor += sizeof(value);
+    }
+
+    // jmp rel32 to an offset inside the current block
+    void emit_jmp(const uint64_t target_offset)
+    {
+        emit({ 0xE9 });
+        emit32(static_cast<uint32_t>(static_cast<int64_t>(target_offset) - static_cast<int64_t>(offset() + 4)));
+    }
+};
+
+#endif //SYSDARFTJIT_H
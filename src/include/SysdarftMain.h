@@ -88,8 +88,23 @@ const option_complicated long_options[] = {
     {"hdd",     required_argument,  nullptr, 'L',   "Specify a Hard Disk"},
     {"fda",     required_argument,  nullptr, 'A',   "Specify floppy disk A"},
     {"fdb",     required_argument,  nullptr, 'B',   "Specify floppy disk B"},
+    {"disk-cache",      required_argument,  nullptr, 'k',   "Disk cache policy, writethrough (default), writeback, or unsafe\n"
+                                                                                                "writeback keeps writes in memory, and flushes them every 5 seconds\n"
+                                                                                                "and on FLUSH commands, unsafe only when the system stops"},
     {"memory",  required_argument,  nullptr, 'M',   "Specify memory size (in MB)\n"
                                                                                                 "Left unset and the default size is 32MB"},
+    {"hugepages",       no_argument,        nullptr, 'H',   "Back guest memory with 2MB huge pages\n"
+                                                                                                "Explicit huge pages are used if the host has enough of them reserved,\n"
+                                                                                                "transparent huge pages otherwise"},
+    {"share-memory",    no_argument,        nullptr, 'O',   "Back guest memory with a memfd other local processes can map read only\n"
+                                                                                                "Its path is logged at boot, and published by the debug server (/SharedMemory)"},
+    {"memory-file",     required_argument,  nullptr, 'i',   "Back guest memory with a memory image file, created if it does not exist\n"
+                                                                                                "Memory is kept in the image across runs, and a system stopped from outside\n"
+                                                                                                "(Ctrl+^], debugger) resumes where it was instead of booting again"},
+    {"heatmap",         required_argument,  nullptr, 'T',   "Count guest memory reads, writes and instruction fetches per page or per\n"
+                                                                                                "cache line. It can be page or line. Published by the debug server (/Heatmap)\n"
+                                                                                                "Everything is interpreted, the JIT engine does not count accesses"},
+    {"heatmap-file",    required_argument,  nullptr, 't',   "Write the heatmap histogram to this file once the system stops"},
     {"boot",    no_argument,        nullptr, 'S',   "Boot the system"},
     {"cr-to-lf",        no_argument,        nullptr, 'E',   "Translate ASCII CR('\\r', carriage ret) to LF('\\n', new line)"},
     {"debug",   required_argument,  nullptr, 'D',   "Boot the system with remote debug console\n"
@@ -101,6 +116,13 @@ const option_complicated long_options[] = {
     {"with-gui",no_argument,        nullptr, 'W',   "Launch GUI display"},
     {"font",            required_argument,  nullptr, 'F',     "Specify a font name or a font file\nUse `--font help` to list them"},
     {"crow-log",required_argument,  nullptr, 'C',     "Specify the log file of crow service"},
+    {"no-decode-cache", no_argument,   nullptr, 'P',     "Disable the decoded instruction cache\n"
+                                                                                                "Every instruction is decoded from memory again when executed,\n"
+                                                                                                "which is useful for differential testing"},
+    {"no-fusion",       no_argument,   nullptr, 'U',     "Disable macro-op fusion\n"
+                                                                                                "cmp and the conditional jump after it are executed as two instructions"},
+    {"engine",  required_argument,  nullptr, 'e',     "Specify the execution engine. It can be interpreter, threaded or jit\n"
+                                                                                                "Left unset and the default engine is interpreter"},
     {nullptr,   0,                  nullptr, 0,     nullptr }
 };
 
@@ -208,6 +230,8 @@ private:
     void crow_setup_watcher();
     void crow_setup_disassemble_an_area();
     void crow_setup_pull_data();
+    void crow_setup_shared_memory();
+    void crow_setup_heatmap();
 
 public:
     RemoteDebugServer(const std::string &,
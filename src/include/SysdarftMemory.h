@@ -22,7 +22,13 @@
 #define SYSDARFTMEMORY_H
 
 #include <SysdarftDebug.h>
-#include <array>
+#include <SysdarftFault.h>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
 
 /*
  * Memory Layout:
@@ -48,6 +54,70 @@
 #define BIOS_SIZE           (BIOS_END - BIOS_START + 1)
 
 #define BLOCK_SIZE 4096
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+struct SysdarftMemoryOptions
+{
+    uint64_t Size = 32 * 1024 * 1024; // 32MB Memory
+    bool HugePages = false;
+    bool Shared = false; // guest RAM in a memfd other local processes can map
+    std::string File; // guest RAM in this memory image, see SysdarftMemoryImageHeader
+    uint64_t HeatmapGranularity = 0; // bytes per access heatmap bucket, 0 to count nothing
+};
+
+/*
+ * Memory image:
+ * A MEMORY_IMAGE_HEADER_SIZE byte header, then guest RAM, byte n of it being guest physical address n.
+ * RAM is mapped shared, so it is written back to the image by the host page cache, and the next run
+ * on the same image starts with it intact. CPU state is only in the header if the last run was stopped
+ * from outside the guest, and is dropped once read back.
+ */
+#define MEMORY_IMAGE_HEADER_SIZE (4096)
+#define MEMORY_IMAGE_MAGIC "SYSDARFT-MEMORY"
+#define MEMORY_IMAGE_VERSION (1)
+
+struct SysdarftMemoryImageHeader
+{
+    char Magic[16];
+    uint64_t Version;
+    uint64_t MemorySize;    // TotalMemory
+    uint64_t StateSize;     // bytes of State saved, 0 if none
+    uint8_t State[MEMORY_IMAGE_HEADER_SIZE - 16 - sizeof(uint64_t) * 3];
+};
+
+static_assert(sizeof(SysdarftMemoryImageHeader) == MEMORY_IMAGE_HEADER_SIZE);
+
+/*
+ * Heatmap histogram:
+ * A SysdarftHeatmapHeader, then one SysdarftHeatmapRecord for every bucket accessed at least once,
+ * in ascending order. Bucket n covers guest physical addresses [n * Granularity, (n + 1) * Granularity).
+ * Everything is in host byte order
+ */
+#define HEATMAP_PAGE_GRANULARITY        BLOCK_SIZE
+#define HEATMAP_CACHE_LINE_GRANULARITY  (64)
+#define HEATMAP_MAGIC "SYSDARFT-HEAT"
+#define HEATMAP_VERSION (1)
+
+struct SysdarftHeatmapHeader
+{
+    char Magic[16];
+    uint64_t Version;
+    uint64_t Granularity;   // bytes per bucket
+    uint64_t Records;       // SysdarftHeatmapRecord following the header
+};
+
+struct SysdarftHeatmapRecord
+{
+    uint64_t Bucket;
+    uint64_t Reads;
+    uint64_t Writes;
+    uint64_t Fetches;       // instructions fetched from the bucket, a fused cmp and jump counting once
+};
+
+// what the host actually backs guest RAM with
+enum class SysdarftPageBacking { Regular, Transparent, Explicit };
+
+enum class GuestAccessType : uint8_t { Read, Write, Fetch };
 
 class IllegalMemoryAccessException final : public SysdarftBaseError
 {
@@ -64,27 +134,196 @@ public:
 class SYSDARFT_EXPORT_SYMBOL SysdarftCPUMemoryAccess
 {
 public:
+    // host side access, throws IllegalMemoryAccessException when out of bounds.
+    // Safe to use from any thread, a write is seen by the decoded instruction cache
     void read_memory(uint64_t address, char * _dest, uint64_t size);
     void write_memory(uint64_t address, const char* _source, uint64_t size);
 
+    // guest side access, returns SysdarftFaultType::IllegalMemoryAccess when out of bounds
+    [[nodiscard]] SysdarftFaultType try_read_memory(uint64_t address, char * _dest, uint64_t size);
+    [[nodiscard]] SysdarftFaultType try_write_memory(uint64_t address, const char* _source, uint64_t size);
+
+    // guest side block operations done in place on guest RAM, memmove/memset/memcmp/memchr.
+    // offset is where the first difference, or the first byte equal to value, is, size if there is none
+    [[nodiscard]] SysdarftFaultType try_move_memory(uint64_t dest, uint64_t source, uint64_t size);
+    [[nodiscard]] SysdarftFaultType try_fill_memory(uint64_t address, uint8_t value, uint64_t size);
+    [[nodiscard]] SysdarftFaultType try_compare_memory(uint64_t address1, uint64_t address2, uint64_t size,
+        uint64_t & offset) const;
+    [[nodiscard]] SysdarftFaultType try_scan_memory(uint64_t address, uint8_t value, uint64_t size,
+        uint64_t & offset) const;
+
+    // device side direct memory access, a device moving data between its backing store and guest RAM
+    // without staging copies. dma_span() is the host memory of a physical range, empty if it is out of bounds.
+    // A device that wrote through it calls dma_written() afterward, so dirty pages and decoded code see the write
+    [[nodiscard]] std::span < uint8_t > dma_span(uint64_t address, uint64_t size) const;
+    void dma_written(uint64_t address, uint64_t size);
+
+    // guest side fast path for one value, a bounds check and a plain memory access
+    template < typename DataType >
+    [[nodiscard]] SysdarftFaultType try_load_memory(const uint64_t address, DataType & value) const
+    {
+        if (!in_bounds(address, sizeof(DataType))) {
+            return SysdarftFaultType::IllegalMemoryAccess;
+        }
+
+        std::memcpy(&value, Memory + address, sizeof(DataType));
+        return SysdarftFaultType::None;
+    }
+
+    // host memory actually backing guest RAM. RAM is committed on first touch,
+    // so this grows with what the guest uses and not with TotalMemory
+    [[nodiscard]] uint64_t resident_memory() const;
+    [[nodiscard]] SysdarftPageBacking page_backing() const { return PageBacking; }
+    [[nodiscard]] static const char * page_backing_name(SysdarftPageBacking backing);
+
+    // where other local processes can open guest RAM read only and map it, empty unless it is shared.
+    // Byte n of the file is guest physical address n, anything past TotalMemory is not guest RAM
+    [[nodiscard]] std::string shared_memory_path() const;
+
+    [[nodiscard]] bool backed_by_memory_image() const { return MemoryImage != nullptr; }
+
+    // Access heatmap, counting guest accesses per bucket of SysdarftMemoryOptions::HeatmapGranularity bytes.
+    // Only the CPU thread counts, any thread can take a snapshot while it does
+    [[nodiscard]] bool heatmap_enabled() const { return Heatmap != nullptr; }
+    [[nodiscard]] uint64_t heatmap_granularity() const { return HeatmapGranularity; }
+    [[nodiscard]] std::vector < SysdarftHeatmapRecord > heatmap_snapshot() const;
+    void write_heatmap(const std::string & path) const; // heatmap histogram, see SysdarftHeatmapHeader
+
+    // page numbers (address / BLOCK_SIZE) of every 4KB page written since the last call, in ascending order.
+    // Pages are marked after the write, collect with the guest paused for an exact snapshot,
+    // a store racing with a collection may or may not be part of it
+    [[nodiscard]] std::vector < uint64_t > collect_and_clear_dirty();
+
+    template < typename DataType >
+    [[nodiscard]] SysdarftFaultType try_store_memory(const uint64_t address, const DataType & value)
+    {
+        if (!in_bounds(address, sizeof(DataType))) {
+            return SysdarftFaultType::IllegalMemoryAccess;
+        }
+
+        std::memcpy(Memory + address, &value, sizeof(DataType));
+        mark_dirty_pages(address / BLOCK_SIZE, (address + sizeof(DataType) - 1) / BLOCK_SIZE);
+        invalidate_code_blocks(address / BLOCK_SIZE, (address + sizeof(DataType) - 1) / BLOCK_SIZE);
+        return SysdarftFaultType::None;
+    }
+
 protected:
-    std::mutex MemoryAccessMutex;
-    std::vector < std::array < uint8_t, BLOCK_SIZE > > Memory;
+    // Guest RAM, one anonymous mapping of TotalMemory bytes (or a shared memfd mapping, SharedMemoryFd),
+    // reserved without swap accounting and faulted in by the host on first touch.
+    // Startup cost does not depend on TotalMemory.
+    // Accesses take no lock, the guest is only ever run by the CPU thread,
+    // and other threads (GUI, debugger) only look at it
+    // With huge pages the mapping is rounded up to whole 2MB pages, MappedMemory is its real length
+    uint8_t * Memory = nullptr;
     std::atomic<uint64_t> TotalMemory = 0; // 32MB Memory
+    uint64_t MappedMemory = 0;
+    int SharedMemoryFd = -1;
+
+    // memory image header, mapped shared. Only there if SysdarftMemoryOptions::File was given
+    SysdarftMemoryImageHeader * MemoryImage = nullptr;
+    int MemoryImageFd = -1;
 
-    explicit SysdarftCPUMemoryAccess(uint64_t totalMemory);
+    // CPU state saved to the memory image by the last run. Gives it back and drops it from the image,
+    // false if there is none or it is not exactly size bytes
+    bool take_memory_image_state(void * state, uint64_t size);
+    void save_memory_image_state(const void * state, uint64_t size);
+
+    SysdarftPageBacking PageBacking = SysdarftPageBacking::Regular;
+
+    [[nodiscard]] bool in_bounds(const uint64_t address, const uint64_t size) const
+    {
+        const uint64_t total = TotalMemory.load(std::memory_order_relaxed);
+        return size <= total && address <= total - size;
+    }
+
+    // Decoded instruction cache bookkeeping.
+    // A block is marked once the decoder caches code from it, and any write to a marked block
+    // queues that block for invalidation. The decoder drains the queue on the CPU thread.
+    // Only the queue is guarded by MemoryAccessMutex, writes to unmarked blocks take no lock.
+    // Marks are mapped lazily like guest RAM, and accessed through std::atomic_ref
+    std::mutex MemoryAccessMutex;
+    bool * CodeBlockCached = nullptr;
+    uint64_t CodeBlockCount = 0;
+    std::vector < uint64_t > InvalidatedCodeBlocks;
+    std::atomic < bool > CodeBlockInvalidated = false;
+
+    void mark_code_block(uint64_t block);
+    std::vector < uint64_t > pop_invalidated_code_blocks();
+    void queue_invalidated_code_block(uint64_t block);
+
+    void invalidate_code_blocks(const uint64_t first_block, const uint64_t last_block)
+    {
+        for (uint64_t block = first_block; block <= last_block; block++)
+        {
+            if (std::atomic_ref(CodeBlockCached[block]).load(std::memory_order_relaxed)) {
+                queue_invalidated_code_block(block);
+            }
+        }
+    }
+
+    // Dirty page bitmap, one bit per 4KB page, mapped lazily and accessed through std::atomic_ref.
+    // A store only pays for a relaxed load once its page is already dirty,
+    // the atomic or is taken once per page between two collections
+    uint64_t * DirtyPages = nullptr;
+    uint64_t DirtyPageWords = 0;
+
+    void mark_dirty_pages(const uint64_t first_page, const uint64_t last_page)
+    {
+        for (uint64_t page = first_page; page <= last_page; page++)
+        {
+            const std::atomic_ref word(DirtyPages[page / 64]);
+            const uint64_t bit = 1ULL << (page % 64);
+            if (!(word.load(std::memory_order_relaxed) & bit)) {
+                word.fetch_or(bit, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Heatmap buckets, mapped lazily like guest RAM, nullptr unless the heatmap is enabled.
+    // Counters are only ever written by the CPU thread, so they are bumped without a locked add
+    struct HeatmapBucketType { uint64_t Reads, Writes, Fetches; };
+    HeatmapBucketType * Heatmap = nullptr;
+    uint64_t HeatmapGranularity = 0;
+    uint64_t HeatmapBuckets = 0;
+
+    void count_heatmap(uint64_t address, uint64_t size, GuestAccessType Access);
+
+    // count a guest access in the heatmap once it went through, and give back its fault.
+    // Fetches are counted once per instruction by the decoder, not for every byte it reads
+    SysdarftFaultType heatmap_count(const SysdarftFaultType fault, const uint64_t address, const uint64_t size,
+        const GuestAccessType Access)
+    {
+        if (Heatmap != nullptr && fault == SysdarftFaultType::None && Access != GuestAccessType::Fetch) [[unlikely]] {
+            count_heatmap(address, size, Access);
+        }
+
+        return fault;
+    }
+
+    explicit SysdarftCPUMemoryAccess(const SysdarftMemoryOptions & options);
+
+protected:
 
     template < typename DataType >
-    void push_memory_to(const uint64_t begin, uint64_t & offset, const DataType & val)
+    [[nodiscard]] SysdarftFaultType try_push_memory_to(const uint64_t begin, uint64_t & offset, const DataType & val)
     {
         if (offset < sizeof(DataType)) {
-            throw StackOverflow();
+            return SysdarftFaultType::StackOverflow;
+        }
+
+        if (try_store_memory(begin + offset - sizeof(DataType), val) != SysdarftFaultType::None)
+        {
+            return SysdarftFaultType::StackOverflow;
         }
 
         offset -= sizeof(DataType);
-        try {
-            write_memory(begin + offset, (char*)&val, sizeof(DataType));
-        } catch (IllegalMemoryAccessException &) {
+        return SysdarftFaultType::None;
+    }
+
+    template < typename DataType >
+    void push_memory_to(const uint64_t begin, uint64_t & offset, const DataType & val)
+    {
+        if (try_push_memory_to(begin, offset, val) != SysdarftFaultType::None) {
             throw StackOverflow();
         }
     }
@@ -105,18 +344,26 @@ protected:
         push_memory_to<uint64_t>(begin, offset, value);
     }
 
+    template < typename DataType >
+    [[nodiscard]] SysdarftFaultType try_pop_memory_from(const uint64_t begin, uint64_t & offset, DataType & result)
+    {
+        if (try_load_memory(begin + offset, result) != SysdarftFaultType::None) {
+            return SysdarftFaultType::StackOverflow;
+        }
+
+        offset += sizeof(DataType);
+        return SysdarftFaultType::None;
+    }
+
     template < typename DataType >
     DataType pop_memory_from(const uint64_t begin, uint64_t & offset)
     {
         DataType result;
 
-        try {
-            read_memory(begin + offset, (char*)&result, sizeof(DataType));
-        } catch (IllegalMemoryAccessException &) {
+        if (try_pop_memory_from(begin, offset, result) != SysdarftFaultType::None) {
             throw StackOverflow();
         }
 
-        offset += sizeof(DataType);
         return result;
     }
 
@@ -137,8 +384,9 @@ protected:
     }
 
 public:
-    virtual ~SysdarftCPUMemoryAccess() = default;
-    SysdarftCPUMemoryAccess operator=(const SysdarftCPUMemoryAccess&) = delete;
+    virtual ~SysdarftCPUMemoryAccess();
+    SysdarftCPUMemoryAccess(const SysdarftCPUMemoryAccess&) = delete;
+    SysdarftCPUMemoryAccess & operator=(const SysdarftCPUMemoryAccess&) = delete;
 };
 
 #endif //SYSDARFTMEMORY_H
@@ -0,0 +1,273 @@
+/* SysdarftPaging.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef SYSDARFTPAGING_H
+#define SYSDARFTPAGING_H
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <SysdarftCursesUI.h>
+#include <SysdarftFault.h>
+#include <SysdarftMemory.h>
+#include <SysdarftRegister.h>
+
+/*
+ * Paging:
+ * A guest page is 4KB, same as a code block. The page table is one linear array of 64bit entries
+ * in physical memory, starting at SelectorSpaceStart and holding SelectorSPaceSize entries.
+ * Entry n maps linear page n, linear pages past the end of the table are not mapped.
+ *
+ * Page table entry:
+ *  [0]     Present
+ *  [1]     Writable
+ *  [2]     User, accessible from user mode (CurrentPrivilegeLevel == 2) in protected mode
+ *  [12-63] Physical address of the page
+ *
+ * Translations are cached in a direct-mapped TLB. Like the page table itself the TLB is
+ * guest managed, the guest flushes it after changing a page table entry (TLBFL, INVLPG).
+ * Loading the page table (LPT), switching paging on and off (ENPG, DSPG), and any other
+ * change to either of them (POPALL, IRET) flush it by themselves.
+ */
+#define GUEST_PAGE_SIZE     BLOCK_SIZE
+#define PAGE_PRESENT        (0x01)
+#define PAGE_WRITABLE       (0x02)
+#define PAGE_USER           (0x04)
+#define PAGE_ADDRESS_MASK   (~static_cast<uint64_t>(GUEST_PAGE_SIZE - 1))
+
+#define REAL_MODE_PRIVILEGE_LEVEL   (0)
+#define KERNEL_PRIVILEGE_LEVEL      (1)
+#define USER_PRIVILEGE_LEVEL        (2)
+#define HYPERVISOR_PRIVILEGE_LEVEL  (3)
+
+class SYSDARFT_EXPORT_SYMBOL SysdarftCPUPaging
+    : public SysdarftRegister,
+      public SysdarftCursesUI
+{
+private:
+    static constexpr uint64_t TLB_ENTRIES = 256;
+    static constexpr uint64_t TLB_INVALID_PAGE = UINT64_MAX; // page numbers never get this large
+
+    struct TLBEntryType {
+        uint64_t LinearPage = TLB_INVALID_PAGE;
+        uint64_t PhysicalAddress = 0;
+        uint8_t Permissions = 0; // PAGE_WRITABLE and PAGE_USER of the page table entry
+    };
+
+    std::array < TLBEntryType, TLB_ENTRIES > TLB { };
+
+    // counters are only ever written by the CPU thread, so they are bumped without a locked add
+    static void count(std::atomic < uint64_t > & counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool access_permitted(const uint8_t Permissions, const GuestAccessType Access) const
+    {
+        if (Access == GuestAccessType::Write && !(Permissions & PAGE_WRITABLE)) {
+            return false;
+        }
+
+        return !user_mode() || (Permissions & PAGE_USER);
+    }
+
+    SysdarftFaultType page_fault(uint64_t linear_address);
+    SysdarftFaultType walk_page_table(uint64_t linear_address, GuestAccessType Access, uint64_t & physical_address);
+
+    // translate every page of a range, so a fault halfway through a block operation leaves memory untouched
+    SysdarftFaultType probe_linear(uint64_t address, uint64_t size, GuestAccessType Access);
+
+    // heatmap_count() for block operations, comparing and scanning count what was looked at
+    SysdarftFaultType count_move(const SysdarftFaultType fault, const uint64_t dest, const uint64_t source,
+        const uint64_t size)
+    {
+        return heatmap_count(heatmap_count(fault, source, size, GuestAccessType::Read),
+            dest, size, GuestAccessType::Write);
+    }
+
+    SysdarftFaultType count_compare(const SysdarftFaultType fault, const uint64_t address1, const uint64_t address2,
+        const uint64_t size, const uint64_t offset)
+    {
+        if (fault != SysdarftFaultType::None) {
+            return fault;
+        }
+
+        const uint64_t compared = std::min(offset + 1, size);
+        return heatmap_count(heatmap_count(fault, address1, compared, GuestAccessType::Read),
+            address2, compared, GuestAccessType::Read);
+    }
+
+    SysdarftFaultType count_scan(const SysdarftFaultType fault, const uint64_t address, const uint64_t size,
+        const uint64_t offset)
+    {
+        if (fault != SysdarftFaultType::None) {
+            return fault;
+        }
+
+        return heatmap_count(fault, address, std::min(offset + 1, size), GuestAccessType::Read);
+    }
+
+protected:
+    explicit SysdarftCPUPaging(const SysdarftMemoryOptions & memory, const std::string & font_name)
+        : SysdarftCursesUI(memory, font_name) { }
+
+    [[nodiscard]] bool paging_enabled() const { return Registers.FlagRegister.PagingEnabled; }
+
+    [[nodiscard]] bool user_mode() const
+    {
+        return Registers.FlagRegister.ProtectedModeEnabled
+            && Registers.FlagRegister.CurrentPrivilegeLevel == USER_PRIVILEGE_LEVEL;
+    }
+
+    // linear to physical address. Flat if paging is disabled, SysdarftFaultType::PageFault if not mapped
+    [[nodiscard]] SysdarftFaultType translate(const uint64_t linear_address, const GuestAccessType Access,
+        uint64_t & physical_address)
+    {
+        if (!paging_enabled()) {
+            physical_address = linear_address;
+            return SysdarftFaultType::None;
+        }
+
+        const uint64_t page = linear_address / GUEST_PAGE_SIZE;
+        if (const auto & entry = TLB[page % TLB_ENTRIES]; entry.LinearPage == page) [[likely]]
+        {
+            count(TLBHits);
+            if (!access_permitted(entry.Permissions, Access)) {
+                return page_fault(linear_address);
+            }
+
+            physical_address = entry.PhysicalAddress + linear_address % GUEST_PAGE_SIZE;
+            return SysdarftFaultType::None;
+        }
+
+        return walk_page_table(linear_address, Access, physical_address);
+    }
+
+    void flush_tlb();
+    void flush_tlb_entry(uint64_t linear_address);
+
+    // called once paging is enabled or the page table in use is replaced,
+    // for anything beyond the TLB that caches what translation used to give
+    virtual void translation_changed() { }
+
+    // put back what user mode is not allowed to change after Registers were restored from guest memory,
+    // and flush the TLB if paging changed. Previous is the register file before they were restored
+    void restore_privileged_state(const sysdarft_register_t & Previous);
+
+    /*
+     * Guest side access by linear address, the counterpart of SysdarftCPUMemoryAccess::try_*_memory.
+     * A value within one page takes one translation, anything crossing a page boundary
+     * is translated page by page, and nothing is written unless every page is accessible
+     */
+    [[nodiscard]] SysdarftFaultType try_read_linear(uint64_t address, char * _dest, uint64_t size,
+        GuestAccessType Access = GuestAccessType::Read);
+    [[nodiscard]] SysdarftFaultType try_write_linear(uint64_t address, const char * _source, uint64_t size);
+
+    // block operations by linear address done in place on guest RAM, see SysdarftCPUMemoryAccess::try_move_memory().
+    // Moving overlapping ranges behaves like memmove(), nothing is written unless every page is accessible,
+    // and comparing or scanning stops at the first page fault past the last byte looked at
+    [[nodiscard]] SysdarftFaultType try_move_linear(uint64_t dest, uint64_t source, uint64_t size);
+    [[nodiscard]] SysdarftFaultType try_fill_linear(uint64_t address, uint8_t value, uint64_t size);
+    [[nodiscard]] SysdarftFaultType try_compare_linear(uint64_t address1, uint64_t address2, uint64_t size,
+        uint64_t & offset);
+    [[nodiscard]] SysdarftFaultType try_scan_linear(uint64_t address, uint8_t value, uint64_t size,
+        uint64_t & offset);
+
+    template < typename DataType >
+    [[nodiscard]] SysdarftFaultType try_load_linear(const uint64_t address, DataType & value,
+        const GuestAccessType Access = GuestAccessType::Read)
+    {
+        if (!paging_enabled()) [[likely]] {
+            return heatmap_count(try_load_memory(address, value), address, sizeof(DataType), Access);
+        }
+
+        if (address % GUEST_PAGE_SIZE + sizeof(DataType) > GUEST_PAGE_SIZE) {
+            return try_read_linear(address, reinterpret_cast<char*>(&value), sizeof(DataType), Access);
+        }
+
+        uint64_t physical_address;
+        if (const auto fault = translate(address, Access, physical_address); fault != SysdarftFaultType::None) {
+            return fault;
+        }
+
+        return heatmap_count(try_load_memory(physical_address, value), physical_address, sizeof(DataType), Access);
+    }
+
+    template < typename DataType >
+    [[nodiscard]] SysdarftFaultType try_store_linear(const uint64_t address, const DataType & value)
+    {
+        if (!paging_enabled()) [[likely]] {
+            return heatmap_count(try_store_memory(address, value), address, sizeof(DataType), GuestAccessType::Write);
+        }
+
+        if (address % GUEST_PAGE_SIZE + sizeof(DataType) > GUEST_PAGE_SIZE) {
+            return try_write_linear(address, reinterpret_cast<const char*>(&value), sizeof(DataType));
+        }
+
+        uint64_t physical_address;
+        if (const auto fault = translate(address, GuestAccessType::Write, physical_address);
+            fault != SysdarftFaultType::None)
+        {
+            return fault;
+        }
+
+        return heatmap_count(try_store_memory(physical_address, value), physical_address, sizeof(DataType),
+            GuestAccessType::Write);
+    }
+
+    // stack style access, see SysdarftCPUMemoryAccess::try_push_memory_to().
+    // Anything but a page fault is reported as a stack overflow
+    template < typename DataType >
+    [[nodiscard]] SysdarftFaultType try_push_linear_to(const uint64_t begin, uint64_t & offset, const DataType & val)
+    {
+        if (offset < sizeof(DataType)) {
+            return SysdarftFaultType::StackOverflow;
+        }
+
+        if (const auto fault = try_store_linear(begin + offset - sizeof(DataType), val);
+            fault != SysdarftFaultType::None)
+        {
+            return fault == SysdarftFaultType::PageFault ? fault : SysdarftFaultType::StackOverflow;
+        }
+
+        offset -= sizeof(DataType);
+        return SysdarftFaultType::None;
+    }
+
+    template < typename DataType >
+    [[nodiscard]] SysdarftFaultType try_pop_linear_from(const uint64_t begin, uint64_t & offset, DataType & result,
+        const GuestAccessType Access = GuestAccessType::Read)
+    {
+        if (const auto fault = try_load_linear(begin + offset, result, Access);
+            fault != SysdarftFaultType::None)
+        {
+            return fault == SysdarftFaultType::PageFault ? fault : SysdarftFaultType::StackOverflow;
+        }
+
+        offset += sizeof(DataType);
+        return SysdarftFaultType::None;
+    }
+
+public:
+    std::atomic < uint64_t > TLBHits = 0;
+    std::atomic < uint64_t > TLBMisses = 0;
+    std::atomic < uint64_t > TLBFlushes = 0;
+};
+
+#endif //SYSDARFTPAGING_H
@@ -21,7 +21,11 @@
 #ifndef REGISTER_DEF_H
 #define REGISTER_DEF_H
 
+#include <bit>
 #include <cstdint>
+#include <cstring>
+#include <array>
+#include <atomic>
 #include <SysdarftDebug.h>
 #include <SysdarftMemory.h>
 
@@ -103,7 +107,6 @@ struct alignas(16) sysdarft_register_t
         uint64_t LessThan: 1;
         uint64_t Equal: 1;
         uint64_t InterruptionMask : 1;
-        // unused:
         uint64_t CurrentPrivilegeLevel:2; // 0 == Real Mode Level, 1 == Protected Kernel Level, 2 == User Mode Level, 3 == Hypervisor Level
         uint64_t ProtectedModeEnabled:1;
         uint64_t PagingEnabled:1;
@@ -121,9 +124,9 @@ struct alignas(16) sysdarft_register_t
     uint64_t CurrentProcedureStackPreservationSpace;
 
     struct {
-        uint64_t SelectorSpaceStart;
-        uint64_t SelectorSPaceSize;
-        uint64_t R_reserved1;
+        uint64_t SelectorSpaceStart;    // physical address of the page table, see SysdarftPaging.h
+        uint64_t SelectorSPaceSize;     // page table entries
+        uint64_t PageFaultAddress;      // linear address of the last page fault
         uint64_t R_reserved2;
         uint64_t R_reserved3;
         uint64_t R_reserved4;
@@ -243,9 +246,86 @@ protected:
     sysdarft_register_t Registers { };
     // in any case, Registers should only be exposed to **ONE AND ONLY ONE** thread.
     // that means no hyper-thread in this CPU (for now?)
-    std::mutex RegisterModificationMutex;
+    // Registers are owned by the execution thread and are accessed without locking.
+    // Other threads read them through SysdarftRegisterSnapshot.
+
+    // Flag effect of the last ALU operation.
+    // It is folded into FlagRegister when FlagRegister is read, and dropped when FlagRegister is written,
+    // so arithmetic that is never followed by a flag reader never touches FlagRegister at all.
+    // Registers.FlagRegister is only up to date after commit_flags()
+    struct LazyFlagsType
+    {
+        enum OperationType : uint8_t {
+            Materialized,   // Registers.FlagRegister is up to date
+            Unsigned,       // check_overflow(): Carry if Result does not fit in Mask
+            Signed,         // check_overflow_signed(): Overflow if Result does not fit in Mask as signed
+            Comparison,     // cmp(): LargerThan, LessThan and Equal from Operand1 against Operand2
+        } Operation = Materialized;
+
+        uint64_t Mask = 0;
+        __uint128_t Result = 0;
+        uint64_t Operand1 = 0;
+        uint64_t Operand2 = 0;
+    } LazyFlags;
+
+    [[nodiscard]] decltype(sysdarft_register_t::FlagRegister) folded_flags() const
+    {
+        auto FG = Registers.FlagRegister;
+        switch (LazyFlags.Operation)
+        {
+        case LazyFlagsType::Materialized:
+            return FG;
+        case LazyFlagsType::Unsigned:
+            FG.Carry = (LazyFlags.Result & LazyFlags.Mask) != LazyFlags.Result;
+            FG.Overflow = 0;
+            break;
+        case LazyFlagsType::Signed: {
+            // the value is taken as a 64bit signed integer, and checked against the signed range of the width
+            const __int128_t value = static_cast<int64_t>(static_cast<uint64_t>(LazyFlags.Result));
+            const __int128_t max = LazyFlags.Mask >> 1;
+            FG.Carry = 0;
+            FG.Overflow = value > max || value < -max - 1;
+            break;
+        }
+        case LazyFlagsType::Comparison:
+            // Carry and Overflow are left as they were
+            FG.LargerThan = LazyFlags.Operand1 > LazyFlags.Operand2;
+            FG.LessThan = LazyFlags.Operand1 < LazyFlags.Operand2;
+            FG.Equal = LazyFlags.Operand1 == LazyFlags.Operand2;
+            return FG;
+        }
+
+        FG.Equal = 0;
+        FG.LargerThan = 0;
+        FG.LessThan = 0;
+        return FG;
+    }
+
+    // record the flag effect of an arithmetic result, Mask being the operation width
+    void defer_flags(const LazyFlagsType::OperationType Operation, const uint64_t Mask, const __uint128_t Result)
+    {
+        LazyFlags.Operation = Operation;
+        LazyFlags.Mask = Mask;
+        LazyFlags.Result = Result;
+    }
+
+    // record the flag effect of a comparison, which keeps Carry and Overflow of the operation before it
+    void defer_comparison_flags(const uint64_t Operand1, const uint64_t Operand2)
+    {
+        commit_flags();
+        LazyFlags.Operation = LazyFlagsType::Comparison;
+        LazyFlags.Operand1 = Operand1;
+        LazyFlags.Operand2 = Operand2;
+    }
 
 public:
+    // fold the pending flag effect into Registers.FlagRegister, for code accessing Registers directly
+    void commit_flags()
+    {
+        Registers.FlagRegister = folded_flags();
+        LazyFlags.Operation = LazyFlagsType::Materialized;
+    }
+
     template < typename AccessRegisterType, unsigned AccessRegisterIndex = 0 >
     requires std::is_same_v<AccessRegisterType, FullyExtendedRegisterType>
     || std::is_same_v<AccessRegisterType, HalfExtendedRegisterType>
@@ -264,21 +344,16 @@ public:
     || std::is_same_v<AccessRegisterType, ExtendedPointerType>
     || std::is_same_v<AccessRegisterType, WholeRegisterType>
     || std::is_same_v<AccessRegisterType, CurrentProcedureStackPreservationSpaceType>
-    typename RegisterTypeIdentifier < AccessRegisterType >::type load()
+    typename RegisterTypeIdentifier < AccessRegisterType >::type load() const
     {
-        std::lock_guard<std::mutex> lock(RegisterModificationMutex);
         if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 0) {
-            auto FER0 = Registers.FullyExtendedRegister0;
-            return *(uint64_t*)(&FER0);
+            return std::bit_cast<uint64_t>(Registers.FullyExtendedRegister0);
         } else if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 1) {
-            auto FER1 = Registers.FullyExtendedRegister1;
-            return *(uint64_t*)(&FER1);
+            return std::bit_cast<uint64_t>(Registers.FullyExtendedRegister1);
         } else if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 2) {
-            auto FER2 = Registers.FullyExtendedRegister2;
-            return *(uint64_t*)(&FER2);
+            return std::bit_cast<uint64_t>(Registers.FullyExtendedRegister2);
         } else if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 3) {
-            auto FER3 = Registers.FullyExtendedRegister3;
-            return *(uint64_t*)(&FER3);
+            return std::bit_cast<uint64_t>(Registers.FullyExtendedRegister3);
         } else if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 4) {
             return Registers.FullyExtendedRegister4;
         } else if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 5) {
@@ -306,17 +381,13 @@ public:
         }
         ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
         else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 0) {
-            auto HER0 = Registers.FullyExtendedRegister0.HalfExtendedRegister0;
-            return *(uint32_t*)(&HER0);
+            return std::bit_cast<uint32_t>(Registers.FullyExtendedRegister0.HalfExtendedRegister0);
         } else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 1) {
-            auto HER1 = Registers.FullyExtendedRegister0.HalfExtendedRegister1;
-            return *(uint32_t*)(&HER1);
+            return std::bit_cast<uint32_t>(Registers.FullyExtendedRegister0.HalfExtendedRegister1);
         } else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 2) {
-            auto HER2 = Registers.FullyExtendedRegister1.HalfExtendedRegister2;
-            return *(uint32_t*)(&HER2);
+            return std::bit_cast<uint32_t>(Registers.FullyExtendedRegister1.HalfExtendedRegister2);
         } else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 3) {
-            auto HER3 = Registers.FullyExtendedRegister1.HalfExtendedRegister3;
-            return *(uint32_t*)(&HER3);
+            return std::bit_cast<uint32_t>(Registers.FullyExtendedRegister1.HalfExtendedRegister3);
         } else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 4) {
             return Registers.FullyExtendedRegister2.HalfExtendedRegister4;
         } else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 5) {
@@ -328,17 +399,13 @@ public:
         }
         ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
         else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 0) {
-            auto EXR0 = Registers.FullyExtendedRegister0.HalfExtendedRegister0.ExtendedRegister0;
-            return *(uint16_t*)(&EXR0);
+            return std::bit_cast<uint16_t>(Registers.FullyExtendedRegister0.HalfExtendedRegister0.ExtendedRegister0);
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 1) {
-            auto EXR1 = Registers.FullyExtendedRegister0.HalfExtendedRegister0.ExtendedRegister1;
-            return *(uint16_t*)(&EXR1);
+            return std::bit_cast<uint16_t>(Registers.FullyExtendedRegister0.HalfExtendedRegister0.ExtendedRegister1);
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 2) {
-            auto EXR2 = Registers.FullyExtendedRegister0.HalfExtendedRegister1.ExtendedRegister2;
-            return *(uint16_t*)(&EXR2);
+            return std::bit_cast<uint16_t>(Registers.FullyExtendedRegister0.HalfExtendedRegister1.ExtendedRegister2);
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 3) {
-            auto EXR3 = Registers.FullyExtendedRegister0.HalfExtendedRegister1.ExtendedRegister3;
-            return *(uint16_t*)(&EXR3);
+            return std::bit_cast<uint16_t>(Registers.FullyExtendedRegister0.HalfExtendedRegister1.ExtendedRegister3);
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 4) {
             return Registers.FullyExtendedRegister1.HalfExtendedRegister2.ExtendedRegister4;
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 5) {
@@ -374,7 +441,7 @@ public:
         }
         ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
         else if constexpr (std::is_same_v<AccessRegisterType, FlagRegisterType>) {
-            return Registers.FlagRegister;
+            return folded_flags();
         } else if constexpr (std::is_same_v<AccessRegisterType, StackBaseType>) {
             return Registers.StackBase;
         } else if constexpr (std::is_same_v<AccessRegisterType, StackPointerType>) {
@@ -392,7 +459,9 @@ public:
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedPointerType>) {
             return Registers.ExtendedPointer;
         } else if constexpr (std::is_same_v<AccessRegisterType, WholeRegisterType>) {
-            return Registers;
+            auto WholeRegister = Registers;
+            WholeRegister.FlagRegister = folded_flags();
+            return WholeRegister;
         } else if constexpr (std::is_same_v<AccessRegisterType, CurrentProcedureStackPreservationSpaceType>) {
             return Registers.CurrentProcedureStackPreservationSpace;
         } else {
@@ -425,15 +494,14 @@ public:
     || std::is_same_v<AccessRegisterType, CurrentProcedureStackPreservationSpaceType>
     void store(const typename RegisterTypeIdentifier < AccessRegisterType >::type Reg)
     {
-        std::lock_guard<std::mutex> lock(RegisterModificationMutex);
         if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 0) {
-            *(uint64_t*)&Registers.FullyExtendedRegister0 = Reg;
+            Registers.FullyExtendedRegister0 = std::bit_cast<decltype(Registers.FullyExtendedRegister0)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 1) {
-            *(uint64_t*)&Registers.FullyExtendedRegister1 = Reg;
+            Registers.FullyExtendedRegister1 = std::bit_cast<decltype(Registers.FullyExtendedRegister1)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 2) {
-            *(uint64_t*)&Registers.FullyExtendedRegister2 = Reg;
+            Registers.FullyExtendedRegister2 = std::bit_cast<decltype(Registers.FullyExtendedRegister2)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 3) {
-            *(uint64_t*)&Registers.FullyExtendedRegister3 = Reg;
+            Registers.FullyExtendedRegister3 = std::bit_cast<decltype(Registers.FullyExtendedRegister3)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 4) {
             Registers.FullyExtendedRegister4 = Reg;
         } else if constexpr (std::is_same_v<AccessRegisterType, FullyExtendedRegisterType> && AccessRegisterIndex == 5) {
@@ -461,13 +529,13 @@ public:
         }
         ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
         else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 0) {
-            *(uint32_t*)&Registers.FullyExtendedRegister0.HalfExtendedRegister0 = Reg;
+            Registers.FullyExtendedRegister0.HalfExtendedRegister0 = std::bit_cast<decltype(Registers.FullyExtendedRegister0.HalfExtendedRegister0)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 1) {
-            *(uint32_t*)&Registers.FullyExtendedRegister0.HalfExtendedRegister1 = Reg;;
+            Registers.FullyExtendedRegister0.HalfExtendedRegister1 = std::bit_cast<decltype(Registers.FullyExtendedRegister0.HalfExtendedRegister1)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 2) {
-            *(uint32_t*)&Registers.FullyExtendedRegister1.HalfExtendedRegister2 = Reg;;
+            Registers.FullyExtendedRegister1.HalfExtendedRegister2 = std::bit_cast<decltype(Registers.FullyExtendedRegister1.HalfExtendedRegister2)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 3) {
-            *(uint32_t*)&Registers.FullyExtendedRegister1.HalfExtendedRegister3 = Reg;;
+            Registers.FullyExtendedRegister1.HalfExtendedRegister3 = std::bit_cast<decltype(Registers.FullyExtendedRegister1.HalfExtendedRegister3)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 4) {
             Registers.FullyExtendedRegister2.HalfExtendedRegister4 = Reg;
         } else if constexpr (std::is_same_v<AccessRegisterType, HalfExtendedRegisterType> && AccessRegisterIndex == 5) {
@@ -479,13 +547,13 @@ public:
         }
         ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
         else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 0) {
-            *(uint16_t*)&Registers.FullyExtendedRegister0.HalfExtendedRegister0.ExtendedRegister0 = Reg;
+            Registers.FullyExtendedRegister0.HalfExtendedRegister0.ExtendedRegister0 = std::bit_cast<decltype(Registers.FullyExtendedRegister0.HalfExtendedRegister0.ExtendedRegister0)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 1) {
-            *(uint16_t*)&Registers.FullyExtendedRegister0.HalfExtendedRegister0.ExtendedRegister1 = Reg;
+            Registers.FullyExtendedRegister0.HalfExtendedRegister0.ExtendedRegister1 = std::bit_cast<decltype(Registers.FullyExtendedRegister0.HalfExtendedRegister0.ExtendedRegister1)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 2) {
-            *(uint16_t*)&Registers.FullyExtendedRegister0.HalfExtendedRegister1.ExtendedRegister2 = Reg;
+            Registers.FullyExtendedRegister0.HalfExtendedRegister1.ExtendedRegister2 = std::bit_cast<decltype(Registers.FullyExtendedRegister0.HalfExtendedRegister1.ExtendedRegister2)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 3) {
-            *(uint16_t*)&Registers.FullyExtendedRegister0.HalfExtendedRegister1.ExtendedRegister3 = Reg;
+            Registers.FullyExtendedRegister0.HalfExtendedRegister1.ExtendedRegister3 = std::bit_cast<decltype(Registers.FullyExtendedRegister0.HalfExtendedRegister1.ExtendedRegister3)>(Reg);
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 4) {
             Registers.FullyExtendedRegister1.HalfExtendedRegister2.ExtendedRegister4 = Reg;
         } else if constexpr (std::is_same_v<AccessRegisterType, ExtendedRegisterType> && AccessRegisterIndex == 5) {
@@ -522,6 +590,7 @@ public:
         ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
         else if constexpr (std::is_same_v<AccessRegisterType, FlagRegisterType>) {
             Registers.FlagRegister = Reg;
+            LazyFlags.Operation = LazyFlagsType::Materialized;
         } else if constexpr (std::is_same_v<AccessRegisterType, StackBaseType>) {
             Registers.StackBase = Reg;
         } else if constexpr (std::is_same_v<AccessRegisterType, StackPointerType>) {
@@ -540,6 +609,7 @@ public:
             Registers.ExtendedPointer = Reg;
         } else if constexpr (std::is_same_v<AccessRegisterType, WholeRegisterType>) {
             Registers = Reg;
+            LazyFlags.Operation = LazyFlagsType::Materialized;
         } else if constexpr (std::is_same_v<AccessRegisterType, CurrentProcedureStackPreservationSpaceType>) {
             Registers.CurrentProcedureStackPreservationSpace = Reg;
         } else {
@@ -559,8 +629,60 @@ protected:
     }
 
 public:
+    explicit SysdarftRegister(const sysdarft_register_t & Registers_) : Registers(Registers_) { }
     virtual ~SysdarftRegister() = default;
+    SysdarftRegister(const SysdarftRegister & other) = default;
     SysdarftRegister & operator=(const SysdarftRegister & other) = delete;
 };
 
+// Seqlock protected copy of the register file.
+// The execution thread publishes it at instruction boundaries,
+// and observers (i.e., the debugger) read a consistent copy of it from any thread.
+class SysdarftRegisterSnapshot
+{
+private:
+    static_assert(sizeof(sysdarft_register_t) % sizeof(uint64_t) == 0);
+    static constexpr uint64_t WordCount = sizeof(sysdarft_register_t) / sizeof(uint64_t);
+
+    std::atomic < uint64_t > Sequence = 0; // odd while a publication is in progress
+    std::array < std::atomic < uint64_t >, WordCount > Words { };
+
+public:
+    // execution thread only
+    void publish(const sysdarft_register_t & Registers)
+    {
+        uint64_t buffer[WordCount];
+        std::memcpy(buffer, &Registers, sizeof(buffer));
+
+        const auto sequence = Sequence.load(std::memory_order_relaxed);
+        Sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (uint64_t i = 0; i < WordCount; i++) {
+            Words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+
+        Sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    [[nodiscard]] SysdarftRegister read() const
+    {
+        uint64_t buffer[WordCount];
+        uint64_t before, after;
+
+        do {
+            before = Sequence.load(std::memory_order_acquire);
+            for (uint64_t i = 0; i < WordCount; i++) {
+                buffer[i] = Words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = Sequence.load(std::memory_order_relaxed);
+        } while (before != after || (before & 1) != 0);
+
+        sysdarft_register_t Registers;
+        std::memcpy(&Registers, buffer, sizeof(buffer));
+        return SysdarftRegister(Registers);
+    }
+};
+
 #endif //REGISTER_DEF_H
@@ -0,0 +1,81 @@
+; block_memory.asm
+;
+; Copyright 2025 Anivice Ives
+;
+; This program is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program.  If not, see <https://www.gnu.org/licenses/>.
+;
+; SPDX-License-Identifier: GPL-3.0-or-later
+;
+
+; Block memory instructions, fills a buffer with stos, copies a string over its start
+; with movs, compares the two with cmps and looks for the end of the string with scas.
+; Results are left in _results: mismatch offset, then string length
+
+.org 0xC1800
+
+jmp                     <%cb>,                                          <_start>
+
+_start:
+    mov .64bit          <%sb>,                                          <_stack_frame>
+    mov .64bit          <%sp>,                                          <$64(0xFFF)>
+    mov .64bit          <%fer1>,                                        <_results>
+
+    ; fill the buffer with 'A'
+    mov .64bit          <%db>,                                          <_buffer>
+    xor .64bit          <%dp>,                                          <%dp>
+    mov .64bit          <%fer3>,                                        <$64(64)>
+    stos .8bit          <$8(0x41)>
+
+    ; copy the string, NUL included, over the start of the buffer
+    mov .64bit          <%eb>,                                          <_string>
+    xor .64bit          <%ep>,                                          <%ep>
+    mov .64bit          <%fer3>,                                        <$64(14)>
+    movs
+
+    ; the buffer matches the string, and differs right past it
+    mov .64bit          <%fer3>,                                        <$64(14)>
+    cmps
+    jne                 <%cb>,                                          <_failed>
+
+    mov .64bit          <%fer3>,                                        <$64(15)>
+    cmps
+    je                  <%cb>,                                          <_failed>
+    mov .64bit          <*1&64(%fer1, $8(0), $8(0))>,                   <%fer3>
+
+    ; string length, offset of the NUL
+    mov .64bit          <%fer3>,                                        <$64(64)>
+    xor .8bit           <%r0>,                                          <%r0>
+    scas .8bit          <%r0>
+    jne                 <%cb>,                                          <_failed>
+    mov .64bit          <*1&64(%fer1, $8(8), $8(0))>,                   <%fer3>
+
+    hlt
+
+_failed:
+    mov .64bit          <*1&64(%fer1, $8(0), $8(0))>,                   <$64(0xFFFFFFFFFFFFFFFF)>
+    hlt
+
+_string:
+    .string < "Hello, World!" >
+    .8bit_data < 0 >
+
+_results:
+    .64bit_data < 0 >
+    .64bit_data < 0 >
+
+_buffer:
+    .resvb < 64 >
+
+_stack_frame:
+    .resvb < 0xFFF >
@@ -0,0 +1,62 @@
+; disk_stream.asm
+;
+; Copyright 2025 Anivice Ives
+;
+; This program is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program.  If not, see <https://www.gnu.org/licenses/>.
+;
+; SPDX-License-Identifier: GPL-3.0-or-later
+;
+
+; Disk streaming benchmark, reads the first 4MB of the hard disk through ins 64 times over,
+; 256MB in all, into guest memory at 0x100000. Needs a hard disk of 4MB or more:
+;   truncate -s 4M stream.img
+;   time sysdarft-system --bios disk_stream.bin --hdd stream.img --boot --no-curses
+; Seconds spent reading, by the real time clock, are left in %FER0 once it halts
+
+.equ 'HDD_START_SEC',   '0x137'
+.equ 'HDD_SEC_COUNT',   '0x138'
+.equ 'HDD_REQUEST_RD',  '0x139'
+.equ 'RTC_TIME',        '0x70'
+.equ 'SECTORS',         '8192'
+.equ 'ROUNDS',          '64'
+
+.org 0xC1800
+
+jmp                     <%cb>,                                          <_start>
+
+_start:
+    mov .64bit          <%sb>,                                          <_stack_frame>
+    mov .64bit          <%sp>,                                          <$64(0xFFF)>
+
+    in .64bit           <$64(RTC_TIME)>,                                <%fer2>
+
+    mov .64bit          <%fer3>,                                        <$64(ROUNDS)>
+
+_round:
+    push .64bit         <%fer3>
+    out .64bit          <$64(HDD_START_SEC)>,                           <$64(0)>
+    out .64bit          <$64(HDD_SEC_COUNT)>,                           <$64(SECTORS)>
+    mov .64bit          <%db>,                                          <$64(0x100000)>
+    xor .64bit          <%dp>,                                          <%dp>
+    mov .64bit          <%fer3>,                                        <$64(SECTORS * 512)>
+    ins .64bit          <$64(HDD_REQUEST_RD)>
+    pop .64bit          <%fer3>
+    loop                <%cb>,                                          <_round>
+
+    in .64bit           <$64(RTC_TIME)>,                                <%fer0>
+    sub .64bit          <%fer0>,                                        <%fer2>
+    hlt
+
+_stack_frame:
+    .resvb < 0xFFF >
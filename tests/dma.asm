@@ -0,0 +1,90 @@
+; dma.asm
+;
+; Copyright 2025 Anivice Ives
+;
+; This program is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program.  If not, see <https://www.gnu.org/licenses/>.
+;
+; SPDX-License-Identifier: GPL-3.0-or-later
+;
+
+; DMA controller, reads the first 4MB of the hard disk into guest memory at 0x100000 with one asynchronous
+; command, counting while it is in progress, then writes it back right behind itself, sectors 8192 onward,
+; with a synchronous one, and flushes the disk. Needs a hard disk of 8MB or more:
+;   truncate -s 8M dma.img
+;   sysdarft-system --bios dma.bin --hdd dma.img --disk-cache writeback --boot --no-curses
+; The completion handler counts finished transfers in memory, since iret restores every register.
+; Completions are left in %FER0, and the count reached while reading in %FER2, once it halts
+
+.equ 'DMA_DEVICE',      '0x140'
+.equ 'DMA_START_SEC',   '0x141'
+.equ 'DMA_SEC_COUNT',   '0x142'
+.equ 'DMA_ADDRESS',     '0x143'
+.equ 'DMA_INT',         '0x144'
+.equ 'DMA_READ',        '0x145'
+.equ 'DMA_WRITE',       '0x146'
+.equ 'DMA_MODE',        '0x147'
+.equ 'DMA_STATUS',      '0x148'
+.equ 'HDD_FLUSH',       '0x13B'
+.equ 'SECTORS',         '8192'
+
+.org 0xC1800
+
+jmp                     <%cb>,                                          <_start>
+
+_dma_done:
+    mov .64bit          <%fer1>,                                        <_completions>
+    inc .64bit          <*1&64(%fer1, $8(0), $8(0))>
+    iret
+
+_start:
+    mov .64bit          <%sb>,                                          <_stack_frame>
+    mov .64bit          <%sp>,                                          <$64(0xFFF)>
+
+    mov .64bit          <*1&64($32(0xA0000), $16(16 * 0x81), $8(8))>,   <_dma_done>
+
+    out .64bit          <$64(DMA_DEVICE)>,                              <$64(0)>
+    out .64bit          <$64(DMA_INT)>,                                 <$64(0x81)>
+    out .64bit          <$64(DMA_ADDRESS)>,                             <$64(0x100000)>
+    out .64bit          <$64(DMA_SEC_COUNT)>,                           <$64(SECTORS)>
+
+    out .64bit          <$64(DMA_MODE)>,                                <$64(1)>
+    out .64bit          <$64(DMA_START_SEC)>,                           <$64(0)>
+    out .64bit          <$64(DMA_READ)>,                                <$64(0)>
+
+    xor .64bit          <%fer2>,                                        <%fer2>
+_reading:
+    inc .64bit          <%fer2>
+    in .64bit           <$64(DMA_STATUS)>,                              <%fer0>
+    cmp .64bit          <%fer0>,                                        <$64(1)>
+    je                  <%cb>,                                          <_reading>
+
+    out .64bit          <$64(DMA_MODE)>,                                <$64(0)>
+    out .64bit          <$64(DMA_START_SEC)>,                           <$64(SECTORS)>
+    out .64bit          <$64(DMA_WRITE)>,                               <$64(0)>
+    out .64bit          <$64(HDD_FLUSH)>,                               <$64(0)>
+
+    ; completions are delivered between instructions, wait for both of them
+    mov .64bit          <%fer1>,                                        <_completions>
+_wait:
+    cmp .64bit          <*1&64(%fer1, $8(0), $8(0))>,                   <$64(2)>
+    jne                 <%cb>,                                          <_wait>
+
+    mov .64bit          <%fer0>,                                        <*1&64(%fer1, $8(0), $8(0))>
+    hlt
+
+_completions:
+    .64bit_data < 0 >
+
+_stack_frame:
+    .resvb < 0xFFF >
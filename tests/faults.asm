@@ -0,0 +1,78 @@
+; faults.asm
+;
+; Copyright 2025 Anivice Ives
+;
+; This program is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program.  If not, see <https://www.gnu.org/licenses/>.
+;
+; SPDX-License-Identifier: GPL-3.0-or-later
+;
+
+; Fault heavy guest loop for timing fault delivery, each iteration raises an illegal memory access,
+; an I/O error on a port nobody provides, and a stack overflow.
+; Handlers count the faults they see in memory, since iret restores every register,
+; so every counter reads 100000 once the guest halts
+
+.org 0xC1800
+
+jmp                     <%cb>,                                          <_start>
+
+_illegal_memory_access:
+    mov .64bit          <%fer1>,                                        <_fault_counters>
+    inc .64bit          <*1&64(%fer1, $8(0), $8(0))>
+    iret
+
+_io_error:
+    mov .64bit          <%fer1>,                                        <_fault_counters>
+    inc .64bit          <*1&64(%fer1, $8(8), $8(0))>
+    iret
+
+; CPU state is not preserved for a stack overflow, so restore the stack and go back manually
+_stack_overflow:
+    mov .64bit          <%fer1>,                                        <_fault_counters>
+    inc .64bit          <*1&64(%fer1, $8(16), $8(0))>
+    mov .64bit          <%sp>,                                          <$64(0xFFF)>
+    alwi
+    jmp                 <%cb>,                                          <_resume>
+
+_start:
+    mov .64bit          <%sb>,                                          <_stack_frame>
+    mov .64bit          <%sp>,                                          <$64(0xFFF)>
+
+    mov .64bit          <*1&64($32(0xA0000), $16(16 * 0x02), $8(8))>,   <_io_error>
+    mov .64bit          <*1&64($32(0xA0000), $16(16 * 0x07), $8(8))>,   <_stack_overflow>
+    mov .64bit          <*1&64($32(0xA0000), $16(16 * 0x08), $8(8))>,   <_illegal_memory_access>
+
+    xor .64bit          <%fer0>,                                        <%fer0>
+    mov .64bit          <%fer3>,                                        <$64(100000)>
+
+_loop:
+    mov .64bit          <*1&64($64(0xFFFFFFFFFFFF0000), $8(0), $8(0))>, <%fer0>
+    in .64bit           <$64(0xFFFF)>,                                  <%fer1>
+
+    xor .64bit          <%sp>,                                          <%sp>
+    push .64bit         <%fer0>
+
+_resume:
+    inc .64bit          <%fer0>
+    loop                <%cb>,                                          <_loop>
+
+    hlt
+
+_fault_counters:
+    .64bit_data < 0 >
+    .64bit_data < 0 >
+    .64bit_data < 0 >
+
+_stack_frame:
+    .resvb < 0xFFF >
@@ -0,0 +1,44 @@
+; fusion.asm
+;
+; Copyright 2025 Anivice Ives
+;
+; This program is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program.  If not, see <https://www.gnu.org/licenses/>.
+;
+; SPDX-License-Identifier: GPL-3.0-or-later
+;
+
+; Branch heavy guest loop for timing macro-op fusion, each iteration runs two cmp and
+; conditional jump pairs, an odd or even test taken every other iteration and the loop condition.
+; The loop counts odd numbers below 5000000, so FER2 reads 2500000 once the guest halts. Compare
+;   --bios fusion.bin --boot
+;   --bios fusion.bin --boot --no-fusion
+
+.org 0xC1800
+
+    xor .64bit          <%fer0>,                                        <%fer0>
+    xor .64bit          <%fer2>,                                        <%fer2>
+
+_loop:
+    mov .64bit          <%fer1>,                                        <%fer0>
+    and .64bit          <%fer1>,                                        <$64(1)>
+    cmp .64bit          <%fer1>,                                        <$64(0)>
+    je                  <%cb>,                                          <_even>
+    inc .64bit          <%fer2>
+
+_even:
+    inc .64bit          <%fer0>
+    cmp .64bit          <%fer0>,                                        <$64(5000000)>
+    jl                  <%cb>,                                          <_loop>
+
+    hlt
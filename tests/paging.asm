@@ -0,0 +1,141 @@
+; paging.asm
+;
+; Copyright 2025 Anivice Ives
+;
+; This program is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program.  If not, see <https://www.gnu.org/licenses/>.
+;
+; SPDX-License-Identifier: GPL-3.0-or-later
+;
+
+; Paging guest, identity maps the first 2MB except one page, then touches
+; the unmapped page and a page past the end of the page table once each,
+; and loops over a mapped page so every access after the first is a TLB hit.
+; It then drops to user mode, where IN, OUT and IGNI must each trap as an
+; illegal instruction and POPALL must not set InterruptionMask,
+; and comes back to kernel mode through an interruption.
+; The handlers record the faulting linear addresses and the trap count in memory,
+; since iret restores every register
+
+.org 0xC1800
+
+jmp                     <%cb>,                                          <_start>
+
+_page_fault:
+    mov .64bit          <%fer1>,                                        <_fault_addresses>
+    mov .64bit          <%fer2>,                                        <*1&64(%fer1, $8(0), $8(0))>
+    inc .64bit          <*1&64(%fer1, $8(0), $8(0))>
+    shl .64bit          <%fer2>,                                        <$64(3)>
+    add .64bit          <%fer2>,                                        <%fer1>
+    rdpfa               <*1&64(%fer2, $8(8), $8(0))>
+    iret
+
+_illegal_instruction:
+    mov .64bit          <%fer1>,                                        <_illegal_instructions>
+    inc .64bit          <*1&64(%fer1, $8(0), $8(0))>
+    iret
+
+; iret to the preserved frame with CurrentPrivilegeLevel = 2, ProtectedModeEnabled set and InterruptionMask clear
+_enter_user_mode:
+    mov .64bit          <%fer1>,                                        <%sb>
+    add .64bit          <%fer1>,                                        <%sp>
+    or .64bit           <*1&64(%fer1, $8(128), $8(0))>,                 <$64(0x180)>
+    and .64bit          <*1&64(%fer1, $8(128), $8(0))>,                 <$64(0xFFFFFFFFFFFFFFDF)>
+    iret
+
+; drop the preserved user mode frame and carry on in kernel mode
+_leave_user_mode:
+    add .64bit          <%sp>,                                          <$64(256)>
+    alwi
+    jmp                 <%cb>,                                          <_kernel_mode>
+
+_start:
+    mov .64bit          <%sb>,                                          <_stack_frame>
+    mov .64bit          <%sp>,                                          <$64(0xFFF)>
+
+    mov .64bit          <*1&64($32(0xA0000), $16(16 * 0x0A), $8(8))>,   <_page_fault>
+
+    ; page table at 0x100000, 512 present and writable entries, entry n maps page n
+    xor .64bit          <%fer0>,                                        <%fer0>
+    mov .64bit          <%fer3>,                                        <$64(512)>
+
+_map:
+    mov .64bit          <%fer1>,                                        <%fer0>
+    shl .64bit          <%fer1>,                                        <$64(12)>
+    or .64bit           <%fer1>,                                        <$64(0x03)>
+    mov .64bit          <*8&64(%fer0, $64(0x100000 / 8), $8(0))>,       <%fer1>
+    inc .64bit          <%fer0>
+    loop                <%cb>,                                          <_map>
+
+    ; leave page 0x180 unmapped
+    mov .64bit          <*8&64($64(0x100000 / 8), $16(0x180), $8(0))>,  <$64(0)>
+
+    lpt                 <$64(0x100000)>,                                <$64(512)>
+    enpg
+
+    mov .64bit          <*1&64($64(0x180000), $8(0), $8(0))>,           <$64(1)>
+    mov .64bit          <*1&64($64(0x200000), $8(0), $8(0))>,           <$64(1)>
+
+    mov .64bit          <%fer3>,                                        <$64(100000)>
+
+_loop:
+    add .64bit          <*1&64($64(0x140000), $8(0), $8(0))>,           <%fer3>
+    loop                <%cb>,                                          <_loop>
+
+    dspg
+
+    mov .64bit          <*1&64($32(0xA0000), $16(16 * 0x06), $8(8))>,   <_illegal_instruction>
+    mov .64bit          <*1&64($32(0xA0000), $16(16 * 0x1A), $8(8))>,   <_enter_user_mode>
+    mov .64bit          <*1&64($32(0xA0000), $16(16 * 0x1B), $8(8))>,   <_leave_user_mode>
+
+    int                 <$8(0x1A)>
+    in .64bit           <$64(0x70)>,                                    <%fer0>
+    out .64bit          <$64(0x70)>,                                    <%fer0>
+    igni
+
+    ; POPALL a frame with InterruptionMask set, then record the mask actually in use
+    pushall
+    mov .64bit          <%fer1>,                                        <%sb>
+    add .64bit          <%fer1>,                                        <%sp>
+    or .64bit           <*1&64(%fer1, $8(128), $8(0))>,                 <$64(0x20)>
+    popall
+    pushall
+    mov .64bit          <%fer1>,                                        <%sb>
+    add .64bit          <%fer1>,                                        <%sp>
+    mov .64bit          <%fer2>,                                        <*1&64(%fer1, $8(128), $8(0))>
+    and .64bit          <%fer2>,                                        <$64(0x20)>
+    mov .64bit          <%fer1>,                                        <_user_mode_interruption_mask>
+    mov .64bit          <*1&64(%fer1, $8(0), $8(0))>,                   <%fer2>
+    popall
+
+    int                 <$8(0x1B)>
+
+_kernel_mode:
+    hlt
+
+; fault count, then one linear address per fault
+_fault_addresses:
+    .64bit_data < 0 >
+    .64bit_data < 0 >
+    .64bit_data < 0 >
+
+; user mode instructions trapped, 3 once the test has run
+_illegal_instructions:
+    .64bit_data < 0 >
+
+; InterruptionMask after the user mode POPALL, stays 0
+_user_mode_interruption_mask:
+    .64bit_data < 0 >
+
+_stack_frame:
+    .resvb < 0xFFF >
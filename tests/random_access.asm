@@ -0,0 +1,56 @@
+; random_access.asm
+;
+; Copyright 2025 Anivice Ives
+;
+; This program is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program.  If not, see <https://www.gnu.org/licenses/>.
+;
+; SPDX-License-Identifier: GPL-3.0-or-later
+;
+
+; Random access guest loop, each iteration does a read-modify-write on a
+; pseudo random quad word within a 256MB window starting at 16MB.
+; Addresses come from a xorshift64 generator, so almost every access lands on
+; a different host page. Needs at least 272MB of guest memory.
+; Throughput is the 10000000 read-modify-writes over the run time, compare
+;   --memory 512 --bios random_access.bin --boot
+;   --memory 512 --bios random_access.bin --boot --hugepages
+
+.org 0xC1800
+
+jmp                     <%cb>,                                          <_start>
+
+_start:
+    mov .64bit          <%fer4>,                                        <$64(0x9E3779B97F4A7C15)>
+    mov .64bit          <%fer3>,                                        <$64(10000000)>
+
+_loop:
+    ; xorshift64
+    mov .64bit          <%fer5>,                                        <%fer4>
+    shl .64bit          <%fer5>,                                        <$64(13)>
+    xor .64bit          <%fer4>,                                        <%fer5>
+    mov .64bit          <%fer5>,                                        <%fer4>
+    shr .64bit          <%fer5>,                                        <$64(7)>
+    xor .64bit          <%fer4>,                                        <%fer5>
+    mov .64bit          <%fer5>,                                        <%fer4>
+    shl .64bit          <%fer5>,                                        <$64(17)>
+    xor .64bit          <%fer4>,                                        <%fer5>
+
+    ; aligned offset within the 256MB window
+    mov .64bit          <%fer5>,                                        <%fer4>
+    and .64bit          <%fer5>,                                        <$64(0x0FFFFFF8)>
+    add .64bit          <*1&64(%fer5, $64(0x1000000), $8(0))>,          <%fer4>
+
+    loop                <%cb>,                                          <_loop>
+
+    hlt